@@ -45,13 +45,15 @@ CLS_NAME(rgw)
 #define BI_BUCKET_LOG_INDEX           1
 #define BI_BUCKET_OBJ_INSTANCE_INDEX  2
 #define BI_BUCKET_OLH_DATA_INDEX      3
+#define BI_BUCKET_RESHARD_LOG_INDEX   4
 
-#define BI_BUCKET_LAST_INDEX          4
+#define BI_BUCKET_LAST_INDEX          5
 
 static std::string bucket_index_prefixes[] = { "", /* special handling for the objs list index */
                                           "0_",     /* bucket log index */
                                           "1000_",  /* obj instance index */
                                           "1001_",  /* olh data index */
+                                          "2001_",  /* reshard log index */
 
                                           /* this must be the last index */
                                           "9999_",};
@@ -453,6 +455,52 @@ static int read_bucket_header(cls_method_context_t hctx,
   return 0;
 }
 
+static void reshard_log_key(const string& name, string *key)
+{
+  *key = BI_PREFIX_CHAR;
+  key->append(bucket_index_prefixes[BI_BUCKET_RESHARD_LOG_INDEX]);
+  key->append(name);
+}
+
+/*
+ * while the bucket is resharded online, remember each name whose
+ * entries are modified, so that the reshard copies them again before
+ * it completes
+ */
+static int reshard_log_name(cls_method_context_t hctx,
+                            const rgw_bucket_dir_header& header,
+                            const string& name)
+{
+  if (!header.recording_reshard_log()) {
+    return 0;
+  }
+
+  string key;
+  reshard_log_key(name, &key);
+  bufferlist empty;
+  int rc = cls_cxx_map_set_val(hctx, key, &empty);
+  if (rc < 0) {
+    CLS_LOG(1, "ERROR: %s(): failed to log name=%s rc=%d\n", __func__,
+            name.c_str(), rc);
+  }
+  return rc;
+}
+
+static int reshard_log_clear(cls_method_context_t hctx)
+{
+  string key_begin = {static_cast<char>(BI_PREFIX_CHAR)};
+  key_begin.append(bucket_index_prefixes[BI_BUCKET_RESHARD_LOG_INDEX]);
+  string key_end = {static_cast<char>(BI_PREFIX_CHAR)};
+  key_end.append(bucket_index_prefixes[BI_BUCKET_RESHARD_LOG_INDEX + 1]);
+
+  int rc = cls_cxx_map_remove_range(hctx, key_begin, key_end);
+  if (rc < 0) {
+    CLS_LOG(1, "ERROR: %s(): cls_cxx_map_remove_range failed rc=%d\n",
+            __func__, rc);
+  }
+  return rc;
+}
+
 int rgw_bucket_list(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
 {
   // maximum number of calls to get_obj_vals we'll try; compromise
@@ -941,27 +989,30 @@ static int read_key_entry(cls_method_context_t hctx, cls_rgw_obj_key& key,
   return 0;
 }
 
-int rgw_bucket_complete_op(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
+/*
+ * apply a single completion to the index, updating the in-memory header.
+ * *cancelled is set if the header was left untouched and needn't be
+ * written back
+ */
+static int complete_op(cls_method_context_t hctx, rgw_bucket_dir_header& header,
+                       rgw_cls_obj_complete_op& op, bool *cancelled)
 {
-  // decode request
-  rgw_cls_obj_complete_op op;
-  auto iter = in->cbegin();
-  try {
-    decode(op, iter);
-  } catch (ceph::buffer::error& err) {
-    CLS_LOG(1, "ERROR: rgw_bucket_complete_op(): failed to decode request\n");
-    return -EINVAL;
-  }
   CLS_LOG(1, "rgw_bucket_complete_op(): request: op=%d name=%s instance=%s ver=%lu:%llu tag=%s\n",
           op.op, op.key.name.c_str(), op.key.instance.c_str(),
           (unsigned long)op.ver.pool, (unsigned long long)op.ver.epoch,
           op.tag.c_str());
 
-  rgw_bucket_dir_header header;
-  int rc = read_bucket_header(hctx, &header);
+  *cancelled = false;
+
+  int rc = reshard_log_name(hctx, header, op.key.name);
   if (rc < 0) {
-    CLS_LOG(1, "ERROR: rgw_bucket_complete_op(): failed to read header\n");
-    return -EINVAL;
+    return rc;
+  }
+  for (auto& k : op.remove_objs) {
+    rc = reshard_log_name(hctx, header, k.name);
+    if (rc < 0) {
+      return rc;
+    }
   }
 
   rgw_bucket_dir_entry entry;
@@ -1007,6 +1058,7 @@ int rgw_bucket_complete_op(cls_method_context_t hctx, bufferlist *in, bufferlist
 
   bufferlist op_bl;
   if (cancel) {
+    *cancelled = true;
     if (op.tag.size()) {
       bufferlist new_key_bl;
       encode(entry, new_key_bl);
@@ -1103,6 +1155,97 @@ int rgw_bucket_complete_op(cls_method_context_t hctx, bufferlist *in, bufferlist
     }
   }
 
+  return 0;
+}
+
+int rgw_bucket_complete_op(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
+{
+  // decode request
+  rgw_cls_obj_complete_op op;
+  auto iter = in->cbegin();
+  try {
+    decode(op, iter);
+  } catch (ceph::buffer::error& err) {
+    CLS_LOG(1, "ERROR: rgw_bucket_complete_op(): failed to decode request\n");
+    return -EINVAL;
+  }
+
+  rgw_bucket_dir_header header;
+  int rc = read_bucket_header(hctx, &header);
+  if (rc < 0) {
+    CLS_LOG(1, "ERROR: rgw_bucket_complete_op(): failed to read header\n");
+    return -EINVAL;
+  }
+
+  bool cancelled;
+  rc = complete_op(hctx, header, op, &cancelled);
+  if (rc < 0 || cancelled) {
+    return rc;
+  }
+
+  return write_bucket_header(hctx, &header);
+}
+
+/*
+ * apply a batch of completions with a single header update. the batch
+ * fails as a whole if any of them fails, and the caller is expected to
+ * retry them one at a time
+ */
+int rgw_bucket_complete_ops(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
+{
+  // decode request
+  rgw_cls_obj_complete_ops op;
+  auto iter = in->cbegin();
+  try {
+    decode(op, iter);
+  } catch (ceph::buffer::error& err) {
+    CLS_LOG(1, "ERROR: %s(): failed to decode request\n", __func__);
+    return -EINVAL;
+  }
+
+  /* omap updates of this call aren't visible to its own reads, so the
+   * same name mustn't be touched twice */
+  std::set<string> names;
+  for (auto& o : op.ops) {
+    if (!names.insert(o.key.name).second) {
+      CLS_LOG(1, "ERROR: %s(): duplicate name=%s in batch\n", __func__,
+              o.key.name.c_str());
+      return -EINVAL;
+    }
+    for (auto& k : o.remove_objs) {
+      if (!names.insert(k.name).second) {
+        CLS_LOG(1, "ERROR: %s(): duplicate name=%s in batch\n", __func__,
+                k.name.c_str());
+        return -EINVAL;
+      }
+    }
+  }
+
+  rgw_bucket_dir_header header;
+  int rc = read_bucket_header(hctx, &header);
+  if (rc < 0) {
+    CLS_LOG(1, "ERROR: %s(): failed to read header\n", __func__);
+    return -EINVAL;
+  }
+
+  bool changed = false;
+  for (auto& o : op.ops) {
+    if (changed) {
+      // what write_bucket_header() does between single ops, so that each
+      // gets its own index_ver and bilog key
+      ++header.ver;
+    }
+    bool cancelled;
+    rc = complete_op(hctx, header, o, &cancelled);
+    if (rc < 0) {
+      return rc;
+    }
+    changed |= !cancelled;
+  }
+  if (!changed) {
+    return 0;
+  }
+
   return write_bucket_header(hctx, &header);
 }
 
@@ -2107,6 +2250,10 @@ int rgw_dir_suggest_changes(cls_method_context_t hctx,
 	    (int)cur_change.pending_map.size(), cur_change.exists);
 
     if (cur_disk.pending_map.empty()) {
+      ret = reshard_log_name(hctx, header, cur_change.key.name);
+      if (ret < 0) {
+        return ret;
+      }
       if (cur_disk.exists) {
         rgw_bucket_category_stats& old_stats = header.stats[cur_disk.meta.category];
         CLS_LOG(10, "total_entries: %" PRId64 " -> %" PRId64 "\n", old_stats.num_entries, old_stats.num_entries - 1);
@@ -3981,6 +4128,16 @@ static int rgw_set_bucket_resharding(cls_method_context_t hctx, bufferlist *in,
     return rc;
   }
 
+  /* a new online reshard starts with an empty log, and one that gave up
+   * has no more use for it */
+  if (op.entry.reshard_status == cls_rgw_reshard_status::NOT_RESHARDING ||
+      op.entry.reshard_status == cls_rgw_reshard_status::IN_LOGRECORD) {
+    rc = reshard_log_clear(hctx);
+    if (rc < 0) {
+      return rc;
+    }
+  }
+
   header.new_instance.set_status(op.entry.new_bucket_instance_id, op.entry.num_shards, op.entry.reshard_status);
 
   return write_bucket_header(hctx, &header);
@@ -4006,6 +4163,11 @@ static int rgw_clear_bucket_resharding(cls_method_context_t hctx, bufferlist *in
   }
   header.new_instance.clear();
 
+  rc = reshard_log_clear(hctx);
+  if (rc < 0) {
+    return rc;
+  }
+
   return write_bucket_header(hctx, &header);
 }
 
@@ -4035,6 +4197,77 @@ static int rgw_guard_bucket_resharding(cls_method_context_t hctx, bufferlist *in
   return 0;
 }
 
+/*
+ * the guard for ops that modify the entries of op.log_name. it reads the
+ * header anyway, so it also records the name in the reshard log while an
+ * online reshard is logging, and the index ops themselves don't have to
+ * read the header again for it
+ */
+static int rgw_guard_bucket_resharding_log(cls_method_context_t hctx,
+                                           bufferlist *in, bufferlist *out)
+{
+  cls_rgw_guard_bucket_resharding_op op;
+
+  auto in_iter = in->cbegin();
+  try {
+    decode(op, in_iter);
+  } catch (ceph::buffer::error& err) {
+    CLS_LOG(1, "ERROR: %s(): failed to decode entry\n", __func__);
+    return -EINVAL;
+  }
+
+  rgw_bucket_dir_header header;
+  int rc = read_bucket_header(hctx, &header);
+  if (rc < 0) {
+    CLS_LOG(1, "ERROR: %s(): failed to read header\n", __func__);
+    return rc;
+  }
+
+  if (header.resharding()) {
+    return op.ret_err;
+  }
+
+  return reshard_log_name(hctx, header, op.log_name);
+}
+
+static int rgw_reshard_log_list(cls_method_context_t hctx,
+				bufferlist *in, bufferlist *out)
+{
+  cls_rgw_reshard_log_list_op op;
+
+  auto in_iter = in->cbegin();
+  try {
+    decode(op, in_iter);
+  } catch (ceph::buffer::error& err) {
+    CLS_LOG(1, "ERROR: %s(): failed to decode entry\n", __func__);
+    return -EINVAL;
+  }
+
+  string prefix;
+  reshard_log_key(string(), &prefix);
+  string start_after = prefix + op.marker;
+
+#define MAX_RESHARD_LOG_LIST_ENTRIES 1000
+  uint32_t max = std::min<uint32_t>(op.max, MAX_RESHARD_LOG_LIST_ENTRIES);
+
+  cls_rgw_reshard_log_list_ret op_ret;
+  map<string, bufferlist> keys;
+  int rc = cls_cxx_map_get_vals(hctx, start_after, prefix, max, &keys,
+				&op_ret.is_truncated);
+  if (rc < 0) {
+    return rc;
+  }
+
+  op_ret.names.reserve(keys.size());
+  for (auto& k : keys) {
+    op_ret.names.push_back(k.first.substr(prefix.size()));
+  }
+
+  encode(op_ret, *out);
+
+  return 0;
+}
+
 static int rgw_get_bucket_resharding(cls_method_context_t hctx,
 				     bufferlist *in, bufferlist *out)
 {
@@ -4076,6 +4309,7 @@ CLS_INIT(rgw)
   cls_method_handle_t h_rgw_bucket_update_stats;
   cls_method_handle_t h_rgw_bucket_prepare_op;
   cls_method_handle_t h_rgw_bucket_complete_op;
+  cls_method_handle_t h_rgw_bucket_complete_ops;
   cls_method_handle_t h_rgw_bucket_link_olh;
   cls_method_handle_t h_rgw_bucket_unlink_instance_op;
   cls_method_handle_t h_rgw_bucket_read_olh_log;
@@ -4113,7 +4347,9 @@ CLS_INIT(rgw)
   cls_method_handle_t h_rgw_set_bucket_resharding;
   cls_method_handle_t h_rgw_clear_bucket_resharding;
   cls_method_handle_t h_rgw_guard_bucket_resharding;
+  cls_method_handle_t h_rgw_guard_bucket_resharding_log;
   cls_method_handle_t h_rgw_get_bucket_resharding;
+  cls_method_handle_t h_rgw_reshard_log_list;
 
   cls_register(RGW_CLASS, &h_class);
 
@@ -4126,6 +4362,7 @@ CLS_INIT(rgw)
   cls_register_cxx_method(h_class, RGW_BUCKET_UPDATE_STATS, CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_update_stats, &h_rgw_bucket_update_stats);
   cls_register_cxx_method(h_class, RGW_BUCKET_PREPARE_OP, CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_prepare_op, &h_rgw_bucket_prepare_op);
   cls_register_cxx_method(h_class, RGW_BUCKET_COMPLETE_OP, CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_complete_op, &h_rgw_bucket_complete_op);
+  cls_register_cxx_method(h_class, RGW_BUCKET_COMPLETE_OPS, CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_complete_ops, &h_rgw_bucket_complete_ops);
   cls_register_cxx_method(h_class, RGW_BUCKET_LINK_OLH, CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_link_olh, &h_rgw_bucket_link_olh);
   cls_register_cxx_method(h_class, RGW_BUCKET_UNLINK_INSTANCE, CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_unlink_instance, &h_rgw_bucket_unlink_instance_op);
   cls_register_cxx_method(h_class, RGW_BUCKET_READ_OLH_LOG, CLS_METHOD_RD, rgw_bucket_read_olh_log, &h_rgw_bucket_read_olh_log);
@@ -4182,8 +4419,12 @@ CLS_INIT(rgw)
 			  rgw_clear_bucket_resharding, &h_rgw_clear_bucket_resharding);
   cls_register_cxx_method(h_class, RGW_GUARD_BUCKET_RESHARDING, CLS_METHOD_RD ,
 			  rgw_guard_bucket_resharding, &h_rgw_guard_bucket_resharding);
+  cls_register_cxx_method(h_class, RGW_GUARD_BUCKET_RESHARDING_LOG, CLS_METHOD_RD | CLS_METHOD_WR,
+			  rgw_guard_bucket_resharding_log, &h_rgw_guard_bucket_resharding_log);
   cls_register_cxx_method(h_class, RGW_GET_BUCKET_RESHARDING, CLS_METHOD_RD ,
 			  rgw_get_bucket_resharding, &h_rgw_get_bucket_resharding);
+  cls_register_cxx_method(h_class, RGW_RESHARD_LOG_LIST, CLS_METHOD_RD,
+			  rgw_reshard_log_list, &h_rgw_reshard_log_list);
 
   return;
 }
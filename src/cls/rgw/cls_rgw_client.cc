@@ -215,6 +215,16 @@ void cls_rgw_bucket_complete_op(ObjectWriteOperation& o, RGWModifyOp op, string&
   o.exec(RGW_CLASS, RGW_BUCKET_COMPLETE_OP, in);
 }
 
+void cls_rgw_bucket_complete_ops(ObjectWriteOperation& o,
+                                 vector<rgw_cls_obj_complete_op>&& ops)
+{
+  bufferlist in;
+  rgw_cls_obj_complete_ops call;
+  call.ops = std::move(ops);
+  encode(call, in);
+  o.exec(RGW_CLASS, RGW_BUCKET_COMPLETE_OPS, in);
+}
+
 void cls_rgw_bucket_list_op(librados::ObjectReadOperation& op,
                             const cls_rgw_obj_key& start_obj,
                             const std::string& filter_prefix,
@@ -1060,6 +1070,33 @@ int cls_rgw_get_bucket_resharding(librados::IoCtx& io_ctx, const string& oid,
   return 0;
 }
 
+int cls_rgw_reshard_log_list(librados::IoCtx& io_ctx, const string& oid,
+                             const string& marker, uint32_t max,
+                             vector<string> *names, bool *is_truncated)
+{
+  bufferlist in, out;
+  cls_rgw_reshard_log_list_op call;
+  call.marker = marker;
+  call.max = max;
+  encode(call, in);
+  int r = io_ctx.exec(oid, RGW_CLASS, RGW_RESHARD_LOG_LIST, in, out);
+  if (r < 0)
+    return r;
+
+  cls_rgw_reshard_log_list_ret op_ret;
+  auto iter = out.cbegin();
+  try {
+    decode(op_ret, iter);
+  } catch (ceph::buffer::error& err) {
+    return -EIO;
+  }
+
+  names->swap(op_ret.names);
+  *is_truncated = op_ret.is_truncated;
+
+  return 0;
+}
+
 void cls_rgw_guard_bucket_resharding(librados::ObjectOperation& op, int ret_err)
 {
   bufferlist in, out;
@@ -1069,6 +1106,17 @@ void cls_rgw_guard_bucket_resharding(librados::ObjectOperation& op, int ret_err)
   op.exec(RGW_CLASS, RGW_GUARD_BUCKET_RESHARDING, in);
 }
 
+void cls_rgw_guard_bucket_resharding(librados::ObjectWriteOperation& op, int ret_err,
+                                     const string& log_name)
+{
+  bufferlist in;
+  cls_rgw_guard_bucket_resharding_op call;
+  call.ret_err = ret_err;
+  call.log_name = log_name;
+  encode(call, in);
+  op.exec(RGW_CLASS, RGW_GUARD_BUCKET_RESHARDING_LOG, in);
+}
+
 static bool issue_set_bucket_resharding(librados::IoCtx& io_ctx, const string& oid,
                                         const cls_rgw_bucket_instance_entry& entry,
                                         BucketIndexAioManager *manager) {
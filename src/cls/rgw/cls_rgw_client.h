@@ -369,6 +369,11 @@ void cls_rgw_bucket_complete_op(librados::ObjectWriteOperation& o, RGWModifyOp o
 				std::list<cls_rgw_obj_key> *remove_objs, bool log_op,
                                 uint16_t bilog_op, rgw_zone_set *zones_trace);
 
+/* several completions for the same bucket index shard in one call; old
+ * OSDs fail it with -EOPNOTSUPP */
+void cls_rgw_bucket_complete_ops(librados::ObjectWriteOperation& o,
+                                 std::vector<rgw_cls_obj_complete_op>&& ops);
+
 void cls_rgw_remove_obj(librados::ObjectWriteOperation& o, std::list<std::string>& keep_attr_prefixes);
 void cls_rgw_obj_store_pg_ver(librados::ObjectWriteOperation& o, const std::string& attr);
 void cls_rgw_obj_check_attrs_prefix(librados::ObjectOperation& o, const std::string& prefix, bool fail_if_exist);
@@ -631,6 +636,10 @@ int cls_rgw_reshard_get(librados::IoCtx& io_ctx, const std::string& oid, cls_rgw
 
 /* resharding attribute on bucket index shard headers */
 void cls_rgw_guard_bucket_resharding(librados::ObjectOperation& op, int ret_err);
+/* the same guard for ops that modify the entries of the given name; it
+ * also records the name while an online reshard logs the changed names */
+void cls_rgw_guard_bucket_resharding(librados::ObjectWriteOperation& op, int ret_err,
+                                     const std::string& log_name);
 // these overloads which call io_ctx.operate() should not be called in the rgw.
 // rgw_rados_operate() should be called after the overloads w/o calls to io_ctx.operate()
 #ifndef CLS_CLIENT_HIDE_IOCTX
@@ -639,6 +648,10 @@ int cls_rgw_set_bucket_resharding(librados::IoCtx& io_ctx, const std::string& oi
 int cls_rgw_clear_bucket_resharding(librados::IoCtx& io_ctx, const std::string& oid);
 int cls_rgw_get_bucket_resharding(librados::IoCtx& io_ctx, const std::string& oid,
                                   cls_rgw_bucket_instance_entry *entry);
+/* names whose entries changed while the shard was resharded online */
+int cls_rgw_reshard_log_list(librados::IoCtx& io_ctx, const std::string& oid,
+                             const std::string& marker, uint32_t max,
+                             std::vector<std::string> *names, bool *is_truncated);
 #endif
 
 #endif
@@ -157,6 +157,30 @@ void rgw_cls_obj_complete_op::dump(Formatter *f) const
   encode_json("zones_trace", zones_trace, f);
 }
 
+void rgw_cls_obj_complete_ops::generate_test_instances(list<rgw_cls_obj_complete_ops*>& o)
+{
+  list<rgw_cls_obj_complete_op*> l;
+  rgw_cls_obj_complete_op::generate_test_instances(l);
+  rgw_cls_obj_complete_ops *op = new rgw_cls_obj_complete_ops;
+  for (auto i : l) {
+    op->ops.push_back(*i);
+    delete i;
+  }
+  o.push_back(op);
+  o.push_back(new rgw_cls_obj_complete_ops);
+}
+
+void rgw_cls_obj_complete_ops::dump(Formatter *f) const
+{
+  f->open_array_section("ops");
+  for (auto& op : ops) {
+    f->open_object_section("op");
+    op.dump(f);
+    f->close_section();
+  }
+  f->close_section();
+}
+
 void rgw_cls_link_olh_op::generate_test_instances(list<rgw_cls_link_olh_op*>& o)
 {
   rgw_cls_link_olh_op *op = new rgw_cls_link_olh_op;
@@ -527,11 +551,14 @@ void cls_rgw_guard_bucket_resharding_op::generate_test_instances(
 {
   ls.push_back(new cls_rgw_guard_bucket_resharding_op);
   ls.push_back(new cls_rgw_guard_bucket_resharding_op);
+  ls.back()->ret_err = -EBUSY;
+  ls.back()->log_name = "name";
 }
 
 void cls_rgw_guard_bucket_resharding_op::dump(Formatter *f) const
 {
   encode_json("ret_err", ret_err, f);
+  encode_json("log_name", log_name, f);
 }
 
 
@@ -545,3 +572,33 @@ void cls_rgw_get_bucket_resharding_op::generate_test_instances(
 void cls_rgw_get_bucket_resharding_op::dump(Formatter *f) const
 {
 }
+
+void cls_rgw_reshard_log_list_op::generate_test_instances(
+  list<cls_rgw_reshard_log_list_op*>& ls)
+{
+  ls.push_back(new cls_rgw_reshard_log_list_op);
+  ls.push_back(new cls_rgw_reshard_log_list_op);
+  ls.back()->marker = "foo";
+  ls.back()->max = 100;
+}
+
+void cls_rgw_reshard_log_list_op::dump(Formatter *f) const
+{
+  encode_json("marker", marker, f);
+  encode_json("max", max, f);
+}
+
+void cls_rgw_reshard_log_list_ret::generate_test_instances(
+  list<cls_rgw_reshard_log_list_ret*>& ls)
+{
+  ls.push_back(new cls_rgw_reshard_log_list_ret);
+  ls.push_back(new cls_rgw_reshard_log_list_ret);
+  ls.back()->names = {"foo", "bar"};
+  ls.back()->is_truncated = true;
+}
+
+void cls_rgw_reshard_log_list_ret::dump(Formatter *f) const
+{
+  encode_json("names", names, f);
+  encode_json("is_truncated", is_truncated, f);
+}
@@ -721,7 +721,8 @@ WRITE_CLASS_ENCODER(rgw_bucket_category_stats)
 enum class cls_rgw_reshard_status : uint8_t {
   NOT_RESHARDING  = 0,
   IN_PROGRESS     = 1,
-  DONE            = 2
+  DONE            = 2,
+  IN_LOGRECORD    = 3,
 };
 
 inline std::string to_string(const cls_rgw_reshard_status status)
@@ -733,6 +734,8 @@ inline std::string to_string(const cls_rgw_reshard_status status)
     return "in-progress";
   case cls_rgw_reshard_status::DONE:
     return "done";
+  case cls_rgw_reshard_status::IN_LOGRECORD:
+    return "in-logrecord";
   };
   return "Unknown reshard status";
 }
@@ -778,12 +781,18 @@ struct cls_rgw_bucket_instance_entry {
     num_shards = new_num_shards;
   }
 
+  /* while the index is copied online (IN_LOGRECORD) writes go on, and
+   * the names they touch are recorded for the final catch-up pass */
   bool resharding() const {
-    return reshard_status != RESHARD_STATUS::NOT_RESHARDING;
+    return reshard_status != RESHARD_STATUS::NOT_RESHARDING &&
+      reshard_status != RESHARD_STATUS::IN_LOGRECORD;
   }
   bool resharding_in_progress() const {
     return reshard_status == RESHARD_STATUS::IN_PROGRESS;
   }
+  bool recording_reshard_log() const {
+    return reshard_status == RESHARD_STATUS::IN_LOGRECORD;
+  }
 };
 WRITE_CLASS_ENCODER(cls_rgw_bucket_instance_entry)
 
@@ -845,6 +854,9 @@ struct rgw_bucket_dir_header {
   bool resharding_in_progress() const {
     return new_instance.resharding_in_progress();
   }
+  bool recording_reshard_log() const {
+    return new_instance.recording_reshard_log();
+  }
 };
 WRITE_CLASS_ENCODER(rgw_bucket_dir_header)
 
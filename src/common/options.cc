@@ -5548,6 +5548,16 @@ std::vector<Option> get_rgw_options() {
     .set_default(1000)
     .set_description("Max number of objects in a single multi-object delete request"),
 
+    Option("rgw_multi_obj_del_max_aio", Option::TYPE_INT, Option::LEVEL_ADVANCED)
+    .set_default(16)
+    .set_min(1)
+    .set_description("Max number of objects deleted at once by a multi-object delete request")
+    .set_long_description(
+        "The objects of a multi-object delete request are deleted concurrently, on "
+        "coroutines of the request. Their index completions can then be batched per "
+        "bucket index shard (see rgw_bucket_index_batch_window_ms). Only applies to "
+        "frontends that run requests on coroutines, like beast."),
+
     Option("rgw_website_routing_rules_max_num", Option::TYPE_INT, Option::LEVEL_ADVANCED)
     .set_default(50)
     .set_description("Max number of website routing rules in a single request"),
@@ -5621,6 +5631,26 @@ std::vector<Option> get_rgw_options() {
     .set_default(128)
     .set_description("Max number of concurrent RADOS requests when handling bucket shards."),
 
+    Option("rgw_bucket_index_batch_window_ms", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .set_flag(Option::FLAG_STARTUP)
+    .add_tag("performance")
+    .set_description("Time window for batching bucket index completions")
+    .set_long_description(
+        "When nonzero, the completions of object writes headed to the same bucket "
+        "index shard are collected for up to this many milliseconds and sent in a "
+        "single request. This reduces the load on the index OSDs under bursts of "
+        "small writes, at the cost of new entries showing up in bucket listings "
+        "that much later.")
+    .add_see_also("rgw_bucket_index_batch_max_ops"),
+
+    Option("rgw_bucket_index_batch_max_ops", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(32)
+    .set_min(1)
+    .set_flag(Option::FLAG_STARTUP)
+    .set_description("Max number of bucket index completions sent in one batch")
+    .add_see_also("rgw_bucket_index_batch_window_ms"),
+
     Option("rgw_enable_quota_threads", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
     .set_default(true)
     .set_description("Enables the quota maintenance thread.")
@@ -5764,6 +5794,16 @@ std::vector<Option> get_rgw_options() {
       "Number of threads in per-LCWorker workpools--used to accelerate "
       "per-bucket processing"),
 
+    Option("rgw_lc_max_shard_lister", Option::TYPE_INT, Option::LEVEL_ADVANCED)
+    .set_default(4)
+    .set_description("Number of bucket index shards listed in parallel per LCWorker")
+    .set_long_description(
+      "Each LCWorker lists the index shards of a bucket separately, this "
+      "many at a time, and feeds the entries of all of them to its "
+      "workpool. The listing marker of every shard is checkpointed so "
+      "that an interrupted pass over a bucket resumes where it stopped.")
+    .add_see_also("rgw_lc_max_wp_worker"),
+
     Option("rgw_lc_max_objs", Option::TYPE_INT, Option::LEVEL_ADVANCED)
     .set_default(32)
     .set_description("Number of lifecycle data shards")
@@ -6307,6 +6347,23 @@ std::vector<Option> get_rgw_options() {
        "If set, RGW will store ops log information in RADOS.")
     .add_see_also({"rgw_enable_ops_log"}),
 
+    Option("rgw_ops_log_flush_interval_ms", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(100)
+    .set_description("Interval between batched writes of the ops log to rados")
+    .set_long_description(
+        "Ops log entries headed to the same rados object are queued and appended "
+        "together at this interval, by a thread of their own. With 0, every entry is "
+        "appended on its own by the request. Read on startup.")
+    .add_see_also({"rgw_ops_log_rados", "rgw_ops_log_max_queued"}),
+
+    Option("rgw_ops_log_max_queued", Option::TYPE_SIZE, Option::LEVEL_ADVANCED)
+    .set_default(64_M)
+    .set_description("Max bytes of ops log entries queued for batched writes")
+    .set_long_description(
+        "Entries beyond this are dropped, and counted by the ops_log_dropped perf "
+        "counter.")
+    .add_see_also({"rgw_ops_log_flush_interval_ms"}),
+
     Option("rgw_ops_log_socket_path", Option::TYPE_STR, Option::LEVEL_ADVANCED)
     .set_default("")
     .set_description("Unix domain socket path for ops log.")
@@ -6412,9 +6469,20 @@ std::vector<Option> get_rgw_options() {
     .set_description("Max concurrent RADOS IO operations for garbage collection")
     .set_long_description(
         "The maximum number of concurrent IO operations that the RGW garbage collection "
-        "thread will use when purging old data.")
+        "thread will use when purging old data. Each tail object removal in a batch "
+        "counts as one operation.")
     .add_see_also({"rgw_gc_max_objs", "rgw_gc_obj_min_wait", "rgw_gc_processor_max_time", "rgw_gc_max_trim_chunk"}),
 
+    Option("rgw_gc_batch_size", Option::TYPE_INT, Option::LEVEL_ADVANCED)
+    .set_default(5)
+    .set_description("Number of tail objects removed in a single RADOS IO operation by garbage collection")
+    .set_long_description(
+        "Garbage collection sends the removals of tail objects in the same pool "
+        "to RADOS in batches of this size. Each removal in a batch counts as one "
+        "operation against rgw_gc_max_concurrent_io, and a batch is never larger "
+        "than that limit. 1 sends every removal on its own.")
+    .add_see_also({"rgw_gc_max_concurrent_io"}),
+
     Option("rgw_gc_max_trim_chunk", Option::TYPE_INT, Option::LEVEL_ADVANCED)
     .set_default(16)
     .set_description("Max number of keys to remove from garbage collector log in a single operation")
@@ -6474,9 +6542,32 @@ std::vector<Option> get_rgw_options() {
     .set_long_description("Number of seconds to wait for a process before exiting unconditionally."),
 
     Option("rgw_get_obj_window_size", Option::TYPE_SIZE, Option::LEVEL_ADVANCED)
-    .set_default(16_M)
+    .set_default(64_M)
     .set_description("RGW object read window size")
-    .set_long_description("The window size in bytes for a single object read request"),
+    .set_long_description("The maximum window size in bytes for a single object "
+        "read request. The window starts at rgw_get_obj_min_window_size and "
+        "grows up to this size while the client drains it faster than RADOS "
+        "reads fill it.")
+    .add_see_also({"rgw_get_obj_min_window_size", "rgw_get_obj_window_total"}),
+
+    Option("rgw_get_obj_min_window_size", Option::TYPE_SIZE, Option::LEVEL_ADVANCED)
+    .set_default(16_M)
+    .set_description("RGW object read minimum window size")
+    .set_long_description("The initial and minimum window size in bytes for a "
+        "single object read request. The window shrinks back to this size for "
+        "clients that drain it slower than RADOS reads fill it. Set it to "
+        "rgw_get_obj_window_size for a fixed window. Keep it a multiple of "
+        "rgw_get_obj_max_req_size, or reads stop overlapping: a window of a "
+        "single request leaves only one RADOS read in flight.")
+    .add_see_also({"rgw_get_obj_window_size", "rgw_get_obj_max_req_size"}),
+
+    Option("rgw_get_obj_window_total", Option::TYPE_SIZE, Option::LEVEL_ADVANCED)
+    .set_default(4_G)
+    .set_description("Total size of all object read windows")
+    .set_long_description("Object read windows only grow past "
+        "rgw_get_obj_min_window_size while the windows of all reads in the "
+        "gateway stay within this many bytes. 0 means no limit.")
+    .add_see_also("rgw_get_obj_window_size"),
 
     Option("rgw_get_obj_max_req_size", Option::TYPE_SIZE, Option::LEVEL_ADVANCED)
     .set_default(4_M)
@@ -6690,6 +6781,15 @@ std::vector<Option> get_rgw_options() {
     .set_default(10000)
     .set_description("Max number of parts in multipart upload"),
 
+    Option("rgw_multipart_complete_window", Option::TYPE_INT, Option::LEVEL_ADVANCED)
+    .set_default(8)
+    .set_min(1)
+    .set_description("Pages of parts read at once to complete a multipart upload")
+    .set_long_description(
+        "CompleteMultipartUpload reads the parts of the upload from the omap of its "
+        "meta object in pages of 1000 parts. This many pages are read at once, so that "
+        "completing an upload of many parts takes about one round trip."),
+
     Option("rgw_max_slo_entries", Option::TYPE_INT, Option::LEVEL_ADVANCED)
     .set_default(1000)
     .set_description("Max number of entries in Swift Static Large Object manifest"),
@@ -6767,6 +6867,30 @@ std::vector<Option> get_rgw_options() {
     .set_default(true)
     .set_description("Should run sync thread"),
 
+    Option("rgw_data_sync_threads", Option::TYPE_INT, Option::LEVEL_ADVANCED)
+    .set_default(1)
+    .set_min(1)
+    .set_description("Number of threads running data sync from each source zone")
+    .set_long_description(
+        "Data sync from a zone runs its coroutines on a single thread by default. "
+        "With more threads, the data log shards are spread over them, and each shard "
+        "with all of its bucket syncs stays on the same thread. Only the default, "
+        "archive and log sync modules support this; other sync modules always use "
+        "a single thread. The coroutine stacks of each thread, their run queue depth "
+        "and CPU time can be seen with the 'cr dump' admin socket command."),
+
+    Option("rgw_bucket_sync_spawn_window", Option::TYPE_INT, Option::LEVEL_ADVANCED)
+    .set_default(20)
+    .set_min(1)
+    .set_description("Number of objects synced concurrently per bucket shard")
+    .set_long_description(
+        "The maximum number of objects that full and incremental sync of a single "
+        "bucket shard fetches from the source zone at the same time. Full sync also "
+        "lists the next page of the remote bucket while the current page is fetched. "
+        "Each fetch occupies one of the rgw_num_async_rados_threads threads while it "
+        "runs, so raise both to speed up the initial sync of large buckets.")
+    .add_see_also("rgw_num_async_rados_threads"),
+
     Option("rgw_sync_lease_period", Option::TYPE_INT, Option::LEVEL_DEV)
     .set_default(120)
     .set_description(""),
@@ -6899,6 +7023,29 @@ std::vector<Option> get_rgw_options() {
     .add_tag("performance")
     .add_service("rgw"),
 
+    Option("rgw_reshard_online", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_description("Keep accepting writes while a bucket index is resharded")
+    .set_long_description(
+        "Bucket index shards record the names of the entries written while "
+        "they are copied to the new shards. Writes are then blocked only "
+        "for a final pass that copies those entries again, instead of for "
+        "the whole copy. Requires OSDs that support it; otherwise writes "
+        "are blocked as before.")
+    .add_tag("performance")
+    .add_service("rgw")
+    .add_see_also("rgw_reshard_online_delay_ms"),
+
+    Option("rgw_reshard_online_delay_ms", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .set_description("Milliseconds to pause between batches of entries copied by an online reshard")
+    .set_long_description(
+        "Paces the copy of an online reshard so that it competes less with "
+        "client writes to the bucket index. 0 copies without pausing.")
+    .add_tag("performance")
+    .add_service("rgw")
+    .add_see_also("rgw_reshard_online"),
+
     Option("rgw_trust_forwarded_https", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
     .set_default(false)
     .set_description("Trust Forwarded and X-Forwarded-Proto headers")
@@ -7089,6 +7236,111 @@ std::vector<Option> get_rgw_options() {
 			  "of RGW instances under heavy use. If you would like "
 			  "to turn off cache expiry, set this value to zero."),
 
+    Option("rgw_obj_head_cache_size", Option::TYPE_UINT,
+	   Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .add_tag("performance")
+    .add_service("rgw")
+    .set_description("Max number of user object heads to keep in the "
+		     "object head cache; zero disables the cache")
+    .set_long_description("The object head cache keeps the stat, xattrs "
+			  "(manifest, ACL, etag) and small inline data of "
+			  "user objects so GET and HEAD requests on hot "
+			  "objects do not have to read the head object from "
+			  "RADOS. Entries are invalidated across gateways "
+			  "through the same watch/notify channel as the "
+			  "metadata cache, which adds a notify to every "
+			  "object write and delete while the cache is enabled.")
+    .add_see_also({"rgw_obj_head_cache_shards",
+		   "rgw_obj_head_cache_expiry_interval",
+		   "rgw_obj_head_cache_max_data"}),
+
+    Option("rgw_obj_head_cache_shards", Option::TYPE_UINT,
+	   Option::LEVEL_ADVANCED)
+    .set_default(16)
+    .set_min(1)
+    .add_service("rgw")
+    .set_description("Number of independently locked shards in the object "
+		     "head cache"),
+
+    Option("rgw_obj_head_cache_expiry_interval", Option::TYPE_UINT,
+	   Option::LEVEL_ADVANCED)
+    .set_default(60)
+    .add_service("rgw")
+    .set_description("Number of seconds before entries in the object head "
+		     "cache are assumed stale and re-fetched. Zero is never.")
+    .set_long_description("Bounds how long a gateway can serve a stale "
+			  "object head if an invalidation notify is lost."),
+
+    Option("rgw_obj_head_cache_max_data", Option::TYPE_SIZE,
+	   Option::LEVEL_ADVANCED)
+    .set_default(64_K)
+    .add_service("rgw")
+    .set_description("Largest head object data that is kept in the object "
+		     "head cache along with its metadata")
+    .set_long_description("Heads with more data are cached without it. Reads "
+			  "of those objects still use the cached metadata, and "
+			  "fetch the data from the head object."),
+
+    Option("rgw_datacache_enabled", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .add_tag("performance")
+    .add_service("rgw")
+    .set_description("Cache object data read from tail objects on local "
+		     "storage")
+    .set_long_description("Chunks of object data read from rados tail "
+			  "objects are kept as files under "
+			  "rgw_datacache_path, typically on NVMe or tmpfs, and "
+			  "later GETs of the same chunks are served from "
+			  "there. Head object data is never cached.")
+    .add_see_also({"rgw_datacache_path", "rgw_datacache_size",
+		   "rgw_datacache_threads"}),
+
+    Option("rgw_datacache_path", Option::TYPE_STR, Option::LEVEL_ADVANCED)
+    .set_default("/var/lib/ceph/radosgw/$cluster-$id/datacache")
+    .add_service("rgw")
+    .set_description("Directory for the data cache; its contents are "
+		     "removed when rgw starts")
+    .set_long_description("Each gateway needs a directory of its own; gateways "
+			  "sharing one would remove each other's chunks."),
+
+    Option("rgw_datacache_size", Option::TYPE_SIZE, Option::LEVEL_ADVANCED)
+    .set_default(1_G)
+    .add_service("rgw")
+    .set_description("Max number of bytes kept in the data cache"),
+
+    Option("rgw_datacache_threads", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(4)
+    .set_min(1)
+    .add_service("rgw")
+    .set_description("Number of threads doing data cache file I/O"),
+
+    Option("rgw_put_obj_offload_threads", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .add_service("rgw")
+    .add_tag("performance")
+    .set_flag(Option::FLAG_STARTUP)
+    .set_description("Number of threads compressing and encrypting uploaded data")
+    .set_long_description(
+        "When nonzero, compression and encryption of object data after "
+        "the first chunk run on a pool of this many threads shared by all "
+        "uploads, overlapping with the MD5 of the next chunk on the request "
+        "thread. Compressed objects are also decompressed on this pool, "
+        "while the next blocks are read. With 0 they run inline on the "
+        "request thread."),
+
+    Option("rgw_compression_block_size", Option::TYPE_SIZE, Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .add_service("rgw")
+    .add_tag("performance")
+    .set_description("Size of the blocks uploaded data is compressed in")
+    .set_long_description(
+        "Uploaded data is compressed in blocks of this size, each of which is "
+        "decompressed on its own. Smaller blocks mean less data to decompress "
+        "for ranged reads, and more blocks to decompress in parallel, at the "
+        "cost of a lower compression ratio. With 0, each chunk of "
+        "rgw_max_chunk_size is a block."),
+
     Option("rgw_inject_notify_timeout_probability", Option::TYPE_FLOAT,
 	   Option::LEVEL_DEV)
     .set_default(0)
@@ -7254,6 +7506,93 @@ std::vector<Option> get_rgw_options() {
     .add_see_also("rgw_dmclock_metadata_res")
     .add_see_also("rgw_dmclock_metadata_wgt"),
 
+    Option("rgw_dmclock_tenant_qos", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_description("Queue authenticated requests by user and bucket")
+    .set_long_description(
+        "When enabled, the beast frontend queues each request by its user and "
+        "then by its bucket once it is authenticated, so that one tenant can "
+        "only delay its own requests. Requests over a tenant's limits are "
+        "rejected with SlowDown.")
+    .add_see_also("rgw_dmclock_tenant_tags")
+    .add_see_also("rgw_dmclock_tenant_max_requests")
+    .add_see_also("rgw_dmclock_tenant_share_interval"),
+
+    Option("rgw_dmclock_tenant_max_requests", Option::TYPE_INT, Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .set_description("Concurrent requests beyond which tenants are served by their tags")
+    .set_long_description(
+        "Below this many requests in progress, requests of tenants within "
+        "their limits are served at once. Above it, they are served by "
+        "reservation, then weight. 0 uses rgw_max_concurrent_requests.")
+    .add_see_also("rgw_dmclock_tenant_qos"),
+
+    Option("rgw_dmclock_user_res", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
+    .set_default(0.0)
+    .set_description("mclock reservation in ops/s for each user")
+    .add_see_also("rgw_dmclock_tenant_qos"),
+
+    Option("rgw_dmclock_user_wgt", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
+    .set_default(1.0)
+    .set_description("mclock weight for each user")
+    .add_see_also("rgw_dmclock_tenant_qos"),
+
+    Option("rgw_dmclock_user_lim", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
+    .set_default(0.0)
+    .set_description("mclock limit in ops/s for each user, 0 for none")
+    .add_see_also("rgw_dmclock_tenant_qos"),
+
+    Option("rgw_dmclock_user_bytes_lim", Option::TYPE_SIZE, Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .set_description("Limit in bytes/s for each user, 0 for none")
+    .set_long_description(
+        "Bytes sent and received are charged when a request completes. A user "
+        "that went over the limit has its requests rejected until it is back "
+        "under it.")
+    .add_see_also("rgw_dmclock_tenant_qos"),
+
+    Option("rgw_dmclock_bucket_res", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
+    .set_default(0.0)
+    .set_description("mclock reservation in ops/s for each bucket")
+    .add_see_also("rgw_dmclock_tenant_qos"),
+
+    Option("rgw_dmclock_bucket_wgt", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
+    .set_default(1.0)
+    .set_description("mclock weight for each bucket")
+    .add_see_also("rgw_dmclock_tenant_qos"),
+
+    Option("rgw_dmclock_bucket_lim", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
+    .set_default(0.0)
+    .set_description("mclock limit in ops/s for each bucket, 0 for none")
+    .add_see_also("rgw_dmclock_tenant_qos"),
+
+    Option("rgw_dmclock_bucket_bytes_lim", Option::TYPE_SIZE, Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .set_description("Limit in bytes/s for each bucket, 0 for none")
+    .add_see_also("rgw_dmclock_user_bytes_lim"),
+
+    Option("rgw_dmclock_tenant_tags", Option::TYPE_STR, Option::LEVEL_ADVANCED)
+    .set_default("")
+    .set_description("QoS tags of specific users and buckets")
+    .set_long_description(
+        "A space separated list of entries of the form "
+        "<user|bucket>:<name>=<res>,<wgt>,<lim>[,<bytes_lim>], such as "
+        "'user:tenant$alice=10,2,100 bucket:tenant/logs=0,1,50,10485760'. "
+        "Users and buckets not listed get the rgw_dmclock_user_* and "
+        "rgw_dmclock_bucket_* tags.")
+    .add_see_also("rgw_dmclock_tenant_qos"),
+
+    Option("rgw_dmclock_tenant_share_interval", Option::TYPE_INT, Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .set_min(0)
+    .set_description("Seconds between exchanges of tenant usage with the other gateways, 0 to disable")
+    .set_long_description(
+        "When set, the gateways of a zone periodically share the usage of "
+        "limited tenants through an object in the log pool, and each gateway "
+        "enforces what the others left of a limit, so that limits apply to "
+        "the whole fleet rather than to each gateway.")
+    .add_see_also("rgw_dmclock_tenant_qos"),
+
    Option("rgw_data_log_backing", Option::TYPE_STR, Option::LEVEL_ADVANCED)
     .set_default("auto")
     .set_enum_allowed( { "auto", "fifo", "omap" } )
@@ -7264,6 +7603,15 @@ std::vector<Option> get_rgw_options() {
 	"but will default to FIFO if there isn't an existing log. Either of "
 	"the explicit options will cause startup to fail if the other log is "
 	"still around."),
+
+    Option("rgw_lua_max_cached_states", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(8)
+    .set_description("Max idle Lua states kept by each thread for reuse")
+    .set_long_description(
+        "A Lua state runs a single stored script, compiled once. It is reused by "
+        "later requests of the same thread while the script doesn't change, with "
+        "fresh globals each time. Zero creates a state and compiles the script "
+        "for each request."),
   });
 }
 
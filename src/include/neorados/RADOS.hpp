@@ -22,7 +22,9 @@
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <utility>
 #include <variant>
+#include <vector>
 
 #include <boost/asio.hpp>
 
@@ -603,6 +605,22 @@ public:
     return init.result.get();
   }
 
+  // Submit many independent write operations in one call. The
+  // completion receives the first error seen (if any) and the result of
+  // each operation, in the order given.
+  using BatchSig = void(boost::system::error_code,
+			std::vector<boost::system::error_code>);
+  using BatchComp = ceph::async::Completion<BatchSig>;
+  template<typename CompletionToken>
+  auto execute_batch(std::vector<std::pair<Object, WriteOp>>&& ops,
+		     const IOContext& ioc, CompletionToken&& token) {
+    boost::asio::async_completion<CompletionToken, BatchSig> init(token);
+    execute_batch(std::move(ops), ioc,
+		  BatchComp::create(get_executor(),
+				    std::move(init.completion_handler)));
+    return init.result.get();
+  }
+
   boost::uuids::uuid get_fsid() const noexcept;
 
   using LookupPoolSig = void(boost::system::error_code,
@@ -994,6 +1012,9 @@ private:
 	       std::optional<std::string_view> key,
 	       uint64_t* objver);
 
+  void execute_batch(std::vector<std::pair<Object, WriteOp>>&& ops,
+		     const IOContext& ioc, std::unique_ptr<BatchComp> c);
+
   void lookup_pool(std::string_view name, std::unique_ptr<LookupPoolComp> c);
   void list_pools(std::unique_ptr<LSPoolsComp> c);
   void create_pool_snap(int64_t pool, std::string_view snapName,
@@ -1186,6 +1186,25 @@ inline namespace v14_2_0 {
         ObjectWriteOperation *op, snap_t seq,
         std::vector<snap_t>& snaps, int flags,
         const blkin_trace_info *trace_info);
+    /**
+     * Schedule a batch of async write operations
+     *
+     * All operations are handed to the OSD client in one call, which
+     * takes the client lock once instead of once per operation. The
+     * completion fires when every operation is safe. Its return value is
+     * 0 if all of them succeeded, otherwise the first error seen.
+     * The batch cannot be cancelled with aio_cancel().
+     *
+     * @param ops pairs of object name and the operations to perform on it
+     * @param c what to do when all operations are complete and safe
+     * @param prvals where to store each operation's result, in the order
+     *        of @ops; may be NULL. Must stay valid until @c completes.
+     * @param flags flags to apply to every operation
+     * @returns 0 on success, negative error code on failure
+     */
+    int aio_operate_batch(
+      const std::vector<std::pair<std::string, ObjectWriteOperation*>>& ops,
+      AioCompletion *c, std::vector<int> *prvals, int flags);
     int aio_operate(const std::string& oid, AioCompletion *c,
 		    ObjectReadOperation *op, bufferlist *pbl);
 
@@ -13,6 +13,8 @@
  */
 
 #include <limits.h>
+#include <atomic>
+#include <memory>
 
 #include "IoCtxImpl.h"
 
@@ -774,6 +776,77 @@ int librados::IoCtxImpl::aio_operate(const object_t& oid,
   return 0;
 }
 
+namespace {
+
+struct BatchState {
+  Context *oncomplete;
+  std::vector<int> *prvals;
+  std::atomic<size_t> pending;
+  std::atomic<int> first_error = {0};
+
+  BatchState(Context *oncomplete, std::vector<int> *prvals, size_t n)
+    : oncomplete(oncomplete), prvals(prvals), pending(n) {}
+};
+
+// completes one op of a batch; the last one completes the batch
+struct C_aio_BatchOp : public Context {
+  std::shared_ptr<BatchState> batch;
+  size_t idx;
+
+  C_aio_BatchOp(std::shared_ptr<BatchState> batch, size_t idx)
+    : batch(std::move(batch)), idx(idx) {}
+
+  void finish(int r) override {
+    if (batch->prvals) {
+      (*batch->prvals)[idx] = r;
+    }
+    if (r < 0) {
+      int expected = 0;
+      batch->first_error.compare_exchange_strong(expected, r);
+    }
+    if (--batch->pending == 0) {
+      batch->oncomplete->complete(batch->first_error);
+    }
+  }
+};
+
+} // anonymous namespace
+
+int librados::IoCtxImpl::aio_operate_batch(
+  const std::vector<std::pair<object_t, ::ObjectOperation*>>& ops,
+  AioCompletionImpl *c, std::vector<int> *prvals,
+  const SnapContext& snap_context, int flags)
+{
+  FUNCTRACE(client->cct);
+  auto ut = ceph::real_clock::now();
+  /* can't write to a snapshot */
+  if (snap_seq != CEPH_NOSNAP)
+    return -EROFS;
+
+  Context *oncomplete = new C_aio_Complete(c);
+  c->io = this;
+  queue_aio_write(c);
+
+  if (prvals) {
+    prvals->assign(ops.size(), 0);
+  }
+  if (ops.empty()) {
+    oncomplete->complete(0);
+    return 0;
+  }
+
+  auto batch = std::make_shared<BatchState>(oncomplete, prvals, ops.size());
+  std::vector<Objecter::Op*> objecter_ops;
+  objecter_ops.reserve(ops.size());
+  for (size_t i = 0; i < ops.size(); ++i) {
+    objecter_ops.push_back(objecter->prepare_mutate_op(
+      ops[i].first, oloc, *ops[i].second, snap_context, ut, flags,
+      new C_aio_BatchOp(batch, i), nullptr));
+  }
+  objecter->op_submit_batch(objecter_ops);
+  return 0;
+}
+
 int librados::IoCtxImpl::aio_read(const object_t oid, AioCompletionImpl *c,
 				  bufferlist *pbl, size_t len, uint64_t off,
 				  uint64_t snapid, const blkin_trace_info *info)
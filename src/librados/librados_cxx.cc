@@ -1566,6 +1566,22 @@ int librados::IoCtx::aio_operate(const std::string& oid, AioCompletion *c,
 				  translate_flags(flags));
 }
 
+int librados::IoCtx::aio_operate_batch(
+  const std::vector<std::pair<std::string, ObjectWriteOperation*>>& ops,
+  AioCompletion *c, std::vector<int> *prvals, int flags)
+{
+  std::vector<std::pair<object_t, ::ObjectOperation*>> batch;
+  batch.reserve(ops.size());
+  for (auto& [oid, o] : ops) {
+    if (unlikely(!o || !o->impl))
+      return -EINVAL;
+    batch.emplace_back(object_t(oid), &o->impl->o);
+  }
+  return io_ctx_impl->aio_operate_batch(batch, c->pc, prvals,
+					io_ctx_impl->snapc,
+					translate_flags(flags));
+}
+
 int librados::IoCtx::aio_operate(const std::string& oid, AioCompletion *c,
 				 librados::ObjectWriteOperation *o,
 				 snap_t snap_seq, std::vector<snap_t>& snaps)
@@ -576,12 +576,19 @@ ssize_t ProtocolV2::write_message(Message *m, bool more) {
 template <class F>
 bool ProtocolV2::append_frame(F& frame) {
   ceph::bufferlist bl;
+  const bool secure = session_stream_handlers.tx != nullptr;
+  const auto start = secure ? ceph::mono_clock::now() : ceph::mono_time{};
   try {
     bl = frame.get_buffer(tx_frame_asm);
   } catch (ceph::crypto::onwire::TxHandlerError &e) {
     ldout(cct, 1) << __func__ << " " << e.what() << dendl;
     return false;
   }
+  if (secure) {
+    connection->logger->tinc(l_msgr_running_encrypt_time,
+                             ceph::mono_clock::now() - start);
+    connection->logger->inc(l_msgr_send_encrypted_bytes, bl.length());
+  }
 
   ldout(cct, 25) << __func__ << " assembled frame " << bl.length()
                  << " bytes " << tx_frame_asm << dendl;
@@ -1079,6 +1086,8 @@ CtPtr ProtocolV2::handle_read_frame_preamble_main(rx_buffer_t &&buffer, int r) {
   rx_preamble.hexdump(*_dout);
   *_dout << dendl;
 
+  const bool secure = session_stream_handlers.rx != nullptr;
+  const auto start = secure ? ceph::mono_clock::now() : ceph::mono_time{};
   try {
     next_tag = rx_frame_asm.disassemble_preamble(rx_preamble);
   } catch (FrameError& e) {
@@ -1088,6 +1097,10 @@ CtPtr ProtocolV2::handle_read_frame_preamble_main(rx_buffer_t &&buffer, int r) {
     ldout(cct, 1) << __func__ << "bad auth tag" << dendl;
     return _fault();
   }
+  if (secure) {
+    connection->logger->tinc(l_msgr_running_decrypt_time,
+                             ceph::mono_clock::now() - start);
+  }
 
   ldout(cct, 25) << __func__ << " disassembled preamble " << rx_frame_asm
                  << dendl;
@@ -1305,6 +1318,8 @@ CtPtr ProtocolV2::handle_read_frame_epilogue_main(rx_buffer_t &&buffer, int r)
 
 CtPtr ProtocolV2::_handle_read_frame_epilogue_main() {
   bool aborted;
+  const bool secure = session_stream_handlers.rx != nullptr;
+  const auto start = secure ? ceph::mono_clock::now() : ceph::mono_time{};
   try {
     rx_frame_asm.disassemble_first_segment(rx_preamble, rx_segments_data[0]);
     aborted = !rx_frame_asm.disassemble_remaining_segments(
@@ -1316,6 +1331,12 @@ CtPtr ProtocolV2::_handle_read_frame_epilogue_main() {
     ldout(cct, 1) << __func__ << "bad auth tag" << dendl;
     return _fault();
   }
+  if (secure) {
+    connection->logger->tinc(l_msgr_running_decrypt_time,
+                             ceph::mono_clock::now() - start);
+    connection->logger->inc(l_msgr_recv_encrypted_bytes,
+                            rx_frame_asm.get_frame_onwire_len());
+  }
 
   // we do have a mechanism that allows transmitter to start sending message
   // and abort after putting entire data field on wire. This will be used by
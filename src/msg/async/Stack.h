@@ -203,6 +203,11 @@ enum {
   l_msgr_send_messages_queue_lat,
   l_msgr_handle_ack_lat,
 
+  l_msgr_send_encrypted_bytes,
+  l_msgr_recv_encrypted_bytes,
+  l_msgr_running_encrypt_time,
+  l_msgr_running_decrypt_time,
+
   l_msgr_last,
 };
 
@@ -246,6 +251,11 @@ class Worker {
     plb.add_time_avg(l_msgr_send_messages_queue_lat, "msgr_send_messages_queue_lat", "Network sent messages lat");
     plb.add_time_avg(l_msgr_handle_ack_lat, "msgr_handle_ack_lat", "Connection handle ack lat");
 
+    plb.add_u64_counter(l_msgr_send_encrypted_bytes, "msgr_send_encrypted_bytes", "Network sent bytes in secure mode", NULL, 0, unit_t(UNIT_BYTES));
+    plb.add_u64_counter(l_msgr_recv_encrypted_bytes, "msgr_recv_encrypted_bytes", "Network received bytes in secure mode", NULL, 0, unit_t(UNIT_BYTES));
+    plb.add_time(l_msgr_running_encrypt_time, "msgr_running_encrypt_time", "The total time of frame encryption");
+    plb.add_time(l_msgr_running_decrypt_time, "msgr_running_decrypt_time", "The total time of frame decryption");
+
     perf_logger = plb.create_perf_counters();
     cct->get_perfcounters_collection()->add(perf_logger);
   }
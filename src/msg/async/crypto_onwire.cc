@@ -19,6 +19,12 @@ static constexpr const std::size_t AESGCM_IV_LEN{12};
 static constexpr const std::size_t AESGCM_TAG_LEN{16};
 static constexpr const std::size_t AESGCM_BLOCK_LEN{16};
 
+// Plaintext fragments shorter than this are staged and encrypted together
+// with their neighbours. For small frames (preamble, tiny segments and
+// epilogue) the per-call EVP overhead dominates the AES work itself.
+static constexpr const std::size_t AESGCM_STAGE_THRESHOLD{512};
+static constexpr const std::size_t AESGCM_STAGE_LEN{4096};
+
 struct nonce_t {
   ceph_le32 fixed;
   ceph_le64 counter;
@@ -44,6 +50,14 @@ class AES128GCM_OnWireTxHandler : public ceph::crypto::onwire::TxHandler {
   bool new_nonce_format;  // 64-bit counter?
   static_assert(sizeof(nonce) == AESGCM_IV_LEN);
 
+  // staged plaintext and where its ciphertext belongs in `buffer`
+  std::array<unsigned char, AESGCM_STAGE_LEN> staged;
+  std::size_t staged_len;
+  char* staged_out;
+
+  void encrypt_chunk(const unsigned char* in, std::size_t len, char* out);
+  void flush_staged();
+
 public:
   AES128GCM_OnWireTxHandler(CephContext* const cct,
 			    const key_t& key,
@@ -52,7 +66,8 @@ public:
     : cct(cct),
       ectx(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free),
       nonce(nonce), initial_nonce(nonce), used_initial_nonce(false),
-      new_nonce_format(new_nonce_format) {
+      new_nonce_format(new_nonce_format),
+      staged_len(0), staged_out(nullptr) {
     ceph_assert_always(ectx);
     ceph_assert_always(key.size() * CHAR_BIT == 128);
 
@@ -70,6 +85,7 @@ public:
   ~AES128GCM_OnWireTxHandler() override {
     ::TOPNSPC::crypto::zeroize_for_security(&nonce, sizeof(nonce));
     ::TOPNSPC::crypto::zeroize_for_security(&initial_nonce, sizeof(initial_nonce));
+    ::TOPNSPC::crypto::zeroize_for_security(staged.data(), staged.size());
   }
 
   void reset_tx_handler(const uint32_t* first, const uint32_t* last) override;
@@ -94,6 +110,7 @@ void AES128GCM_OnWireTxHandler::reset_tx_handler(const uint32_t* first,
   }
 
   ceph_assert(buffer.get_append_buffer_unused_tail_length() == 0);
+  ceph_assert(staged_len == 0);
   buffer.reserve(std::accumulate(first, last, AESGCM_TAG_LEN));
 
   if (!new_nonce_format) {
@@ -105,36 +122,72 @@ void AES128GCM_OnWireTxHandler::reset_tx_handler(const uint32_t* first,
   }
 }
 
+void AES128GCM_OnWireTxHandler::encrypt_chunk(
+  const unsigned char* in, std::size_t len, char* out)
+{
+  int update_len = 0;
+
+  if(1 != EVP_EncryptUpdate(ectx.get(),
+      reinterpret_cast<unsigned char*>(out),
+      &update_len,
+      in,
+      len)) {
+    throw std::runtime_error("EVP_EncryptUpdate failed");
+  }
+  ceph_assert_always(update_len >= 0);
+  ceph_assert(static_cast<unsigned>(update_len) == len);
+}
+
+void AES128GCM_OnWireTxHandler::flush_staged()
+{
+  if (staged_len > 0) {
+    encrypt_chunk(staged.data(), staged_len, staged_out);
+    staged_len = 0;
+    staged_out = nullptr;
+  }
+}
+
 void AES128GCM_OnWireTxHandler::authenticated_encrypt_update(
   const ceph::bufferlist& plaintext)
 {
   ceph_assert(buffer.get_append_buffer_unused_tail_length() >=
               plaintext.length());
+  // all holes of a frame come from the single region reserved by
+  // reset_tx_handler(), so ciphertext of staged fragments can be written
+  // back later without breaking the keystream order.
   auto filler = buffer.append_hole(plaintext.length());
 
   for (const auto& plainbuf : plaintext.buffers()) {
-    int update_len = 0;
-
-    if(1 != EVP_EncryptUpdate(ectx.get(),
-	reinterpret_cast<unsigned char*>(filler.c_str()),
-	&update_len,
-	reinterpret_cast<const unsigned char*>(plainbuf.c_str()),
-	plainbuf.length())) {
-      throw std::runtime_error("EVP_EncryptUpdate failed");
+    const auto len = plainbuf.length();
+    const auto in = reinterpret_cast<const unsigned char*>(plainbuf.c_str());
+
+    if (len < AESGCM_STAGE_THRESHOLD) {
+      if (staged_len + len > staged.size()) {
+	flush_staged();
+      }
+      if (staged_len == 0) {
+	staged_out = filler.c_str();
+      }
+      ::memcpy(staged.data() + staged_len, in, len);
+      staged_len += len;
+    } else {
+      flush_staged();
+      encrypt_chunk(in, len, filler.c_str());
     }
-    ceph_assert_always(update_len >= 0);
-    ceph_assert(static_cast<unsigned>(update_len) == plainbuf.length());
-    filler.advance(update_len);
+    filler.advance(len);
   }
 
   ldout(cct, 15) << __func__
 		 << " plaintext.length()=" << plaintext.length()
 		 << " buffer.length()=" << buffer.length()
+		 << " staged_len=" << staged_len
 		 << dendl;
 }
 
 ceph::bufferlist AES128GCM_OnWireTxHandler::authenticated_encrypt_final()
 {
+  flush_staged();
+
   int final_len = 0;
   ceph_assert(buffer.get_append_buffer_unused_tail_length() ==
               AESGCM_BLOCK_LEN);
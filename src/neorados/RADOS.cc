@@ -14,6 +14,7 @@
 
 #define BOOST_BIND_NO_PLACEHOLDERS
 
+#include <atomic>
 #include <optional>
 #include <string_view>
 
@@ -832,6 +833,53 @@ void RADOS::execute(const Object& o, const IOContext& _ioc, WriteOp&& _op,
   trace.event("submitted");
 }
 
+void RADOS::execute_batch(std::vector<std::pair<Object, WriteOp>>&& ops,
+			  const IOContext& _ioc,
+			  std::unique_ptr<BatchComp> c) {
+  auto ioc = reinterpret_cast<const IOContextImpl*>(&_ioc.impl);
+  auto mtime = ceph::real_clock::now();
+
+  if (ops.empty()) {
+    ca::post(std::move(c), bs::error_code{}, std::vector<bs::error_code>{});
+    return;
+  }
+
+  struct BatchState {
+    std::unique_ptr<BatchComp> c;
+    std::vector<bs::error_code> results;
+    std::atomic<std::size_t> pending;
+
+    BatchState(std::unique_ptr<BatchComp>&& c, std::size_t n)
+      : c(std::move(c)), results(n), pending(n) {}
+  };
+  auto batch = std::make_shared<BatchState>(std::move(c), ops.size());
+
+  std::vector<Objecter::Op*> objecter_ops;
+  objecter_ops.reserve(ops.size());
+  for (std::size_t i = 0; i < ops.size(); ++i) {
+    auto oid = reinterpret_cast<const object_t*>(&ops[i].first.impl);
+    auto op = reinterpret_cast<OpImpl*>(&ops[i].second.impl);
+    auto flags = op->op.flags;
+    objecter_ops.push_back(impl->objecter->prepare_mutate_op(
+      *oid, ioc->oloc, std::move(op->op), ioc->snapc,
+      op->mtime ? *op->mtime : mtime, flags,
+      [batch, i](bs::error_code ec) {
+	batch->results[i] = ec;
+	if (--batch->pending == 0) {
+	  bs::error_code first;
+	  for (const auto& r : batch->results) {
+	    if (r) {
+	      first = r;
+	      break;
+	    }
+	  }
+	  ca::defer(std::move(batch->c), first, std::move(batch->results));
+	}
+      }));
+  }
+  impl->objecter->op_submit_batch(objecter_ops);
+}
+
 void RADOS::execute(const Object& o, std::int64_t pool, ReadOp&& _op,
 		    cb::list* bl,
 		    std::unique_ptr<ReadOp::Completion> c,
@@ -174,6 +174,12 @@ enum {
   l_osdc_osdop_omap_rd,
   l_osdc_osdop_omap_del,
 
+  l_osdc_rwlock_read_wait,
+  l_osdc_rwlock_write_wait,
+
+  l_osdc_pg_mapping_hit,
+  l_osdc_pg_mapping_miss,
+
   l_osdc_last,
 };
 
@@ -233,6 +239,34 @@ void Objecter::handle_conf_change(const ConfigProxy& conf,
   }
 }
 
+ceph::shunique_lock<ceph::shared_mutex>
+Objecter::_lock_rwlock(ceph::acquire_shared_t)
+{
+  shunique_lock sul(rwlock, ceph::acquire_shared, std::try_to_lock);
+  if (!sul) {
+    auto start = ceph::mono_clock::now();
+    sul.lock_shared();
+    if (logger) {
+      logger->tinc(l_osdc_rwlock_read_wait, ceph::mono_clock::now() - start);
+    }
+  }
+  return sul;
+}
+
+ceph::shunique_lock<ceph::shared_mutex>
+Objecter::_lock_rwlock(ceph::acquire_unique_t)
+{
+  shunique_lock sul(rwlock, ceph::acquire_unique, std::try_to_lock);
+  if (!sul) {
+    auto start = ceph::mono_clock::now();
+    sul.lock();
+    if (logger) {
+      logger->tinc(l_osdc_rwlock_write_wait, ceph::mono_clock::now() - start);
+    }
+  }
+  return sul;
+}
+
 void Objecter::update_crush_location()
 {
   unique_lock wl(rwlock);
@@ -369,6 +403,16 @@ void Objecter::init()
     pcb.add_u64_counter(l_osdc_osdop_omap_del, "omap_del",
 			"OSD OMAP delete operations");
 
+    pcb.add_time_avg(l_osdc_rwlock_read_wait, "rwlock_read_wait",
+		     "Time spent waiting for contended objecter lock (shared)");
+    pcb.add_time_avg(l_osdc_rwlock_write_wait, "rwlock_write_wait",
+		     "Time spent waiting for contended objecter lock (exclusive)");
+
+    pcb.add_u64_counter(l_osdc_pg_mapping_hit, "pg_mapping_hit",
+			"PG to OSD mappings served from cache");
+    pcb.add_u64_counter(l_osdc_pg_mapping_miss, "pg_mapping_miss",
+			"PG to OSD mappings computed through CRUSH");
+
     logger = pcb.create_perf_counters();
     cct->get_perfcounters_collection()->add(logger);
   }
@@ -436,6 +480,7 @@ void Objecter::shutdown()
     auto i = check_latest_map_ops.begin();
     i->second->put();
     check_latest_map_ops.erase(i->first);
+    num_map_checks--;
   }
 
   while(!check_latest_map_commands.empty()) {
@@ -1135,9 +1180,49 @@ void Objecter::_scan_requests(
   }
 }
 
+void Objecter::_invalidate_pg_mappings(const OSDMap::Incremental& inc)
+{
+  // rwlock is locked unique
+  if (inc.fullmap.length() ||
+      inc.crush.length() ||
+      inc.new_max_osd >= 0 ||
+      !inc.new_pools.empty() ||
+      !inc.old_pools.empty() ||
+      !inc.new_up_client.empty() ||
+      !inc.new_state.empty() ||
+      !inc.new_weight.empty() ||
+      !inc.new_primary_affinity.empty()) {
+    // may move any pg
+    pg_mapping_valid_from = inc.epoch;
+    return;
+  }
+
+  // temp and upmap overrides only move the pgs they name, so the rest
+  // of the cache stays valid across the epoch
+  std::lock_guard l{pg_mapping_lock};
+  for (auto& [pg, osds] : inc.new_pg_temp) {
+    invalidate_pg_mapping(pg);
+  }
+  for (auto& [pg, osd] : inc.new_primary_temp) {
+    invalidate_pg_mapping(pg);
+  }
+  for (auto& [pg, osds] : inc.new_pg_upmap) {
+    invalidate_pg_mapping(pg);
+  }
+  for (auto& [pg, items] : inc.new_pg_upmap_items) {
+    invalidate_pg_mapping(pg);
+  }
+  for (auto& pg : inc.old_pg_upmap) {
+    invalidate_pg_mapping(pg);
+  }
+  for (auto& pg : inc.old_pg_upmap_items) {
+    invalidate_pg_mapping(pg);
+  }
+}
+
 void Objecter::handle_osd_map(MOSDMap *m)
 {
-  ceph::shunique_lock sul(rwlock, acquire_unique);
+  auto sul = _lock_rwlock(acquire_unique);
   if (!initialized)
     return;
 
@@ -1185,6 +1270,7 @@ void Objecter::handle_osd_map(MOSDMap *m)
 			<< dendl;
 	  OSDMap::Incremental inc(m->incremental_maps[e]);
 	  osdmap->apply_incremental(inc);
+	  _invalidate_pg_mappings(inc);
 
           emit_blocklist_events(inc);
 
@@ -1197,6 +1283,7 @@ void Objecter::handle_osd_map(MOSDMap *m)
 
           emit_blocklist_events(*osdmap, *new_osdmap);
           osdmap = std::move(new_osdmap);
+          pg_mapping_valid_from = osdmap->get_epoch();
 
 	  logger->inc(l_osdc_map_full);
 	}
@@ -1257,6 +1344,7 @@ void Objecter::handle_osd_map(MOSDMap *m)
 	ldout(cct, 3) << "handle_osd_map decoding full epoch "
 		      << m->get_last() << dendl;
 	osdmap->decode(m->maps[m->get_last()]);
+        pg_mapping_valid_from = osdmap->get_epoch();
         prune_pg_mapping(osdmap->get_pools());
 
 	_scan_requests(homeless_session, false, false, NULL,
@@ -1452,6 +1540,9 @@ void Objecter::CB_Op_Map_Latest::operator()(bs::error_code e,
 
   unique_lock sl(op->session->lock, defer_lock);
   objecter->_check_op_pool_dne(op, &sl);
+  // only now, as a reply may finish the op without rwlock once there are
+  // no map checks left
+  objecter->num_map_checks--;
 
   op->put();
 }
@@ -1569,6 +1660,7 @@ void Objecter::_send_op_map_check(Op *op)
   if (check_latest_map_ops.count(op->tid) == 0) {
     op->get();
     check_latest_map_ops[op->tid] = op;
+    num_map_checks++;
     monc->get_version("osdmap", CB_Op_Map_Latest(this, op->tid));
   }
 }
@@ -1581,6 +1673,7 @@ void Objecter::_op_cancel_map_check(Op *op)
     Op *op = iter->second;
     op->put();
     check_latest_map_ops.erase(iter);
+    num_map_checks--;
   }
 }
 
@@ -2190,7 +2283,7 @@ void Objecter::resend_mon_ops()
 
 void Objecter::op_submit(Op *op, ceph_tid_t *ptid, int *ctx_budget)
 {
-  shunique_lock rl(rwlock, ceph::acquire_shared);
+  auto rl = _lock_rwlock(ceph::acquire_shared);
   ceph_tid_t tid = 0;
   if (!ptid)
     ptid = &tid;
@@ -2198,6 +2291,95 @@ void Objecter::op_submit(Op *op, ceph_tid_t *ptid, int *ctx_budget)
   _op_submit_with_budget(op, rl, ptid, ctx_budget);
 }
 
+void Objecter::op_submit_batch(const std::vector<Op*>& ops)
+{
+  auto sul = _lock_rwlock(ceph::acquire_shared);
+  ceph_assert(initialized);
+
+  // ops bound for an open osd session are gathered per session. they are
+  // sent before anything that may drop rwlock, so their targets stay
+  // valid, and before any op that takes the usual path, so that ops on
+  // the same object keep their order
+  std::map<OSDSession*, std::vector<Op*>> gathered;
+  auto send_gathered = [this, &gathered] {
+    for (auto& [s, sops] : gathered) {
+      _op_submit_session(s, sops);
+      put_session(s);
+    }
+    gathered.clear();
+  };
+
+  for (auto op : ops) {
+    op->trace.event("op submit");
+
+    ceph_assert(op->ops.size() == op->out_bl.size());
+    ceph_assert(op->ops.size() == op->out_rval.size());
+    ceph_assert(op->ops.size() == op->out_handler.size());
+
+    if (!op->ctx_budgeted) {
+      // gathered ops hold budget until they complete, so don't wait for
+      // it while they are unsent
+      if (!keep_balanced_budget || gathered.empty() ||
+	  !_try_take_op_budget(op)) {
+	if (keep_balanced_budget) {
+	  send_gathered();
+	}
+	_take_op_budget(op, sul);
+      }
+    }
+    _op_add_timeout(op);
+
+    OSDSession *s = nullptr;
+    if (_calc_target(&op->target, nullptr) == RECALC_OP_TARGET_POOL_DNE ||
+	op->target.paused || op->target.osd < 0 ||
+	cct->_conf->objecter_debug_inject_relock_delay ||
+	_get_session(op->target.osd, &s, sul) < 0) {
+      send_gathered();
+      _op_submit(op, sul, nullptr);
+      continue;
+    }
+    auto [i, added] = gathered.try_emplace(s);
+    if (!added) {
+      put_session(s);
+    }
+    i->second.push_back(op);
+  }
+  send_gathered();
+}
+
+void Objecter::_op_submit_session(OSDSession *s, const std::vector<Op*>& ops)
+{
+  // rwlock is locked
+  // the targets of ops were calculated under it, and map to s
+
+  for (auto op : ops) {
+    ceph_assert(op->session == NULL);
+    _send_op_account(op);
+    ceph_assert(op->target.flags & (CEPH_OSD_FLAG_READ|CEPH_OSD_FLAG_WRITE));
+    if (pool_full_try) {
+      op->target.flags |= CEPH_OSD_FLAG_FULL_TRY;
+    }
+  }
+
+  unique_lock sl(s->lock);
+  for (auto op : ops) {
+    if (op->tid == 0)
+      op->tid = ++last_tid;
+
+    ldout(cct, 10) << __func__ << " oid " << op->target.base_oid
+		   << " '" << op->target.base_oloc << "' '"
+		   << op->target.target_oloc << "' " << op->ops << " tid "
+		   << op->tid << " osd." << s->osd << dendl;
+
+    _session_op_assign(s, op);
+    _send_op(op);
+  }
+  // the ops may be freed by the response handler from here on
+  sl.unlock();
+
+  ldout(cct, 5) << num_in_flight << " in flight" << dendl;
+}
+
 void Objecter::_op_submit_with_budget(Op *op,
 				      shunique_lock<ceph::shared_mutex>& sul,
 				      ceph_tid_t *ptid,
@@ -2220,6 +2402,12 @@ void Objecter::_op_submit_with_budget(Op *op,
     }
   }
 
+  _op_add_timeout(op);
+  _op_submit(op, sul, ptid);
+}
+
+void Objecter::_op_add_timeout(Op *op)
+{
   if (osd_timeout > timespan(0)) {
     if (op->tid == 0)
       op->tid = ++last_tid;
@@ -2228,8 +2416,6 @@ void Objecter::_op_submit_with_budget(Op *op,
 				    [this, tid]() {
 				      op_cancel(tid, -ETIMEDOUT); });
   }
-
-  _op_submit(op, sul, ptid);
 }
 
 void Objecter::_send_op_account(Op *op)
@@ -2766,13 +2952,15 @@ int Objecter::_calc_target(op_target_t *t, Connection *con, bool any_change)
   ps_t actual_ps = ceph_stable_mod(pgid.ps(), pg_num, pg_num_mask);
   pg_t actual_pgid(actual_ps, pgid.pool());
   pg_mapping_t pg_mapping;
-  pg_mapping.epoch = osdmap->get_epoch();
+  pg_mapping.epoch = pg_mapping_valid_from;
   if (lookup_pg_mapping(actual_pgid, &pg_mapping)) {
+    logger->inc(l_osdc_pg_mapping_hit);
     up = pg_mapping.up;
     up_primary = pg_mapping.up_primary;
     acting = pg_mapping.acting;
     acting_primary = pg_mapping.acting_primary;
   } else {
+    logger->inc(l_osdc_pg_mapping_miss);
     osdmap->pg_to_up_acting_osds(actual_pgid, &up, &up_primary,
                                  &acting, &acting_primary);
     pg_mapping_t pg_mapping(osdmap->get_epoch(),
@@ -3077,11 +3265,13 @@ void Objecter::_cancel_linger_op(Op *op)
   _finish_op(op, 0);
 }
 
-void Objecter::_finish_op(Op *op, int r)
+void Objecter::_finish_op(Op *op, int r, bool rwlocked)
 {
   ldout(cct, 15) << __func__ << " " << op->tid << dendl;
 
-  // op->session->lock is locked unique or op->session is null
+  // op->session->lock is locked unique or op->session is null. rwlock is
+  // locked if rwlocked; otherwise no map check is pending for the op (see
+  // handle_osd_op_reply)
 
   if (!op->ctx_budgeted && op->budget >= 0) {
     put_op_budget_bytes(op->budget);
@@ -3097,7 +3287,9 @@ void Objecter::_finish_op(Op *op, int r)
 
   logger->dec(l_osdc_op_active);
 
-  ceph_assert(check_latest_map_ops.find(op->tid) == check_latest_map_ops.end());
+  if (rwlocked) {
+    ceph_assert(check_latest_map_ops.find(op->tid) == check_latest_map_ops.end());
+  }
 
   inflight_ops--;
 
@@ -3289,7 +3481,14 @@ void Objecter::handle_osd_op_reply(MOSDOpReply *m)
   // get pio
   ceph_tid_t tid = m->get_tid();
 
-  shunique_lock sul(rwlock, ceph::acquire_shared);
+  // most replies complete their op under the session lock alone, so that
+  // replies from different osds don't meet on rwlock. only those that
+  // resubmit their op need rwlock, which is taken before the session lock
+  ceph::shunique_lock<ceph::shared_mutex> sul;
+  if (retry_writes_after_first_reply || m->is_redirect_reply() ||
+      m->get_result() == -EAGAIN) {
+    sul = _lock_rwlock(ceph::acquire_shared);
+  }
   if (!initialized) {
     m->put();
     return;
@@ -3298,13 +3497,31 @@ void Objecter::handle_osd_op_reply(MOSDOpReply *m)
   ConnectionRef con = m->get_connection();
   auto priv = con->get_priv();
   auto s = static_cast<OSDSession*>(priv.get());
-  if (!s || s->con != con) {
+  if (!s) {
     ldout(cct, 7) << __func__ << " no session on con " << con << dendl;
     m->put();
     return;
   }
 
+  // s->con only changes under s->lock
   unique_lock sl(s->lock);
+  if (num_map_checks > 0 && !sul.owns_lock()) {
+    // the op may wait for a map check, which CB_Op_Map_Latest completes
+    // under rwlock. take it unique to cancel the check. no check starts
+    // for an op of s without s->lock
+    sl.unlock();
+    if (sul) {
+      sul.unlock();
+    }
+    sul = _lock_rwlock(ceph::acquire_unique);
+    sl.lock();
+  }
+  if (s->con != con) {
+    ldout(cct, 7) << __func__ << " no session on con " << con << dendl;
+    sl.unlock();
+    m->put();
+    return;
+  }
 
   map<ceph_tid_t, Op *>::iterator iter = s->ops.find(tid);
   if (iter == s->ops.end()) {
@@ -3398,7 +3615,13 @@ void Objecter::handle_osd_op_reply(MOSDOpReply *m)
     return;
   }
 
-  sul.unlock();
+  // the op can't be finished by a map check from now on
+  if (sul.owns_lock()) {
+    _op_cancel_map_check(op);
+  }
+  if (sul) {
+    sul.unlock();
+  }
 
   if (op->objver)
     *op->objver = m->get_user_version();
@@ -3489,7 +3712,7 @@ void Objecter::handle_osd_op_reply(MOSDOpReply *m)
   auto completion_lock = s->get_lock(op->target.base_oid);
 
   ldout(cct, 15) << "handle_osd_op_reply completed tid " << tid << dendl;
-  _finish_op(op, 0);
+  _finish_op(op, 0, false);
 
   ldout(cct, 5) << num_in_flight << " in flight" << dendl;
 
@@ -1676,6 +1676,8 @@ private:
     ceph::make_shared_mutex("Objecter::pg_mapping_lock");
   // pool -> pg mapping
   std::map<int64_t, std::vector<pg_mapping_t>> pg_mappings;
+  // mappings computed before this epoch are stale; protected by rwlock
+  epoch_t pg_mapping_valid_from = 0;
 
   // convenient accessors
   bool lookup_pg_mapping(const pg_t& pg, pg_mapping_t* pg_mapping) {
@@ -1686,11 +1688,20 @@ private:
     auto& mapping_array = it->second;
     if (pg.ps() >= mapping_array.size())
       return false;
-    if (mapping_array[pg.ps()].epoch != pg_mapping->epoch) // stale
+    auto cached_epoch = mapping_array[pg.ps()].epoch;
+    if (cached_epoch == 0 || cached_epoch < pg_mapping->epoch) // stale
       return false;
     *pg_mapping = mapping_array[pg.ps()];
     return true;
   }
+  void invalidate_pg_mapping(const pg_t& pg) {
+    // pg_mapping_lock is locked
+    auto it = pg_mappings.find(pg.pool());
+    if (it != pg_mappings.end() && pg.ps() < it->second.size()) {
+      it->second[pg.ps()].epoch = 0;
+    }
+  }
+  void _invalidate_pg_mappings(const OSDMap::Incremental& inc);
   void update_pg_mapping(const pg_t& pg, pg_mapping_t&& pg_mapping) {
     std::lock_guard l{pg_mapping_lock};
     auto& mapping_array = pg_mappings[pg.pool()];
@@ -1730,6 +1741,10 @@ private:
 
   mutable ceph::shared_mutex rwlock =
 	   ceph::make_shared_mutex("Objecter::rwlock");
+  // Acquire rwlock; when it is contended, account the time spent
+  // waiting in the rwlock_{read,write}_wait perf counters.
+  ceph::shunique_lock<ceph::shared_mutex> _lock_rwlock(ceph::acquire_shared_t);
+  ceph::shunique_lock<ceph::shared_mutex> _lock_rwlock(ceph::acquire_unique_t);
   ceph::timer<ceph::coarse_mono_clock> timer;
 
   PerfCounters* logger = nullptr;
@@ -2439,6 +2454,9 @@ public:
   // the pool does not exist (may be expanded to other uses later)
   std::map<uint64_t, LingerOp*> check_latest_map_lingers;
   std::map<ceph_tid_t, Op*> check_latest_map_ops;
+  // map checks of ops in progress. while there are any, replies take
+  // rwlock, since CB_Op_Map_Latest may finish their op
+  std::atomic<unsigned> num_map_checks{0};
   std::map<ceph_tid_t, CommandOp*> check_latest_map_commands;
 
   std::map<epoch_t,
@@ -2452,7 +2470,7 @@ public:
   void _send_op(Op *op);
   void _send_op_account(Op *op);
   void _cancel_linger_op(Op *op);
-  void _finish_op(Op *op, int r);
+  void _finish_op(Op *op, int r, bool rwlocked = true);
   static bool is_pg_changed(
     int oldprimary,
     const std::vector<int>& oldacting,
@@ -2560,6 +2578,19 @@ private:
     op->budget = op_budget;
     return op_budget;
   }
+  // take the op's budget, unless that would block
+  bool _try_take_op_budget(Op *op) {
+    int op_budget = calc_op_budget(op->ops);
+    if (!op_throttle_bytes.get_or_fail(op_budget)) {
+      return false;
+    }
+    if (!op_throttle_ops.get_or_fail(1)) {
+      op_throttle_bytes.put(op_budget);
+      return false;
+    }
+    op->budget = op_budget;
+    return true;
+  }
   int take_linger_budget(LingerOp *info);
   void put_op_budget_bytes(int op_budget) {
     ceph_assert(op_budget >= 0);
@@ -2710,9 +2741,15 @@ private:
 			      ceph::shunique_lock<ceph::shared_mutex>& lc,
 			      ceph_tid_t *ptid,
 			      int *ctx_budget = NULL);
+  void _op_add_timeout(Op *op);
+  void _op_submit_session(OSDSession *s, const std::vector<Op*>& ops);
   // public interface
 public:
   void op_submit(Op *op, ceph_tid_t *ptid = NULL, int *ctx_budget = NULL);
+  /// Submit several ops under a single rwlock acquisition. Ops bound
+  /// for an open osd session are sent together, under a single
+  /// acquisition of the session lock.
+  void op_submit_batch(const std::vector<Op*>& ops);
   bool is_active() {
     std::shared_lock l(rwlock);
     return !((!inflight_ops) && linger_ops.empty() &&
@@ -2920,6 +2957,27 @@ public:
     op.clear();
     return o;
   }
+  Op *prepare_mutate_op(
+    const object_t& oid, const object_locator_t& oloc,
+    ObjectOperation&& op, const SnapContext& snapc,
+    ceph::real_time mtime, int flags,
+    fu2::unique_function<Op::OpSig>&& oncommit,
+    version_t *objver = NULL, osd_reqid_t reqid = osd_reqid_t(),
+    ZTracer::Trace *parent_trace = nullptr) {
+    Op *o = new Op(oid, oloc, std::move(op.ops), flags | global_op_flags |
+		   CEPH_OSD_FLAG_WRITE, std::move(oncommit), objver,
+		   nullptr, parent_trace);
+    o->priority = op.priority;
+    o->mtime = mtime;
+    o->snapc = snapc;
+    o->out_bl.swap(op.out_bl);
+    o->out_handler.swap(op.out_handler);
+    o->out_rval.swap(op.out_rval);
+    o->out_ec.swap(op.out_ec);
+    o->reqid = reqid;
+    op.clear();
+    return o;
+  }
   ceph_tid_t mutate(
     const object_t& oid, const object_locator_t& oloc,
     ObjectOperation& op, const SnapContext& snapc,
@@ -580,6 +580,7 @@ namespace rgw {
     ldh->bind();
 
     rgw_log_usage_init(g_ceph_context, store->getRados());
+    rgw_log_ops_init(g_ceph_context, store->getRados());
 
     // XXX ex-RGWRESTMgr_lib, mgr->set_logging(true)
 
@@ -636,6 +637,7 @@ namespace rgw {
     shutdown_async_signal_handler();
 
     rgw_log_usage_finalize();
+    rgw_log_ops_finalize();
 
     delete olog;
 
@@ -40,6 +40,7 @@ extern "C" {
 #include "rgw_acl.h"
 #include "rgw_acl_s3.h"
 #include "rgw_datalog.h"
+#include "rgw_gc.h"
 #include "rgw_lc.h"
 #include "rgw_log.h"
 #include "rgw_formats.h"
@@ -228,6 +229,8 @@ void usage()
   cout << "                             --include-all to list all entries, including unexpired)\n";
   cout << "  gc process                 manually process garbage (specify\n";
   cout << "                             --include-all to process all entries, including unexpired)\n";
+  cout << "  gc throughput              show the backlog of each gc shard and the rate its\n";
+  cout << "                             last pass drained it at\n";
   cout << "  lc list                    list all bucket lifecycle progress\n";
   cout << "  lc get                     get a lifecycle bucket configuration\n";
   cout << "  lc process                 manually process lifecycle\n";
@@ -638,6 +641,7 @@ enum class OPT {
   QUOTA_DISABLE,
   GC_LIST,
   GC_PROCESS,
+  GC_THROUGHPUT,
   LC_LIST,
   LC_GET,
   LC_PROCESS,
@@ -841,6 +845,7 @@ static SimpleCmd::Commands all_cmds = {
   { "quota disable", OPT::QUOTA_DISABLE },
   { "gc list", OPT::GC_LIST },
   { "gc process", OPT::GC_PROCESS },
+  { "gc throughput", OPT::GC_THROUGHPUT },
   { "lc list", OPT::LC_LIST },
   { "lc get", OPT::LC_GET },
   { "lc process", OPT::LC_PROCESS },
@@ -3809,6 +3814,7 @@ int main(int argc, const char **argv)
 			 OPT::OLH_GET,
 			 OPT::OLH_READLOG,
 			 OPT::GC_LIST,
+			 OPT::GC_THROUGHPUT,
 			 OPT::LC_LIST,
 			 OPT::ORPHANS_LIST_JOBS,
 			 OPT::ZONEGROUP_GET,
@@ -7222,6 +7228,34 @@ next:
     }
   }
 
+  if (opt_cmd == OPT::GC_THROUGHPUT) {
+    const uint64_t max_backlog = max_entries_specified ? max_entries : 100000;
+    std::vector<RGWGCThroughput> result;
+    int ret = store->getRados()->gc_throughput(max_backlog, result);
+    if (ret < 0) {
+      cerr << "ERROR: failed to read gc throughput: " << cpp_strerror(-ret) << std::endl;
+      return 1;
+    }
+
+    uint64_t backlog = 0;
+    double rate = 0;
+    formatter->open_object_section("gc_throughput");
+    formatter->open_array_section("shards");
+    for (auto& t : result) {
+      encode_json("shard", t, formatter.get());
+      backlog += t.backlog;
+      rate += t.last.retired / std::max(t.last.duration.to_double(), 1.0);
+    }
+    formatter->close_section();
+    encode_json("backlog", backlog, formatter.get());
+    encode_json("drain_rate", rate, formatter.get());
+    if (rate > 0) {
+      encode_json("est_drain_secs", uint64_t(backlog / rate), formatter.get());
+    }
+    formatter->close_section();
+    formatter->flush(cout);
+  }
+
   if (opt_cmd == OPT::LC_LIST) {
     formatter->open_array_section("lifecycle_list");
     vector<rgw::sal::Lifecycle::LCEntry> bucket_lc_map;
@@ -29,6 +29,58 @@ bool Throttle::waiter_ready() const
   }
 }
 
+bool WindowBudget::try_reserve(uint64_t n, uint64_t limit)
+{
+  uint64_t cur = used;
+  do {
+    if (limit && cur + n > limit) {
+      return false;
+    }
+  } while (!used.compare_exchange_weak(cur, cur + n));
+  return true;
+}
+
+ReadWindow::ReadWindow(WindowBudget& budget, uint64_t min, uint64_t max,
+                       uint64_t limit)
+  : budget(budget), min(std::min(min, max)), max(max), limit(limit),
+    window(this->min), peak(window)
+{
+  budget.reserve(window);
+}
+
+void ReadWindow::add_sent(uint64_t bytes, ceph::timespan t)
+{
+  round_bytes += bytes;
+  client_time += t;
+  if (round_bytes < window) {
+    return;
+  }
+
+  if (wait_time > client_time) {
+    // the client drains faster than we read ahead
+    const uint64_t next = std::min(window * 2, max);
+    if (next > window) {
+      if (budget.try_reserve(next - window, limit)) {
+        window = next;
+        peak = std::max(peak, window);
+        ++grows;
+      } else {
+        ++capped;
+      }
+    }
+  } else if (client_time > wait_time * 2) {
+    const uint64_t next = std::max(window / 2, min);
+    if (next < window) {
+      budget.release(window - next);
+      window = next;
+      ++shrinks;
+    }
+  }
+
+  round_bytes = 0;
+  wait_time = client_time = ceph::timespan::zero();
+}
+
 AioResultList BlockingAioThrottle::get(const RGWSI_RADOS::Obj& obj,
                                        OpFunc&& f,
                                        uint64_t cost, uint64_t id)
@@ -16,8 +16,10 @@
 #pragma once
 
 #include "include/rados/librados_fwd.hpp"
+#include <atomic>
 #include <memory>
 #include "common/ceph_mutex.h"
+#include "common/ceph_time.h"
 #include "common/async/completion.h"
 #include "common/async/yield_context.h"
 #include "services/svc_rados.h"
@@ -112,6 +114,53 @@ class YieldingAioThrottle final : public Aio, private Throttle {
   AioResultList drain() override final;
 };
 
+// process-wide account of the memory that object reads may hold in their
+// readahead windows
+class WindowBudget {
+  std::atomic<uint64_t> used{0};
+ public:
+  // reserve regardless of the limit, for the minimum window that every
+  // read needs to make progress
+  void reserve(uint64_t n) { used += n; }
+  // reserve only if the total stays within limit. a limit of 0 is unlimited
+  bool try_reserve(uint64_t n, uint64_t limit);
+  void release(uint64_t n) { used -= n; }
+  uint64_t get_used() const { return used; }
+};
+
+// the readahead window of a single object read, adapted to the rate at
+// which the client drains it. each time a window's worth of data has been
+// sent, the window doubles if more time went into waiting on rados than
+// into sending to the client, and halves if the client was the bottleneck
+// and the data read ahead only sat in memory
+class ReadWindow {
+  WindowBudget& budget;
+  const uint64_t min;
+  const uint64_t max;
+  const uint64_t limit;
+  uint64_t window;
+
+  uint64_t round_bytes = 0;
+  ceph::timespan wait_time = ceph::timespan::zero();
+  ceph::timespan client_time = ceph::timespan::zero();
+
+ public:
+  uint64_t peak;
+  uint32_t grows = 0;
+  uint32_t shrinks = 0;
+  uint32_t capped = 0; // grows refused by the budget
+
+  ReadWindow(WindowBudget& budget, uint64_t min, uint64_t max, uint64_t limit);
+  ~ReadWindow() { budget.release(window); }
+
+  uint64_t get() const { return window; }
+
+  // time spent waiting for reads with the window full
+  void add_wait(ceph::timespan t) { wait_time += t; }
+  // bytes sent to the client, and the time it took
+  void add_sent(uint64_t bytes, ceph::timespan t);
+};
+
 // return a smart pointer to Aio
 inline auto make_throttle(uint64_t window_size, optional_yield y)
 {
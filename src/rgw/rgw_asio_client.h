@@ -31,6 +31,10 @@ class ClientIO : public io::RestfulClient,
 
   rgw::io::StaticOutputBufferer<> txbuf;
 
+ protected:
+  // send all buffers of bl with a single gathering write
+  virtual size_t write_buffers(const ceph::bufferlist& bl) = 0;
+
  public:
   ClientIO(parser_type& parser, bool is_ssl,
            const endpoint_type& local_endpoint,
@@ -51,6 +55,10 @@ class ClientIO : public io::RestfulClient,
     return write_data(buf, len);
   }
 
+  size_t send_body_buffers(const ceph::bufferlist& bl) override {
+    return write_buffers(bl);
+  }
+
   RGWEnv& get_env() noexcept override {
     return env;
   }
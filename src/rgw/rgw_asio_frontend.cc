@@ -6,6 +6,7 @@
 #include <vector>
 
 #include <boost/asio.hpp>
+#include <boost/container/small_vector.hpp>
 #include <boost/intrusive/list.hpp>
 
 #include <boost/context/protected_fixedsize_stack.hpp>
@@ -30,6 +31,9 @@
 #endif
 
 #include "rgw_dmclock_async_scheduler.h"
+#include "rgw_dmclock_tenant.h"
+#include "rgw_dmclock_tenant_share.h"
+#include "rgw_perf_counters.h"
 
 #define dout_subsys ceph_subsys_rgw
 
@@ -66,14 +70,14 @@ class StreamIO : public rgw::asio::ClientIO {
         cct(cct), stream(stream), yield(yield), buffer(buffer), request_timeout(request_timeout)
   {}
 
-  size_t write_data(const char* buf, size_t len) override {
+  template <typename ConstBufferSequence>
+  size_t write(const ConstBufferSequence& buffers) {
     boost::system::error_code ec;
     auto& timeout = get_lowest_layer(stream);
     if (request_timeout.count()) {
       timeout.expires_after(request_timeout);
     }
-    auto bytes = boost::asio::async_write(stream, boost::asio::buffer(buf, len),
-                                          yield[ec]);
+    auto bytes = boost::asio::async_write(stream, buffers, yield[ec]);
     if (ec) {
       ldout(cct, 4) << "write_data failed: " << ec.message() << dendl;
       if (ec==boost::asio::error::broken_pipe) {
@@ -85,6 +89,23 @@ class StreamIO : public rgw::asio::ClientIO {
     return bytes;
   }
 
+  size_t write_data(const char* buf, size_t len) override {
+    return write(boost::asio::buffer(buf, len));
+  }
+
+  size_t write_buffers(const ceph::bufferlist& bl) override {
+    // point at the segments of the bufferlist instead of copying them
+    // into one contiguous buffer
+    boost::container::small_vector<boost::asio::const_buffer, 4> buffers;
+    buffers.reserve(bl.get_num_buffers());
+    for (const auto& ptr : bl.buffers()) {
+      if (ptr.length()) {
+        buffers.emplace_back(ptr.c_str(), ptr.length());
+      }
+    }
+    return write(buffers);
+  }
+
   size_t recv_body(char* buf, size_t max) override {
     auto& timeout = get_lowest_layer(stream);
     auto& message = parser.get();
@@ -146,6 +167,7 @@ void handle_connection(boost::asio::io_context& context,
                        parse_buffer& buffer, bool is_ssl,
                        SharedMutex& pause_mutex,
                        rgw::dmclock::Scheduler *scheduler,
+                       rgw::dmclock::TenantScheduler *tenant_scheduler,
                        boost::system::error_code& ec,
                        spawn::yield_context yield,
                        ceph::timespan request_timeout)
@@ -230,7 +252,7 @@ void handle_connection(boost::asio::io_context& context,
       int http_ret = 0;
       process_request(env.store, env.rest, &req, env.uri_prefix,
                       *env.auth_registry, &client, env.olog, y,
-                      scheduler, &http_ret);
+                      scheduler, &http_ret, tenant_scheduler);
 
       if (cct->_conf->subsys.should_gather(dout_subsys, 1)) {
         // access log line elements begin per Apache Combined Log Format with additions following
@@ -330,10 +352,14 @@ class AsioFrontend {
                          bufferlist *pbl);
   int ssl_set_private_key(const string& name, bool is_ssl_cert);
   int ssl_set_certificate_chain(const string& name);
+  int ssl_set_session_ticket_key(const string& name);
   int init_ssl();
 #endif
   SharedMutex pause_mutex;
   std::unique_ptr<rgw::dmclock::Scheduler> scheduler;
+  std::unique_ptr<dmc::AsyncTenantScheduler> tenant_scheduler;
+  std::unique_ptr<dmc::TenantUsageShare> tenant_share;
+  void start_tenant_share();
 
   struct Listener {
     tcp::endpoint endpoint;
@@ -383,6 +409,9 @@ class AsioFrontend {
       scheduler.reset(new dmc::SimpleThrottler(ctx()));
 
     }
+    if (ctx()->_conf.get_val<bool>("rgw_dmclock_tenant_qos")) {
+      tenant_scheduler.reset(new dmc::AsyncTenantScheduler(ctx(), context));
+    }
   }
 
   int init();
@@ -752,6 +781,40 @@ int AsioFrontend::ssl_set_certificate_chain(const string& name)
   return 0;
 }
 
+int AsioFrontend::ssl_set_session_ticket_key(const string& name)
+{
+  bufferlist bl;
+  if (!boost::algorithm::starts_with(name, config_val_prefix)) {
+    std::string err;
+    int r = bl.read_file(name.c_str(), &err);
+    if (r < 0) {
+      lderr(ctx()) << "failed to read ssl_session_ticket_key=" << name
+        << ": " << err << dendl;
+      return r;
+    }
+  } else {
+    int r = get_config_key_val(name.substr(config_val_prefix.size()),
+                               "ssl_session_ticket_key",
+                               &bl);
+    if (r < 0) {
+      return r;
+    }
+  }
+
+  // 80 bytes of name, hmac and aes keys, or 48 for older openssl
+  if (bl.length() != 80 && bl.length() != 48) {
+    lderr(ctx()) << "ssl_session_ticket_key=" << name << " must hold 80 "
+      "or 48 bytes, not " << bl.length() << dendl;
+    return -EINVAL;
+  }
+  if (SSL_CTX_set_tlsext_ticket_keys(ssl_context->native_handle(),
+                                     bl.c_str(), bl.length()) != 1) {
+    lderr(ctx()) << "failed to use ssl_session_ticket_key=" << name << dendl;
+    return -EINVAL;
+  }
+  return 0;
+}
+
 int AsioFrontend::init_ssl()
 {
   boost::system::error_code ec;
@@ -811,6 +874,35 @@ int AsioFrontend::init_ssl()
     }
   }
 
+  if (have_cert) {
+    // let clients resume their sessions instead of doing full handshakes.
+    // gateways sharing a ticket key resume each other's sessions too
+    auto native = ssl_context->native_handle();
+    static const unsigned char session_id_context[] = "radosgw";
+    SSL_CTX_set_session_id_context(native, session_id_context,
+                                   sizeof(session_id_context) - 1);
+    SSL_CTX_set_session_cache_mode(native, SSL_SESS_CACHE_SERVER);
+
+    auto timeout = config.find("ssl_session_timeout");
+    if (timeout != config.end()) {
+      auto seconds = ceph::parse<uint64_t>(timeout->second);
+      if (!seconds) {
+        lderr(ctx()) << "failed to parse ssl_session_timeout="
+          << timeout->second << dendl;
+        return -EINVAL;
+      }
+      SSL_CTX_set_timeout(native, *seconds);
+    }
+
+    std::optional<string> ticket_key = conf->get_val("ssl_session_ticket_key");
+    if (ticket_key) {
+      int r = ssl_set_session_ticket_key(*ticket_key);
+      if (r < 0) {
+        return r;
+      }
+    }
+  }
+
   // parse ssl endpoints
   for (auto i = ports.first; i != ports.second; ++i) {
     if (!have_cert) {
@@ -889,9 +981,16 @@ void AsioFrontend::accept(Listener& l, boost::system::error_code ec)
           ldout(ctx(), 1) << "ssl handshake failed: " << ec.message() << dendl;
           return;
         }
+        if (perfcounter) {
+          perfcounter->inc(l_rgw_ssl_handshake);
+          if (SSL_session_reused(stream.native_handle())) {
+            perfcounter->inc(l_rgw_ssl_handshake_resumed);
+          }
+        }
         buffer->consume(bytes);
         handle_connection(context, env, stream, *buffer, true, pause_mutex,
-                          scheduler.get(), ec, yield, request_timeout);
+                          scheduler.get(), tenant_scheduler.get(),
+                          ec, yield, request_timeout);
         if (!ec) {
           // ssl shutdown (ignoring errors)
           stream.async_shutdown(yield[ec]);
@@ -909,7 +1008,8 @@ void AsioFrontend::accept(Listener& l, boost::system::error_code ec)
         auto buffer = std::make_unique<parse_buffer>();
         boost::system::error_code ec;
         handle_connection(context, env, s, *buffer, false, pause_mutex,
-                          scheduler.get(), ec, yield, request_timeout);
+                          scheduler.get(), tenant_scheduler.get(),
+                          ec, yield, request_timeout);
         s.socket().shutdown(tcp::socket::shutdown_both, ec);
       }, make_stack_allocator());
   }
@@ -935,9 +1035,20 @@ int AsioFrontend::run()
       context.run(ec);
     });
   }
+  start_tenant_share();
   return 0;
 }
 
+void AsioFrontend::start_tenant_share()
+{
+  if (tenant_scheduler &&
+      ctx()->_conf.get_val<int64_t>("rgw_dmclock_tenant_share_interval") > 0) {
+    tenant_share = std::make_unique<dmc::TenantUsageShare>(
+        ctx(), env.store, tenant_scheduler.get());
+    tenant_share->start();
+  }
+}
+
 void AsioFrontend::stop()
 {
   ldout(ctx(), 4) << "frontend initiating shutdown..." << dendl;
@@ -952,6 +1063,7 @@ void AsioFrontend::stop()
   // close all connections
   connections.close(ec);
   pause_mutex.cancel();
+  tenant_share.reset();
 }
 
 void AsioFrontend::join()
@@ -978,6 +1090,9 @@ void AsioFrontend::pause()
     l.acceptor.cancel(ec);
   }
 
+  // the store is about to go away
+  tenant_share.reset();
+
   // pause and wait for outstanding requests to complete
   pause_mutex.lock(ec);
 
@@ -994,6 +1109,8 @@ void AsioFrontend::unpause(rgw::sal::RGWRadosStore* const store,
   env.store = store;
   env.auth_registry = std::move(auth_registry);
 
+  start_tenant_share();
+
   // unpause to unblock connections
   pause_mutex.unlock();
 
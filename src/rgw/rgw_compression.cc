@@ -39,40 +39,95 @@ int rgw_compression_info_from_attrset(const map<string, bufferlist>& attrs,
 
 //------------RGWPutObj_Compress---------------
 
+RGWPutObj_Compress::RGWPutObj_Compress(CephContext* cct_,
+                                       CompressorRef compressor,
+                                       rgw::putobj::DataProcessor *next,
+                                       optional_yield y)
+  : Pipe(next), cct(cct_), compressor(compressor),
+    offload(cct_,
+            [this] (bufferlist& in, uint64_t, bufferlist& out) {
+              // the message was settled by the first part
+              boost::optional<int32_t> message;
+              return this->compressor->compress(in, out, message);
+            },
+            [this] (int r, bufferlist&& out, uint64_t logical_offset) {
+              return emit_part(r, std::move(out), logical_offset);
+            },
+            y)
+{}
+
+int RGWPutObj_Compress::emit_part(int cr, bufferlist&& out,
+                                  uint64_t logical_offset)
+{
+  if (cr < 0) {
+    lderr(cct) << "Compression failed with exit code " << cr
+        << " for next part, compression process failed" << dendl;
+    return -EIO;
+  }
+
+  compression_block newbl;
+  size_t bs = blocks.size();
+  newbl.old_ofs = logical_offset;
+  newbl.new_ofs = bs > 0 ? blocks[bs-1].len + blocks[bs-1].new_ofs : 0;
+  newbl.len = out.length();
+  blocks.push_back(newbl);
+
+  return Pipe::process(std::move(out), logical_offset);
+}
+
 int RGWPutObj_Compress::process(bufferlist&& in, uint64_t logical_offset)
 {
+  const uint64_t block_size =
+    cct->_conf.get_val<Option::size_t>("rgw_compression_block_size");
+  if (block_size == 0 || in.length() <= block_size) {
+    return process_block(std::move(in), logical_offset);
+  }
+  // compress each block on its own, so that ranged reads decompress less
+  while (in.length() > 0) {
+    bufferlist block;
+    in.splice(0, std::min<uint64_t>(block_size, in.length()), &block);
+    const uint64_t len = block.length();
+    int r = process_block(std::move(block), logical_offset);
+    if (r < 0) {
+      return r;
+    }
+    logical_offset += len;
+  }
+  return 0;
+}
+
+int RGWPutObj_Compress::process_block(bufferlist&& in, uint64_t logical_offset)
+{
+  if (in.length() == 0) {
+    // flush the parts still being compressed first
+    int r = offload.drain();
+    if (r < 0) {
+      return r;
+    }
+    return Pipe::process({}, logical_offset);
+  }
+
+  if (logical_offset > 0 && compressed) { // if previous part was compressed
+    ldout(cct, 10) << "Compression for rgw is enabled, compress part " << in.length() << dendl;
+    return offload.submit(std::move(in), logical_offset);
+  }
+
   bufferlist out;
-  if (in.length() > 0) {
-    // compression stuff
-    if ((logical_offset > 0 && compressed) || // if previous part was compressed
-        (logical_offset == 0)) {              // or it's the first part
-      ldout(cct, 10) << "Compression for rgw is enabled, compress part " << in.length() << dendl;
-      int cr = compressor->compress(in, out, compressor_message);
-      if (cr < 0) {
-        if (logical_offset > 0) {
-          lderr(cct) << "Compression failed with exit code " << cr
-              << " for next part, compression process failed" << dendl;
-          return -EIO;
-        }
-        compressed = false;
-        ldout(cct, 5) << "Compression failed with exit code " << cr
-            << " for first part, storing uncompressed" << dendl;
-        out = std::move(in);
-      } else {
-        compressed = true;
-    
-        compression_block newbl;
-        size_t bs = blocks.size();
-        newbl.old_ofs = logical_offset;
-        newbl.new_ofs = bs > 0 ? blocks[bs-1].len + blocks[bs-1].new_ofs : 0;
-        newbl.len = out.length();
-        blocks.push_back(newbl);
-      }
-    } else {
+  if (logical_offset == 0) { // it's the first part
+    ldout(cct, 10) << "Compression for rgw is enabled, compress part " << in.length() << dendl;
+    int cr = compressor->compress(in, out, compressor_message);
+    if (cr < 0) {
       compressed = false;
+      ldout(cct, 5) << "Compression failed with exit code " << cr
+          << " for first part, storing uncompressed" << dendl;
       out = std::move(in);
+    } else {
+      compressed = true;
+      return emit_part(cr, std::move(out), logical_offset);
     }
-    // end of compression stuff
+  } else {
+    compressed = false;
+    out = std::move(in);
   }
   return Pipe::process(std::move(out), logical_offset);
 }
@@ -81,13 +136,22 @@ int RGWPutObj_Compress::process(bufferlist&& in, uint64_t logical_offset)
 RGWGetObj_Decompress::RGWGetObj_Decompress(CephContext* cct_, 
                                            RGWCompressionInfo* cs_info_, 
                                            bool partial_content_,
-                                           RGWGetObj_Filter* next): RGWGetObj_Filter(next),
+                                           RGWGetObj_Filter* next,
+                                           optional_yield y): RGWGetObj_Filter(next),
                                                                 cct(cct_),
                                                                 cs_info(cs_info_),
                                                                 partial_content(partial_content_),
                                                                 q_ofs(0),
                                                                 q_len(0),
-                                                                cur_ofs(0)
+                                                                cur_ofs(0),
+    offload(cct_,
+            [this] (bufferlist& in, uint64_t, bufferlist& out) {
+              return compressor->decompress(in, out, cs_info->compressor_message);
+            },
+            [this] (int r, bufferlist&& out, uint64_t) {
+              return emit_block(r, std::move(out));
+            },
+            y)
 {
   compressor = Compressor::create(cct, cs_info->compression_type);
   if (!compressor.get())
@@ -104,7 +168,8 @@ int RGWGetObj_Decompress::handle_data(bufferlist& bl, off_t bl_ofs, off_t bl_len
     lderr(cct) << "Cannot load compressor of type " << cs_info->compression_type << dendl;
     return -EIO;
   }
-  bufferlist out_bl, in_bl, temp_in_bl;
+  const bool flushing = (bl_len == 0);
+  bufferlist in_bl, temp_in_bl;
   bl.begin(bl_ofs).copy(bl_len, temp_in_bl);
   bl_ofs = 0;
   int r = 0;
@@ -135,28 +200,54 @@ int RGWGetObj_Decompress::handle_data(bufferlist& bl, off_t bl_ofs, off_t bl_len
       iter_in_bl.seek(ofs_in_bl);
     }
     iter_in_bl.copy(first_block->len, tmp);
-    int cr = compressor->decompress(tmp, out_bl, cs_info->compressor_message);
-    if (cr < 0) {
-      lderr(cct) << "Decompression failed with exit code " << cr << dendl;
-      return cr;
+    r = offload.submit(std::move(tmp), first_block->old_ofs);
+    if (r < 0) {
+      return r;
     }
     ++first_block;
-    while (out_bl.length() - q_ofs >= cct->_conf->rgw_max_chunk_size)
-    {
-      off_t ch_len = std::min<off_t>(cct->_conf->rgw_max_chunk_size, q_len);
-      q_len -= ch_len;
-      r = next->handle_data(out_bl, q_ofs, ch_len);
-      if (r < 0) {
-        lderr(cct) << "handle_data failed with exit code " << r << dendl;
-        return r;
-      }
-      out_bl.splice(0, q_ofs + ch_len);
-      q_ofs = 0;
-    }
   }
 
   cur_ofs += bl_len;
-  off_t ch_len = std::min<off_t>(out_bl.length() - q_ofs, q_len);
+  if (flushing) {
+    r = offload.drain();
+    if (r < 0) {
+      return r;
+    }
+  }
+  return send_ready(true);
+}
+
+int RGWGetObj_Decompress::emit_block(int cr, bufferlist&& out)
+{
+  if (cr < 0) {
+    lderr(cct) << "Decompression failed with exit code " << cr << dendl;
+    return cr;
+  }
+  out_bl.claim_append(out);
+  return send_ready(false);
+}
+
+int RGWGetObj_Decompress::send_ready(bool partial)
+{
+  const off_t max_chunk_size = cct->_conf->rgw_max_chunk_size;
+  int r = 0;
+  while ((off_t)out_bl.length() - q_ofs >= max_chunk_size)
+  {
+    off_t ch_len = std::min<off_t>(max_chunk_size, q_len);
+    q_len -= ch_len;
+    r = next->handle_data(out_bl, q_ofs, ch_len);
+    if (r < 0) {
+      lderr(cct) << "handle_data failed with exit code " << r << dendl;
+      return r;
+    }
+    out_bl.splice(0, q_ofs + ch_len);
+    q_ofs = 0;
+  }
+  if (!partial) {
+    return r;
+  }
+
+  off_t ch_len = std::min<off_t>((off_t)out_bl.length() - q_ofs, q_len);
   if (ch_len > 0) {
     r = next->handle_data(out_bl, q_ofs, ch_len);
     if (r < 0) {
@@ -170,6 +261,19 @@ int RGWGetObj_Decompress::handle_data(bufferlist& bl, off_t bl_ofs, off_t bl_len
   return r;
 }
 
+int RGWGetObj_Decompress::flush()
+{
+  int r = offload.drain();
+  if (r < 0) {
+    return r;
+  }
+  r = send_ready(true);
+  if (r < 0) {
+    return r;
+  }
+  return RGWGetObj_Filter::flush();
+}
+
 int RGWGetObj_Decompress::fixup_range(off_t& ofs, off_t& end)
 {
   if (partial_content) {
@@ -203,6 +307,7 @@ int RGWGetObj_Decompress::fixup_range(off_t& ofs, off_t& end)
 
   cur_ofs = ofs;
   waiting.clear();
+  out_bl.clear();
 
   return next->fixup_range(ofs, end);
 }
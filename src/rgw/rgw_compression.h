@@ -28,15 +28,25 @@ class RGWGetObj_Decompress : public RGWGetObj_Filter
   off_t q_ofs, q_len;
   uint64_t cur_ofs;
   bufferlist waiting;
+  // decompressed data not yet passed on
+  bufferlist out_bl;
+  // decompresses the blocks while the next ones are read
+  rgw::putobj::OrderedOffload offload;
+
+  int emit_block(int r, bufferlist&& out);
+  // pass on the full chunks of out_bl, and what's left of it if partial
+  int send_ready(bool partial);
 public:
   RGWGetObj_Decompress(CephContext* cct_, 
                        RGWCompressionInfo* cs_info_, 
                        bool partial_content_,
-                       RGWGetObj_Filter* next);
+                       RGWGetObj_Filter* next,
+                       optional_yield y);
   ~RGWGetObj_Decompress() override {}
 
   int handle_data(bufferlist& bl, off_t bl_ofs, off_t bl_len) override;
   int fixup_range(off_t& ofs, off_t& end) override;
+  int flush() override;
 
 };
 
@@ -47,10 +57,14 @@ class RGWPutObj_Compress : public rgw::putobj::Pipe
   CompressorRef compressor;
   boost::optional<int32_t> compressor_message;
   std::vector<compression_block> blocks;
+  // compresses the parts after the first one
+  rgw::putobj::OrderedOffload offload;
+
+  int emit_part(int r, bufferlist&& out, uint64_t logical_offset);
+  int process_block(bufferlist&& in, uint64_t logical_offset);
 public:
   RGWPutObj_Compress(CephContext* cct_, CompressorRef compressor,
-                     rgw::putobj::DataProcessor *next)
-    : Pipe(next), cct(cct_), compressor(compressor) {}
+                     rgw::putobj::DataProcessor *next, optional_yield y);
 
   int process(bufferlist&& data, uint64_t logical_offset) override;
 
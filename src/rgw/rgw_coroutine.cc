@@ -1,8 +1,13 @@
 // -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
 // vim: ts=8 sw=2 smarttab ft=cpp
 
+#include <condition_variable>
+#include <thread>
+#include <time.h>
+
 #include "include/Context.h"
 #include "common/ceph_json.h"
+#include "common/Thread.h"
 #include "rgw_coroutine.h"
 
 // re-include our assert to clobber the system one; fix dout:
@@ -13,6 +18,50 @@
 #define dout_subsys ceph_subsys_rgw
 #define dout_context g_ceph_context
 
+/* state of a run context whose stacks are spread over worker threads by
+ * their affinity. The run() caller only waits for io completions and
+ * hands each one to the thread that owns the stack. Everything here is
+ * protected by the manager's lock */
+struct RGWCoroutinesParallelRun {
+  struct Shard {
+    list<RGWCoroutinesStack *> scheduled_stacks;
+    list<RGWCompletionManager::io_completion> completions;
+    std::condition_variable_any cond;
+    RGWCoroutinesEnv env;
+    std::thread thread;
+  };
+  vector<Shard> shards;
+  set<RGWCoroutinesStack *> *context_stacks{nullptr};
+  int blocked_count{0};
+  int interval_wait_count{0};
+  int running{0};
+  bool stopping{false};
+
+  explicit RGWCoroutinesParallelRun(int num_threads) : shards(num_threads) {}
+
+  /* nothing can make progress until some io completes */
+  bool idle() const {
+    if (running > 0 || blocked_count > 0) {
+      return false;
+    }
+    for (auto& shard : shards) {
+      if (!shard.scheduled_stacks.empty() || !shard.completions.empty()) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+static uint64_t thread_cpu_ns()
+{
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) < 0) {
+    return 0;
+  }
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
 
 class RGWCompletionManager::WaitContext : public Context {
   RGWCompletionManager *manager;
@@ -200,6 +249,10 @@ uint64_t RGWCoroutinesManager::get_next_stack_id() {
   return (uint64_t)++max_stack_id;
 }
 
+uint64_t RGWCoroutinesManager::get_next_affinity() {
+  return (uint64_t)++max_affinity;
+}
+
 RGWCoroutinesStack::RGWCoroutinesStack(CephContext *_cct, RGWCoroutinesManager *_ops_mgr, RGWCoroutine *start) : cct(_cct), ops_mgr(_ops_mgr),
                                                                                                          done_flag(false), error_flag(false), blocked_flag(false),
                                                                                                          sleep_flag(false), interval_wait_flag(false), is_scheduled(false), is_waiting_for_child(false),
@@ -245,11 +298,12 @@ int RGWCoroutinesStack::operate(RGWCoroutinesEnv *_env)
     int op_retcode = r;
     r = unwind(op_retcode);
     op->put();
-    done_flag = (pos == ops.end());
-    blocked_flag &= !done_flag;
-    if (done_flag) {
+    bool done = (pos == ops.end());
+    blocked_flag &= !done;
+    if (done) {
       retcode = op_retcode;
     }
+    done_flag = done; /* after retcode, the parent may collect us right away */
     return r;
   }
 
@@ -289,7 +343,8 @@ void RGWCoroutinesStack::_schedule()
   env->manager->_schedule(env, this);
 }
 
-RGWCoroutinesStack *RGWCoroutinesStack::spawn(RGWCoroutine *source_op, RGWCoroutine *op, bool wait)
+RGWCoroutinesStack *RGWCoroutinesStack::spawn(RGWCoroutine *source_op, RGWCoroutine *op, bool wait,
+                                              bool independent)
 {
   if (!op) {
     return NULL;
@@ -305,15 +360,22 @@ RGWCoroutinesStack *RGWCoroutinesStack::spawn(RGWCoroutine *source_op, RGWCorout
 
   s->add_pending(stack);
   stack->parent = this;
+  if (!independent) {
+    stack->affinity = affinity;
+  } else {
+    stack->affinity = env->manager->get_next_affinity();
+    if (env->parallel) {
+      /* we may complete and go away on our thread while the new stack
+       * still needs us on its own */
+      get();
+      stack->holds_parent_ref = true;
+    }
+  }
 
   stack->get(); /* we'll need to collect the stack */
   stack->call(op);
 
-  env->manager->schedule(env, stack);
-
-  if (wait) {
-    set_blocked_by(stack);
-  }
+  env->manager->schedule_spawned(env, this, stack, wait);
 
   return stack;
 }
@@ -477,6 +539,27 @@ RGWCompletionManager *RGWCoroutinesStack::get_completion_mgr()
   return ops_mgr->get_completion_mgr();
 }
 
+bool RGWCoroutinesStack::has_done_children()
+{
+  auto has_done = [](const rgw_spawned_stacks& s) {
+    for (auto stack : s.entries) {
+      if (stack->is_done()) {
+        return true;
+      }
+    }
+    return false;
+  };
+  if (has_done(spawned)) {
+    return true;
+  }
+  for (auto op : ops) {
+    if (has_done(op->spawned)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 bool RGWCoroutinesStack::unblock_stack(RGWCoroutinesStack **s)
 {
   if (blocking_stacks.empty()) {
@@ -508,6 +591,8 @@ void RGWCoroutinesStack::dump(Formatter *f) const {
   ss << (void *)this;
   ::encode_json("stack", ss.str(), f);
   ::encode_json("run_count", run_count, f);
+  ::encode_json("affinity", affinity, f);
+  ::encode_json("cpu_ns", cpu_ns, f);
   f->open_array_section("ops");
   for (auto& i : ops) {
     encode_json("op", *i, f);
@@ -591,13 +676,34 @@ void RGWCoroutinesManager::_schedule(RGWCoroutinesEnv *env, RGWCoroutinesStack *
 {
   ceph_assert(ceph_mutex_is_wlocked(lock));
   if (!stack->is_scheduled) {
-    env->scheduled_stacks->push_back(stack);
+    if (env->parallel) {
+      auto& shards = env->parallel->shards;
+      auto& shard = shards[stack->affinity % shards.size()];
+      shard.scheduled_stacks.push_back(stack);
+      shard.cond.notify_one();
+    } else {
+      env->scheduled_stacks->push_back(stack);
+    }
     stack->set_is_scheduled(true);
   }
   set<RGWCoroutinesStack *>& context_stacks = run_contexts[env->run_context];
   context_stacks.insert(stack);
 }
 
+void RGWCoroutinesManager::schedule_spawned(RGWCoroutinesEnv *env,
+                                            RGWCoroutinesStack *parent,
+                                            RGWCoroutinesStack *stack,
+                                            bool wait)
+{
+  std::unique_lock wl{lock};
+  /* block on the new stack before it can run; on another thread it may
+   * complete before spawn() returns */
+  if (wait) {
+    parent->set_blocked_by(stack);
+  }
+  _schedule(env, stack);
+}
+
 void RGWCoroutinesManager::set_sleeping(RGWCoroutine *cr, bool flag)
 {
   cr->set_sleeping(flag);
@@ -608,8 +714,12 @@ void RGWCoroutinesManager::io_complete(RGWCoroutine *cr, const rgw_io_id& io_id)
   cr->io_complete(io_id);
 }
 
-int RGWCoroutinesManager::run(list<RGWCoroutinesStack *>& stacks)
+int RGWCoroutinesManager::run(list<RGWCoroutinesStack *>& stacks, int num_threads)
 {
+  if (num_threads > 1) {
+    return run_parallel(stacks, num_threads);
+  }
+
   int ret = 0;
   int blocked_count = 0;
   int interval_wait_count = 0;
@@ -627,6 +737,7 @@ int RGWCoroutinesManager::run(list<RGWCoroutinesStack *>& stacks)
     scheduled_stacks.push_back(st);
     st->set_is_scheduled(true);
   }
+  run_queues[run_context].push_back(&scheduled_stacks);
   env.run_context = run_context;
   env.manager = this;
   env.scheduled_stacks = &scheduled_stacks;
@@ -645,9 +756,18 @@ int RGWCoroutinesManager::run(list<RGWCoroutinesStack *>& stacks)
 
     lock.unlock();
 
-    ret = stack->operate(&env);
-
-    lock.lock();
+    /* reading the thread's cpu time is a syscall, so the single-threaded
+     * loop only does it for debugging */
+    if (cct->_conf->subsys.should_gather<ceph_subsys_rgw, 20>()) {
+      const uint64_t start = thread_cpu_ns();
+      ret = stack->operate(&env);
+      const uint64_t cpu_ns = thread_cpu_ns() - start;
+      lock.lock();
+      stack->cpu_ns += cpu_ns;
+    } else {
+      ret = stack->operate(&env);
+      lock.lock();
+    }
 
     stack->set_is_scheduled(false);
     if (ret < 0) {
@@ -767,12 +887,227 @@ next:
     stack->cancel();
   }
   run_contexts.erase(run_context);
+  run_queues.erase(run_context);
+  lock.unlock();
+
+  return ret;
+}
+
+void RGWCoroutinesManager::run_worker(RGWCoroutinesParallelRun& prun, int i)
+{
+  auto& shard = prun.shards[i];
+  auto& context_stacks = *prun.context_stacks;
+
+  std::unique_lock l{lock};
+  for (;;) {
+    while (!shard.completions.empty()) {
+      auto io = shard.completions.front();
+      shard.completions.pop_front();
+      const bool was_throttled =
+        (prun.blocked_count - prun.interval_wait_count >= ops_window);
+      handle_unblocked_stack(context_stacks, shard.scheduled_stacks, io, &prun.blocked_count);
+      if (was_throttled &&
+          prun.blocked_count - prun.interval_wait_count < ops_window) {
+        for (auto& s : prun.shards) {
+          s.cond.notify_one();
+        }
+      }
+    }
+    if (prun.stopping || going_down) {
+      break;
+    }
+    if (shard.scheduled_stacks.empty() ||
+        prun.blocked_count - prun.interval_wait_count >= ops_window) {
+      if (context_stacks.empty() || prun.idle()) {
+        /* let run() notice that we're done */
+        completion_mgr->complete(nullptr, rgw_io_id{get_next_io_id(), -1}, nullptr);
+      }
+      shard.cond.wait(l);
+      continue;
+    }
+
+    RGWCoroutinesStack *stack = shard.scheduled_stacks.front();
+    shard.scheduled_stacks.pop_front();
+    if (context_stacks.find(stack) == context_stacks.end()) {
+      /* stack was probably schedule more than once due to IO, but was since complete */
+      continue;
+    }
+    shard.env.stack = stack;
+    ++prun.running;
+
+    l.unlock();
+
+    const uint64_t start = thread_cpu_ns();
+    int ret = stack->operate(&shard.env);
+    const uint64_t cpu_ns = thread_cpu_ns() - start;
+
+    l.lock();
+
+    --prun.running;
+    stack->cpu_ns += cpu_ns;
+    stack->set_is_scheduled(false);
+    if (ret < 0) {
+      ldout(cct, 20) << "stack->operate() returned ret=" << ret << dendl;
+    }
+
+    if (stack->is_error()) {
+      report_error(stack);
+    }
+
+    bool op_not_blocked = false;
+
+    /* stacks of other threads may have completed while we ran. Those we
+     * were waiting for didn't reschedule us then, as we were still
+     * scheduled, so look at their state again here */
+    if (stack->is_io_blocked()) {
+      ldout(cct, 20) << __func__ << ":" << " stack=" << (void *)stack << " is io blocked" << dendl;
+      if (stack->is_interval_waiting()) {
+        prun.interval_wait_count++;
+      }
+      prun.blocked_count++;
+    } else if (stack->is_blocked()) {
+      ldout(cct, 20) << __func__ << ":" << " stack=" << (void *)stack << " is_blocked_by_stack()=" << stack->is_blocked_by_stack()
+	             << " is_sleeping=" << stack->is_sleeping() << " waiting_for_child()=" << stack->waiting_for_child() << dendl;
+      if (stack->waiting_for_child() && stack->has_done_children()) {
+        stack->set_wait_for_child(false);
+        if (!stack->is_blocked()) {
+          stack->_schedule();
+        }
+      }
+    } else if (stack->is_done()) {
+      ldout(cct, 20) << __func__ << ":" << " stack=" << (void *)stack << " is done" << dendl;
+      RGWCoroutinesStack *s;
+      while (stack->unblock_stack(&s)) {
+        /* a scheduled stack is queued or running, and will be looked at
+         * after it runs */
+	if (!s->is_scheduled && !s->is_blocked_by_stack() && !s->is_done()) {
+	  if (s->is_io_blocked()) {
+            if (stack->is_interval_waiting()) {
+              prun.interval_wait_count++;
+            }
+	    prun.blocked_count++;
+	  } else {
+	    s->_schedule();
+	  }
+	}
+      }
+      if (stack->parent && !stack->parent->is_scheduled &&
+          stack->parent->waiting_for_child()) {
+        stack->parent->set_wait_for_child(false);
+        stack->parent->_schedule();
+      }
+      if (stack->holds_parent_ref) {
+        stack->parent->put();
+      }
+      context_stacks.erase(stack);
+      stack->put();
+      stack = NULL;
+    } else {
+      op_not_blocked = true;
+      stack->run_count++;
+      stack->_schedule();
+    }
+
+    if (!op_not_blocked && stack) {
+      stack->run_count = 0;
+    }
+  }
+}
+
+int RGWCoroutinesManager::run_parallel(list<RGWCoroutinesStack *>& stacks, int num_threads)
+{
+  int ret = 0;
+  RGWCoroutinesParallelRun prun(num_threads);
+
+  uint64_t run_context = ++run_context_count;
+
+  lock.lock();
+  set<RGWCoroutinesStack *>& context_stacks = run_contexts[run_context];
+  prun.context_stacks = &context_stacks;
+  auto& queues = run_queues[run_context];
+  for (auto& shard : prun.shards) {
+    shard.env.run_context = run_context;
+    shard.env.manager = this;
+    shard.env.scheduled_stacks = &shard.scheduled_stacks;
+    shard.env.parallel = &prun;
+    queues.push_back(&shard.scheduled_stacks);
+  }
+  for (auto& st : stacks) {
+    context_stacks.insert(st);
+    st->affinity = get_next_affinity();
+    prun.shards[st->affinity % num_threads].scheduled_stacks.push_back(st);
+    st->set_is_scheduled(true);
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    prun.shards[i].thread = make_named_thread("rgw_cr",
+                                              [this, &prun, i] { run_worker(prun, i); });
+  }
+
+  /* hand the io completions to the threads that own their stacks */
+  while (!context_stacks.empty() && !prun.idle()) {
+    RGWCompletionManager::io_completion io;
+    lock.unlock();
+    int r = completion_mgr->get_next(&io);
+    lock.lock();
+    if (r < 0) {
+      ldout(cct, 5) << "completion_mgr.get_next() returned ret=" << r << dendl;
+    }
+    if (going_down) {
+      ldout(cct, 5) << __func__ << "(): was stopped, exiting" << dendl;
+      ret = -ECANCELED;
+      break;
+    }
+    auto stack = static_cast<RGWCoroutinesStack *>(io.user_info);
+    if (context_stacks.find(stack) == context_stacks.end()) {
+      continue;
+    }
+    auto& shard = prun.shards[stack->affinity % num_threads];
+    shard.completions.push_back(io);
+    shard.cond.notify_one();
+  }
+
+  prun.stopping = true;
+  for (auto& shard : prun.shards) {
+    shard.cond.notify_all();
+  }
+  lock.unlock();
+  for (auto& shard : prun.shards) {
+    shard.thread.join();
+  }
+  lock.lock();
+
+  if (!context_stacks.empty() && !going_down) {
+    JSONFormatter formatter(true);
+    formatter.open_array_section("context_stacks");
+    for (auto& s : context_stacks) {
+      ::encode_json("entry", *s, &formatter);
+    }
+    formatter.close_section();
+    lderr(cct) << __func__ << "(): ERROR: deadlock detected, dumping remaining coroutines:\n";
+    formatter.flush(*_dout);
+    *_dout << dendl;
+    ceph_assert(context_stacks.empty() || going_down); // assert on deadlock
+  }
+
+  vector<RGWCoroutinesStack *> parents;
+  for (auto stack : context_stacks) {
+    ldout(cct, 20) << "clearing stack on run() exit: stack=" << (void *)stack << " nref=" << stack->get_nref() << dendl;
+    if (stack->holds_parent_ref) {
+      parents.push_back(stack->parent);
+    }
+    stack->cancel();
+  }
+  for (auto parent : parents) {
+    parent->put();
+  }
+  run_contexts.erase(run_context);
+  run_queues.erase(run_context);
   lock.unlock();
 
   return ret;
 }
 
-int RGWCoroutinesManager::run(RGWCoroutine *op)
+int RGWCoroutinesManager::run(RGWCoroutine *op, int num_threads)
 {
   if (!op) {
     return 0;
@@ -784,7 +1119,7 @@ int RGWCoroutinesManager::run(RGWCoroutine *op)
 
   stacks.push_back(stack);
 
-  int r = run(stacks);
+  int r = run(stacks, num_threads);
   if (r < 0) {
     ldout(cct, 20) << "run(stacks) returned r=" << r << dendl;
   } else {
@@ -810,6 +1145,15 @@ void RGWCoroutinesManager::dump(Formatter *f) const {
   for (auto& i : run_contexts) {
     f->open_object_section("context");
     ::encode_json("id", i.first, f);
+    auto q = run_queues.find(i.first);
+    if (q != run_queues.end()) {
+      ::encode_json("threads", q->second.size(), f);
+      f->open_array_section("run_queue");
+      for (auto queue : q->second) {
+        ::encode_json("depth", queue->size(), f);
+      }
+      f->close_section();
+    }
     f->open_array_section("entries");
     for (auto& s : i.second) {
       ::encode_json("entry", *s, f);
@@ -909,6 +1253,11 @@ RGWCoroutinesStack *RGWCoroutine::spawn(RGWCoroutine *op, bool wait)
   return stack->spawn(this, op, wait);
 }
 
+RGWCoroutinesStack *RGWCoroutine::spawn_independent(RGWCoroutine *op, bool wait)
+{
+  return stack->spawn(this, op, wait, true);
+}
+
 RGWCoroutinesStack *RGWCoroutine::prealloc_stack()
 {
   return stack->prealloc_stack();
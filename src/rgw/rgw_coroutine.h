@@ -35,9 +35,11 @@
 class RGWCoroutinesStack;
 class RGWCoroutinesManager;
 class RGWAioCompletionNotifier;
+struct RGWCoroutinesParallelRun;
 
 class RGWCompletionManager : public RefCountedObject {
   friend class RGWCoroutinesManager;
+  friend struct RGWCoroutinesParallelRun;
 
   CephContext *cct;
 
@@ -155,8 +157,9 @@ struct RGWCoroutinesEnv {
   RGWCoroutinesManager *manager;
   list<RGWCoroutinesStack *> *scheduled_stacks;
   RGWCoroutinesStack *stack;
+  RGWCoroutinesParallelRun *parallel; /* set if the run context has worker threads */
 
-  RGWCoroutinesEnv() : run_context(0), manager(NULL), scheduled_stacks(NULL), stack(NULL) {}
+  RGWCoroutinesEnv() : run_context(0), manager(NULL), scheduled_stacks(NULL), stack(NULL), parallel(NULL) {}
 };
 
 enum RGWCoroutineState {
@@ -299,6 +302,9 @@ public:
 
   void call(RGWCoroutine *op); /* call at the same stack we're in */
   RGWCoroutinesStack *spawn(RGWCoroutine *op, bool wait); /* execute on a different stack */
+  RGWCoroutinesStack *spawn_independent(RGWCoroutine *op, bool wait); /* execute on a different stack that may run on
+                                                                         another thread of the manager; op must not
+                                                                         share unlocked state with this coroutine */
   bool collect(int *ret, RGWCoroutinesStack *skip_stack, uint64_t *stack_id = nullptr); /* returns true if needs to be called again */
   bool collect_next(int *ret, RGWCoroutinesStack **collected_stack = NULL); /* returns true if found a stack to collect */
 
@@ -445,7 +451,8 @@ class RGWCoroutinesStack : public RefCountedObject {
   map<int64_t, rgw_io_id> io_finish_ids;
   rgw_io_id io_blocked_id;
 
-  bool done_flag;
+  /* read by the parent's collect(), which may run on another thread */
+  std::atomic<bool> done_flag;
   bool error_flag;
   bool blocked_flag;
   bool sleep_flag;
@@ -453,17 +460,23 @@ class RGWCoroutinesStack : public RefCountedObject {
 
   bool is_scheduled;
 
-  bool is_waiting_for_child;
+  std::atomic<bool> is_waiting_for_child;
 
   int retcode;
 
   uint64_t run_count;
 
+  /* stacks with the same affinity always run on the same thread */
+  uint64_t affinity{0};
+  bool holds_parent_ref{false};
+  uint64_t cpu_ns{0};
+
 protected:
   RGWCoroutinesEnv *env;
   RGWCoroutinesStack *parent;
 
-  RGWCoroutinesStack *spawn(RGWCoroutine *source_op, RGWCoroutine *next_op, bool wait);
+  RGWCoroutinesStack *spawn(RGWCoroutine *source_op, RGWCoroutine *next_op, bool wait,
+                            bool independent = false);
   bool collect(RGWCoroutine *op, int *ret, RGWCoroutinesStack *skip_stack, uint64_t *stack_id); /* returns true if needs to be called again */
   bool collect_next(RGWCoroutine *op, int *ret, RGWCoroutinesStack **collected_stack); /* returns true if found a stack to collect */
 public:
@@ -569,6 +582,7 @@ public:
   }
 
   bool unblock_stack(RGWCoroutinesStack **s);
+  bool has_done_children();
 
   RGWCoroutinesEnv *get_env() const { return env; }
 
@@ -630,14 +644,20 @@ class RGWCoroutinesManager {
 
   std::atomic<int64_t> max_io_id = { 0 };
   std::atomic<uint64_t> max_stack_id = { 0 };
+  std::atomic<uint64_t> max_affinity = { 0 };
 
   mutable ceph::shared_mutex lock =
     ceph::make_shared_mutex("RGWCoroutinesManager::lock");
 
+  /* run queues of every run context, for dump() */
+  map<uint64_t, vector<list<RGWCoroutinesStack *> *> > run_queues;
+
   RGWIOIDProvider io_id_provider;
 
   void handle_unblocked_stack(set<RGWCoroutinesStack *>& context_stacks, list<RGWCoroutinesStack *>& scheduled_stacks,
                               RGWCompletionManager::io_completion& io, int *waiting_count);
+  int run_parallel(list<RGWCoroutinesStack *>& stacks, int num_threads);
+  void run_worker(RGWCoroutinesParallelRun& prun, int shard);
 protected:
   RGWCompletionManager *completion_mgr;
   RGWCoroutinesManagerRegistry *cr_registry;
@@ -663,8 +683,10 @@ public:
     }
   }
 
-  int run(list<RGWCoroutinesStack *>& ops);
-  int run(RGWCoroutine *op);
+  /* with num_threads > 1, stacks spawned by spawn_independent() and their
+   * descendants are spread over that many threads */
+  int run(list<RGWCoroutinesStack *>& ops, int num_threads = 1);
+  int run(RGWCoroutine *op, int num_threads = 1);
   void stop() {
     bool expected = false;
     if (going_down.compare_exchange_strong(expected, true)) {
@@ -681,10 +703,13 @@ public:
 
   void schedule(RGWCoroutinesEnv *env, RGWCoroutinesStack *stack);
   void _schedule(RGWCoroutinesEnv *env, RGWCoroutinesStack *stack);
+  void schedule_spawned(RGWCoroutinesEnv *env, RGWCoroutinesStack *parent,
+                        RGWCoroutinesStack *stack, bool wait);
   RGWCoroutinesStack *allocate_stack();
 
   int64_t get_next_io_id();
   uint64_t get_next_stack_id();
+  uint64_t get_next_affinity();
 
   void set_sleeping(RGWCoroutine *cr, bool flag);
   void io_complete(RGWCoroutine *cr, const rgw_io_id& io_id);
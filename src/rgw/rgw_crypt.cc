@@ -529,11 +529,26 @@ int RGWGetObj_BlockDecrypt::flush() {
 
 RGWPutObj_BlockEncrypt::RGWPutObj_BlockEncrypt(CephContext* cct,
                                                rgw::putobj::DataProcessor *next,
-                                               std::unique_ptr<BlockCrypt> crypt)
+                                               std::unique_ptr<BlockCrypt> crypt,
+                                               optional_yield y)
   : Pipe(next),
     cct(cct),
     crypt(std::move(crypt)),
-    block_size(this->crypt->get_block_size())
+    block_size(this->crypt->get_block_size()),
+    offload(cct,
+            [this] (bufferlist& in, uint64_t ofs, bufferlist& out) {
+              if (!this->crypt->encrypt(in, 0, in.length(), out, ofs)) {
+                return -ERR_INTERNAL_ERROR;
+              }
+              return 0;
+            },
+            [this] (int r, bufferlist&& out, uint64_t ofs) {
+              if (r < 0) {
+                return r;
+              }
+              return Pipe::process(std::move(out), ofs);
+            },
+            y)
 {
 }
 
@@ -553,18 +568,18 @@ int RGWPutObj_BlockEncrypt::process(bufferlist&& data, uint64_t logical_offset)
     proc_size = cache.length();
   }
   if (proc_size > 0) {
-    bufferlist in, out;
+    bufferlist in;
     cache.splice(0, proc_size, &in);
-    if (!crypt->encrypt(in, 0, proc_size, out, logical_offset)) {
-      return -ERR_INTERNAL_ERROR;
-    }
-    int r = Pipe::process(std::move(out), logical_offset);
+    int r = offload.submit(std::move(in), logical_offset);
     logical_offset += proc_size;
     if (r < 0)
       return r;
   }
 
   if (flush) {
+    int r = offload.drain();
+    if (r < 0)
+      return r;
     /*replicate 0-sized handle_data*/
     return Pipe::process({}, logical_offset);
   }
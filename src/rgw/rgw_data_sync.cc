@@ -1935,7 +1935,9 @@ public:
             shard_crs_lock.lock();
             shard_crs[iter->first] = cr;
             shard_crs_lock.unlock();
-            spawn(cr, true);
+            /* run_sync() only gives us several threads if the sync module
+             * allows shards to run in parallel */
+            spawn_independent(cr, true);
           }
         }
       }
@@ -1982,6 +1984,9 @@ public:
   bool supports_user_writes() override {
     return true;
   }
+  bool supports_parallel_sync() const override {
+    return true;
+  }
 };
 
 int RGWDefaultSyncModule::create_instance(CephContext *cct, const JSONFormattable& config, RGWSyncModuleInstanceRef *instance)
@@ -2610,7 +2615,14 @@ int RGWRemoteDataLog::run_sync(int num_shards)
   data_sync_cr->get(); // run() will drop a ref, so take another
   lock.unlock();
 
-  int r = run(data_sync_cr);
+  int num_threads = cct->_conf.get_val<int64_t>("rgw_data_sync_threads");
+  if (num_threads > 1 && !sync_env.sync_module->supports_parallel_sync()) {
+    ldpp_dout(dpp, 5) << "sync module doesn't support parallel sync, "
+        "ignoring rgw_data_sync_threads=" << num_threads << dendl;
+    num_threads = 1;
+  }
+
+  int r = run(data_sync_cr, num_threads);
 
   lock.lock();
   data_sync_cr->put();
@@ -3682,6 +3694,20 @@ class RGWBucketShardFullSyncCR : public RGWCoroutine {
 
   int sync_status{0};
 
+  const int spawn_window;
+
+  /* the next page is listed while the current one is fetched */
+  bucket_list_result prefetch_result;
+  rgw_obj_key prefetch_marker;
+  std::optional<uint64_t> prefetch_stack;
+  int prefetch_ret{0};
+
+  /* throughput of this shard's full sync */
+  ceph::coarse_mono_time start_time;
+  std::map<uint64_t, uint64_t> inflight_sizes; // stack id -> object size
+  uint64_t synced_objs{0};
+  uint64_t synced_bytes{0};
+
   const string& status_oid;
 
   rgw_zone_set zones_trace;
@@ -3744,6 +3770,7 @@ public:
     : RGWCoroutine(_sc->cct), sc(_sc), sync_env(_sc->env),
       sync_pipe(_sync_pipe), bs(_sync_pipe.info.source_bs),
       lease_cr(std::move(lease_cr)), sync_info(sync_info),
+      spawn_window(std::max<int>(1, cct->_conf.get_val<int64_t>("rgw_bucket_sync_spawn_window"))),
       status_oid(status_oid),
       tn(sync_env->sync_tracer->add_node(tn_parent, "full_sync",
                                          SSTR(bucket_shard_str{bs}))),
@@ -3753,6 +3780,40 @@ public:
     prefix_handler.set_rules(sync_pipe.get_rules());
   }
 
+  int handle_complete(uint64_t stack_id, int ret) {
+    if (prefetch_stack && *prefetch_stack == stack_id) {
+      prefetch_stack.reset();
+      prefetch_ret = ret;
+      return 0;
+    }
+    auto i = inflight_sizes.find(stack_id);
+    if (i != inflight_sizes.end()) {
+      if (ret >= 0) {
+        ++synced_objs;
+        synced_bytes += i->second;
+      }
+      inflight_sizes.erase(i);
+    }
+    if (ret < 0) {
+      tn->log(10, "a sync operation returned error");
+      sync_status = ret;
+    }
+    return 0;
+  }
+
+  void report_progress() {
+    const double secs = std::max(1.0, std::chrono::duration<double>(
+        ceph::coarse_mono_clock::now() - start_time).count());
+    set_status() << "full sync: objects=" << synced_objs
+        << " bytes=" << synced_bytes
+        << " objs/s=" << (uint64_t)(synced_objs / secs)
+        << " bytes/s=" << (uint64_t)(synced_bytes / secs);
+    tn->log(10, SSTR("full sync progress: objects=" << synced_objs
+        << " bytes=" << synced_bytes
+        << " objs/s=" << (uint64_t)(synced_objs / secs)
+        << " bytes/s=" << (uint64_t)(synced_bytes / secs)));
+  }
+
   int operate() override;
 };
 
@@ -3762,6 +3823,7 @@ int RGWBucketShardFullSyncCR::operate()
     list_marker = sync_info.full_marker.position;
 
     total_entries = sync_info.full_marker.count;
+    start_time = ceph::coarse_mono_clock::now();
     do {
       if (lease_cr && !lease_cr->is_locked()) {
         drain_all();
@@ -3776,8 +3838,26 @@ int RGWBucketShardFullSyncCR::operate()
         break;
       }
 
-      yield call(new RGWListBucketShardCR(sc, bs, list_marker,
-                                          &list_result));
+      /* wait for the listing that was started with the previous page */
+      while (prefetch_stack) {
+        yield wait_for_child();
+        {
+          int ret;
+          uint64_t stack_id;
+          while (collect(&ret, nullptr, &stack_id)) {
+            handle_complete(stack_id, ret);
+          }
+        }
+      }
+      if (!prefetch_marker.empty() && prefetch_marker == list_marker) {
+        retcode = prefetch_ret;
+        list_result = std::move(prefetch_result);
+      } else {
+        /* the policy rules moved the marker to another prefix */
+        yield call(new RGWListBucketShardCR(sc, bs, list_marker,
+                                            &list_result));
+      }
+      prefetch_marker = rgw_obj_key();
       if (retcode < 0 && retcode != -ENOENT) {
         set_status("failed bucket listing, going down");
         drain_all();
@@ -3786,6 +3866,14 @@ int RGWBucketShardFullSyncCR::operate()
       if (list_result.entries.size() > 0) {
         tn->set_flag(RGW_SNS_FLAG_ACTIVE); /* actually have entries to sync */
       }
+      if (list_result.is_truncated && !list_result.entries.empty()) {
+        prefetch_marker = list_result.entries.back().key;
+        prefetch_result = bucket_list_result();
+        prefetch_stack = spawn(new RGWListBucketShardCR(sc, bs, prefetch_marker,
+                                                        &prefetch_result),
+                               false)->get_id();
+      }
+      report_progress();
       entries_iter = list_result.entries.begin();
       for (; entries_iter != list_result.entries.end(); ++entries_iter) {
         if (lease_cr && !lease_cr->is_locked()) {
@@ -3806,33 +3894,29 @@ int RGWBucketShardFullSyncCR::operate()
           tn->log(0, SSTR("ERROR: cannot start syncing " << entry->key << ". Duplicate entry?"));
         } else {
           using SyncCR = RGWBucketSyncSingleEntryCR<rgw_obj_key, rgw_obj_key>;
-          yield spawn(new SyncCR(sc, sync_pipe, entry->key,
-                                 false, /* versioned, only matters for object removal */
-                                 entry->versioned_epoch, entry->mtime,
-                                 entry->owner, entry->get_modify_op(), CLS_RGW_STATE_COMPLETE,
-                                 entry->key, &marker_tracker, zones_trace, tn),
-                      false);
+          yield {
+            auto stack = spawn(new SyncCR(sc, sync_pipe, entry->key,
+                                          false, /* versioned, only matters for object removal */
+                                          entry->versioned_epoch, entry->mtime,
+                                          entry->owner, entry->get_modify_op(), CLS_RGW_STATE_COMPLETE,
+                                          entry->key, &marker_tracker, zones_trace, tn),
+                               false);
+            inflight_sizes[stack->get_id()] = entry->size;
+          }
         }
-        drain_with_cb(BUCKET_SYNC_SPAWN_WINDOW,
+        drain_with_cb(spawn_window + (prefetch_stack ? 1 : 0),
                       [&](uint64_t stack_id, int ret) {
-                if (ret < 0) {
-                  tn->log(10, "a sync operation returned error");
-                  sync_status = ret;
-                }
-                return 0;
-              });
+                        return handle_complete(stack_id, ret);
+                      });
       }
     } while (list_result.is_truncated && sync_status == 0);
     set_status("done iterating over all objects");
     /* wait for all operations to complete */
 
     drain_all_cb([&](uint64_t stack_id, int ret) {
-      if (ret < 0) {
-        tn->log(10, "a sync operation returned error");
-        sync_status = ret;
-      }
-      return 0;
+      return handle_complete(stack_id, ret);
     });
+    report_progress();
     tn->unset_flag(RGW_SNS_FLAG_ACTIVE);
     if (lease_cr && !lease_cr->is_locked()) {
       return set_cr_error(-ECANCELED);
@@ -3889,6 +3973,8 @@ class RGWBucketShardIncrementalSyncCR : public RGWCoroutine {
   int sync_status{0};
   bool syncstopped{false};
 
+  const int spawn_window;
+
   RGWSyncTraceNodeRef tn;
   RGWBucketIncSyncShardMarkerTrack marker_tracker;
 
@@ -3905,6 +3991,7 @@ public:
       sync_pipe(_sync_pipe), bs(_sync_pipe.info.source_bs),
       lease_cr(std::move(lease_cr)), sync_info(sync_info),
       zone_id(sync_env->svc->zone->get_zone().id),
+      spawn_window(std::max<int>(1, cct->_conf.get_val<int64_t>("rgw_bucket_sync_spawn_window"))),
       tn(sync_env->sync_tracer->add_node(_tn_parent, "inc_sync",
                                          SSTR(bucket_shard_str{bs}))),
       marker_tracker(sc, status_oid, sync_info.inc_marker, tn,
@@ -4110,7 +4197,7 @@ int RGWBucketShardIncrementalSyncCR::operate()
                   false);
           }
         // }
-        drain_with_cb(BUCKET_SYNC_SPAWN_WINDOW,
+        drain_with_cb(spawn_window,
                       [&](uint64_t stack_id, int ret) {
                 if (ret < 0) {
                   tn->log(10, "a sync operation returned error");
@@ -0,0 +1,328 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+#include <errno.h>
+#include <unistd.h>
+
+#if __has_include(<filesystem>)
+#include <filesystem>
+namespace fs = std::filesystem;
+#elif __has_include(<experimental/filesystem>)
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/post.hpp>
+
+#include "common/Thread.h"
+#include "common/errno.h"
+
+#include "rgw_datacache.h"
+#include "rgw_perf_counters.h"
+
+#define dout_subsys ceph_subsys_rgw
+#undef dout_prefix
+#define dout_prefix (*_dout << "rgw datacache: ")
+
+RGWDataCache::RGWDataCache(CephContext *_cct)
+  : cct(_cct),
+    path(cct->_conf.get_val<std::string>("rgw_datacache_path")),
+    capacity(cct->_conf.get_val<Option::size_t>("rgw_datacache_size"))
+{}
+
+RGWDataCache::~RGWDataCache()
+{
+  stop();
+}
+
+int RGWDataCache::start()
+{
+  // chunk files are only meaningful to the process that wrote them
+  try {
+    fs::create_directories(path);
+    for (auto& f : fs::directory_iterator(path)) {
+      if (fs::is_regular_file(f.status())) {
+	fs::remove(f.path());
+      }
+    }
+  } catch (const fs::filesystem_error& e) {
+    lderr(cct) << "ERROR: failed to prepare " << path << ": " << e.what()
+	       << dendl;
+    return -e.code().value();
+  }
+
+  const auto num_threads =
+    std::max<uint64_t>(1, cct->_conf.get_val<uint64_t>("rgw_datacache_threads"));
+  for (uint64_t i = 0; i < num_threads; ++i) {
+    workers.emplace_back(make_named_thread("rgw_datacache",
+					   &RGWDataCache::run, this));
+  }
+
+  ldout(cct, 1) << "caching up to " << capacity << " bytes in " << path
+		<< dendl;
+  return 0;
+}
+
+void RGWDataCache::stop()
+{
+  {
+    std::lock_guard l{lock};
+    stopping = true;
+  }
+  cond.notify_all();
+  for (auto& t : workers) {
+    t.join();
+  }
+  workers.clear();
+}
+
+std::string RGWDataCache::get_key(const rgw_raw_obj& obj, off_t ofs, off_t len)
+{
+  std::string key = obj.pool.to_str();
+  key.reserve(key.size() + obj.oid.size() + obj.loc.size() + 48);
+  key.append("/").append(obj.loc).append("/")
+    .append(obj.oid).append("/").append(std::to_string(ofs))
+    .append("/").append(std::to_string(len));
+  return key;
+}
+
+std::string RGWDataCache::file_path(uint64_t file_id) const
+{
+  return path + "/" + std::to_string(file_id);
+}
+
+bool RGWDataCache::evict(uint64_t need)
+{
+  // called with lock held; entries being read or written are skipped
+  auto i = lru.end();
+  while (used + need > capacity && i != lru.begin()) {
+    --i;
+    auto e = entries.find(*i);
+    if (e->second.readers || !e->second.ready) {
+      continue;
+    }
+    used -= e->second.len;
+    Job job{Job::REMOVE};
+    job.file_id = e->second.file_id;
+    jobs.push_back(std::move(job));
+    entries.erase(e);
+    i = lru.erase(i);
+    if (perfcounter) {
+      perfcounter->inc(l_rgw_datacache_evict);
+    }
+  }
+  return used + need <= capacity;
+}
+
+void RGWDataCache::queue(Job&& job)
+{
+  {
+    std::lock_guard l{lock};
+    jobs.push_back(std::move(job));
+  }
+  cond.notify_one();
+}
+
+bool RGWDataCache::get(const std::string& key, rgw::Aio::OpFunc& op,
+		       optional_yield y)
+{
+  std::unique_lock l{lock};
+  auto i = entries.find(key);
+  if (i == entries.end() || !i->second.ready) {
+    l.unlock();
+    if (perfcounter) {
+      perfcounter->inc(l_rgw_datacache_miss);
+    }
+    return false;
+  }
+
+  auto& e = i->second;
+  ++e.readers;
+  lru.splice(lru.begin(), lru, e.lru_iter);
+  const uint64_t file_id = e.file_id;
+  const uint64_t len = e.len;
+  l.unlock();
+
+  ldout(cct, 20) << "hit key=" << key << " file=" << file_id << dendl;
+  if (perfcounter) {
+    perfcounter->inc(l_rgw_datacache_hit);
+    perfcounter->inc(l_rgw_datacache_hit_b, len);
+  }
+
+  op = [this, key, file_id, y, fallback = std::move(op)]
+    (rgw::Aio* aio, rgw::AioResult& r) mutable {
+    Job job{Job::READ};
+    job.key = key;
+    job.file_id = file_id;
+    if (y) {
+      // complete on the yield_context's strand executor, like the
+      // librados completions, so the throttle needs no locking
+      using namespace boost::asio;
+      async_completion<spawn::yield_context, void()> init(y.get_yield_context());
+      auto ex = get_associated_executor(init.completion_handler);
+      job.done = [aio, &r, ex, fallback = std::move(fallback)]
+	(int ret, bufferlist&& bl) mutable {
+	post(ex, [aio, &r, ret, bl = std::move(bl),
+		  fallback = std::move(fallback)] () mutable {
+	  if (ret < 0) {
+	    std::move(fallback)(aio, r);
+	    return;
+	  }
+	  r.result = 0;
+	  r.data = std::move(bl);
+	  aio->put(r);
+	});
+      };
+    } else {
+      job.done = [aio, &r, fallback = std::move(fallback)]
+	(int ret, bufferlist&& bl) mutable {
+	if (ret < 0) {
+	  std::move(fallback)(aio, r);
+	  return;
+	}
+	r.result = 0;
+	r.data = std::move(bl);
+	aio->put(r);
+      };
+    }
+    queue(std::move(job));
+  };
+  return true;
+}
+
+void RGWDataCache::put(const std::string& key, const bufferlist& bl)
+{
+  const uint64_t len = bl.length();
+  if (len == 0 || len > capacity) {
+    return;
+  }
+
+  std::unique_lock l{lock};
+  if (stopping || entries.count(key)) {
+    return;
+  }
+  if (!evict(len)) {
+    // everything left is busy; skip rather than wait
+    return;
+  }
+
+  auto& e = entries[key];
+  e.file_id = next_file_id++;
+  e.len = len;
+  lru.push_front(key);
+  e.lru_iter = lru.begin();
+  used += len;
+
+  Job job{Job::WRITE};
+  job.key = key;
+  job.file_id = e.file_id;
+  job.bl = bl;
+  jobs.push_back(std::move(job));
+  l.unlock();
+  cond.notify_one();
+}
+
+void RGWDataCache::do_read(Job& job)
+{
+  bufferlist bl;
+  std::string err;
+  int r = bl.read_file(file_path(job.file_id).c_str(), &err);
+  if (r >= 0) {
+    // only serve the chunk the file was written for
+    std::string file_key;
+    try {
+      auto p = bl.cbegin();
+      decode(file_key, p);
+      bl.splice(0, p.get_off());
+    } catch (const buffer::error&) {
+      file_key.clear();
+    }
+    if (file_key != job.key) {
+      err = "file holds another chunk";
+      r = -EIO;
+    }
+  }
+
+  {
+    std::lock_guard l{lock};
+    auto i = entries.find(job.key);
+    if (i != entries.end() && i->second.file_id == job.file_id) {
+      auto& e = i->second;
+      --e.readers;
+      if (r >= 0 && bl.length() != e.len) {
+	err = "unexpected length " + std::to_string(bl.length());
+	r = -EIO;
+      }
+      if (r < 0 && e.readers == 0) {
+	used -= e.len;
+	lru.erase(e.lru_iter);
+	entries.erase(i);
+      }
+    }
+  }
+
+  if (r < 0) {
+    ldout(cct, 0) << "WARNING: failed to read " << file_path(job.file_id)
+		  << " for key=" << job.key << ": " << err
+		  << ", reading from rados" << dendl;
+    ::unlink(file_path(job.file_id).c_str());
+    bl.clear();
+  }
+  std::move(job.done)(r, std::move(bl));
+}
+
+void RGWDataCache::do_write(Job& job)
+{
+  bufferlist bl;
+  encode(job.key, bl);
+  bl.append(job.bl);
+  int r = bl.write_file(file_path(job.file_id).c_str(), 0600);
+
+  std::lock_guard l{lock};
+  auto i = entries.find(job.key);
+  if (i == entries.end() || i->second.file_id != job.file_id) {
+    return;
+  }
+  if (r < 0) {
+    ldout(cct, 0) << "WARNING: failed to write " << file_path(job.file_id)
+		  << ": " << cpp_strerror(r) << dendl;
+    used -= i->second.len;
+    lru.erase(i->second.lru_iter);
+    entries.erase(i);
+    return;
+  }
+  i->second.ready = true;
+  if (perfcounter) {
+    perfcounter->inc(l_rgw_datacache_write_b, job.bl.length());
+  }
+}
+
+void RGWDataCache::run()
+{
+  std::unique_lock l{lock};
+  for (;;) {
+    cond.wait(l, [this] { return stopping || !jobs.empty(); });
+    if (jobs.empty()) {
+      break; // stopping
+    }
+    Job job = std::move(jobs.front());
+    jobs.pop_front();
+    l.unlock();
+
+    switch (job.op) {
+    case Job::READ:
+      do_read(job);
+      break;
+    case Job::WRITE:
+      do_write(job);
+      break;
+    case Job::REMOVE:
+      ::unlink(file_path(job.file_id).c_str());
+      break;
+    }
+
+    l.lock();
+  }
+}
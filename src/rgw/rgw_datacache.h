@@ -0,0 +1,89 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+#pragma once
+
+#include <deque>
+#include <list>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "common/ceph_mutex.h"
+#include "include/function2.hpp"
+#include "rgw_aio.h"
+#include "rgw_common.h"
+
+/*
+ * Read-through cache of object data chunks on a local filesystem
+ * (rgw_datacache_path, meant for NVMe or tmpfs). Chunks are keyed by
+ * the rados tail object, offset and length they were read from. Tail
+ * objects are never rewritten in place: an overwrite writes a new head
+ * whose manifest names new tail objects. A chunk therefore can't go
+ * stale, and entries of replaced objects just age out of the LRU.
+ * Each file starts with the key of its chunk, which is checked before the
+ * chunk is served.
+ *
+ * File reads, writes and removals run on the cache's own threads, so
+ * frontend threads never block on the local disk.
+ */
+class RGWDataCache {
+  struct Entry {
+    uint64_t file_id{0};
+    uint64_t len{0};
+    uint32_t readers{0};
+    bool ready{false};
+    std::list<std::string>::iterator lru_iter;
+  };
+
+  struct Job {
+    enum { READ, WRITE, REMOVE } op;
+    std::string key;
+    uint64_t file_id{0};
+    bufferlist bl;
+    // called with the file contents, or with the error if they
+    // couldn't be read
+    fu2::unique_function<void(int, bufferlist&&)> done;
+  };
+
+  CephContext *cct;
+  std::string path;
+  uint64_t capacity;
+
+  ceph::mutex lock = ceph::make_mutex("RGWDataCache::lock");
+  ceph::condition_variable cond;
+  std::unordered_map<std::string, Entry> entries;
+  std::list<std::string> lru;
+  uint64_t used{0};
+  uint64_t next_file_id{0};
+
+  std::deque<Job> jobs;
+  std::vector<std::thread> workers;
+  bool stopping{false};
+
+  std::string file_path(uint64_t file_id) const;
+  bool evict(uint64_t need);
+  void queue(Job&& job);
+  void run();
+  void do_read(Job& job);
+  void do_write(Job& job);
+
+public:
+  explicit RGWDataCache(CephContext *_cct);
+  ~RGWDataCache();
+
+  int start();
+  void stop();
+
+  static std::string get_key(const rgw_raw_obj& obj, off_t ofs, off_t len);
+
+  /* on a hit, wrap the rados read in an op that serves the chunk from
+   * the local file instead and return true; the rados read is only
+   * issued if the file can't be read. The entry stays pinned until
+   * the file read is done */
+  bool get(const std::string& key, rgw::Aio::OpFunc& op, optional_yield y);
+
+  /* keep a chunk that was read from rados */
+  void put(const std::string& key, const bufferlist& bl);
+};
@@ -84,6 +84,29 @@ private:
 				    optional_yield) = 0;
 };
 
+/*
+ * Second scheduling stage, for authenticated requests. Requests are queued
+ * by their user, then by their bucket, so that a noisy tenant only delays
+ * itself.
+ */
+class TenantScheduler {
+public:
+  /// queue a request by its user, then by its bucket unless empty. returns
+  /// -EAGAIN if either is over its limits. on success, the request must be
+  /// given back with request_complete()
+  virtual int schedule_request(const std::string& user,
+                               const std::string& bucket,
+                               optional_yield y) = 0;
+
+  /// give back a request granted by schedule_request(), with the bytes it
+  /// transferred
+  virtual void request_complete(const std::string& user,
+                                const std::string& bucket,
+                                uint64_t bytes) = 0;
+
+  virtual ~TenantScheduler() {};
+};
+
 } // namespace rgw::dmclock
 
 #endif // RGW_DMCLOCK_SCHEDULER_H
@@ -0,0 +1,392 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+#include "common/split.h"
+#include "common/strtol.h"
+#include "rgw_dmclock_tenant.h"
+
+#define dout_subsys ceph_subsys_rgw
+
+namespace rgw::dmclock {
+
+static const std::string user_prefix = "user:";
+static const std::string bucket_prefix = "bucket:";
+
+TenantConfig::TenantConfig(CephContext *cct)
+  : cct(cct)
+{
+  update(cct->_conf);
+}
+
+const char** TenantConfig::get_tracked_conf_keys() const
+{
+  static const char* keys[] = {
+    "rgw_dmclock_user_res",
+    "rgw_dmclock_user_wgt",
+    "rgw_dmclock_user_lim",
+    "rgw_dmclock_user_bytes_lim",
+    "rgw_dmclock_bucket_res",
+    "rgw_dmclock_bucket_wgt",
+    "rgw_dmclock_bucket_lim",
+    "rgw_dmclock_bucket_bytes_lim",
+    "rgw_dmclock_tenant_tags",
+    nullptr
+  };
+  return keys;
+}
+
+void TenantConfig::handle_conf_change(const ConfigProxy& conf,
+                                      const std::set<std::string>& changed)
+{
+  update(conf);
+}
+
+void TenantConfig::update(const ConfigProxy& conf)
+{
+  Tags user;
+  user.res = conf.get_val<double>("rgw_dmclock_user_res");
+  user.wgt = conf.get_val<double>("rgw_dmclock_user_wgt");
+  user.lim = conf.get_val<double>("rgw_dmclock_user_lim");
+  user.bytes_lim = conf.get_val<Option::size_t>("rgw_dmclock_user_bytes_lim");
+  Tags bucket;
+  bucket.res = conf.get_val<double>("rgw_dmclock_bucket_res");
+  bucket.wgt = conf.get_val<double>("rgw_dmclock_bucket_wgt");
+  bucket.lim = conf.get_val<double>("rgw_dmclock_bucket_lim");
+  bucket.bytes_lim = conf.get_val<Option::size_t>("rgw_dmclock_bucket_bytes_lim");
+
+  // <user|bucket>:<name>=<res>,<wgt>,<lim>[,<bytes_lim>]
+  std::map<std::string, Tags> tags;
+  const auto str = conf.get_val<std::string>("rgw_dmclock_tenant_tags");
+  for (std::string_view entry : ceph::split(str, " \t\n;")) {
+    const auto eq = entry.find('=');
+    const auto tenant = entry.substr(0, eq);
+    if (eq == entry.npos ||
+        (tenant.compare(0, user_prefix.size(), user_prefix) != 0 &&
+         tenant.compare(0, bucket_prefix.size(), bucket_prefix) != 0)) {
+      lderr(cct) << "WARNING: ignoring rgw_dmclock_tenant_tags entry "
+          << entry << dendl;
+      continue;
+    }
+    std::vector<double> vals;
+    std::string err;
+    for (std::string_view v : ceph::split(entry.substr(eq + 1), ",")) {
+      vals.push_back(strict_strtod(std::string{v}.c_str(), &err));
+      if (!err.empty() || vals.back() < 0) {
+        break;
+      }
+    }
+    if (!err.empty() || vals.size() < 3 || vals.size() > 4 ||
+        vals.back() < 0) {
+      lderr(cct) << "WARNING: ignoring rgw_dmclock_tenant_tags entry "
+          << entry << dendl;
+      continue;
+    }
+    auto& t = tags[std::string{tenant}];
+    t.res = vals[0];
+    t.wgt = vals[1];
+    t.lim = vals[2];
+    if (vals.size() > 3) {
+      t.bytes_lim = vals[3];
+    }
+  }
+
+  std::lock_guard l{mutex};
+  user_tags = user;
+  bucket_tags = bucket;
+  user_info = ClientInfo(user.res, user.wgt, user.lim);
+  bucket_info = ClientInfo(bucket.res, bucket.wgt, bucket.lim);
+  overrides = std::move(tags);
+  for (auto& [tenant, info] : infos) {
+    update_info(tenant);
+  }
+  for (auto& [tenant, t] : overrides) {
+    update_info(tenant);
+  }
+}
+
+TenantConfig::Tags TenantConfig::effective(const std::string& tenant) const
+{
+  Tags t;
+  if (auto i = overrides.find(tenant); i != overrides.end()) {
+    t = i->second;
+  } else if (tenant.compare(0, user_prefix.size(), user_prefix) == 0) {
+    t = user_tags;
+  } else {
+    t = bucket_tags;
+  }
+
+  auto r = remote.find(tenant);
+  if (r != remote.end() && r->second.gateways) {
+    const double n = r->second.gateways + 1;
+    if (t.lim > 0) {
+      t.lim = std::max(t.lim - r->second.ops, t.lim / n);
+    }
+    if (t.bytes_lim > 0) {
+      t.bytes_lim = std::max(t.bytes_lim - r->second.bytes, t.bytes_lim / n);
+    }
+  }
+  return t;
+}
+
+void TenantConfig::update_info(const std::string& tenant)
+{
+  const auto t = effective(tenant);
+  infos.insert_or_assign(tenant, ClientInfo(t.res, t.wgt, t.lim));
+}
+
+ClientInfo* TenantConfig::operator()(const std::string& tenant)
+{
+  std::lock_guard l{mutex};
+  if (auto i = infos.find(tenant); i != infos.end()) {
+    return &i->second;
+  }
+  if (tenant.compare(0, user_prefix.size(), user_prefix) == 0) {
+    return &user_info;
+  }
+  return &bucket_info;
+}
+
+TenantConfig::Tags TenantConfig::get_tags(const std::string& tenant)
+{
+  std::lock_guard l{mutex};
+  return effective(tenant);
+}
+
+void TenantConfig::set_remote(std::map<std::string, RemoteUsage>&& usage)
+{
+  std::lock_guard l{mutex};
+  auto old = std::move(remote);
+  remote = std::move(usage);
+  for (auto& [tenant, u] : old) {
+    if (!remote.count(tenant)) {
+      update_info(tenant);
+    }
+  }
+  for (auto& [tenant, u] : remote) {
+    update_info(tenant);
+  }
+}
+
+AsyncTenantScheduler::AsyncTenantScheduler(CephContext *cct,
+                                           boost::asio::io_context& context)
+  : cct(cct), config(cct),
+    queue(std::ref(config), AtLimit::Reject),
+    timer(context)
+{
+  set_max_requests(cct->_conf);
+  cct->_conf.add_observer(this);
+}
+
+AsyncTenantScheduler::~AsyncTenantScheduler()
+{
+  cancel();
+  cct->_conf.remove_observer(this);
+}
+
+const char** AsyncTenantScheduler::get_tracked_conf_keys() const
+{
+  static const char* keys[] = {
+    "rgw_dmclock_user_res",
+    "rgw_dmclock_user_wgt",
+    "rgw_dmclock_user_lim",
+    "rgw_dmclock_user_bytes_lim",
+    "rgw_dmclock_bucket_res",
+    "rgw_dmclock_bucket_wgt",
+    "rgw_dmclock_bucket_lim",
+    "rgw_dmclock_bucket_bytes_lim",
+    "rgw_dmclock_tenant_tags",
+    "rgw_dmclock_tenant_max_requests",
+    "rgw_max_concurrent_requests",
+    nullptr
+  };
+  return keys;
+}
+
+void AsyncTenantScheduler::handle_conf_change(const ConfigProxy& conf,
+                                              const std::set<std::string>& changed)
+{
+  config.handle_conf_change(conf, changed);
+  set_max_requests(conf);
+  queue.update_client_infos();
+  schedule(crimson::dmclock::TimeZero);
+}
+
+void AsyncTenantScheduler::set_max_requests(const ConfigProxy& conf)
+{
+  auto max = conf.get_val<int64_t>("rgw_dmclock_tenant_max_requests");
+  if (max <= 0) {
+    max = conf.get_val<int64_t>("rgw_max_concurrent_requests");
+  }
+  max_requests = max > 0 ? max : std::numeric_limits<int64_t>::max();
+}
+
+int AsyncTenantScheduler::schedule_request(const std::string& user,
+                                           const std::string& bucket,
+                                           optional_yield y)
+{
+  int r = schedule(user_prefix + user, y);
+  if (r < 0 || bucket.empty()) {
+    return r;
+  }
+  // a request holds a single slot of max_requests: the one of its last
+  // stage. otherwise requests granted by the user stage could take every
+  // slot, and their bucket stage would never be pulled
+  release();
+  return schedule(bucket_prefix + bucket, y);
+}
+
+void AsyncTenantScheduler::request_complete(const std::string& user,
+                                            const std::string& bucket,
+                                            uint64_t bytes)
+{
+  release();
+  charge(user_prefix + user, bytes);
+  if (!bucket.empty()) {
+    charge(bucket_prefix + bucket, bytes);
+  }
+}
+
+int AsyncTenantScheduler::schedule(const std::string& tenant, optional_yield y)
+{
+  ceph_assert(y);
+
+  const auto tags = config.get_tags(tenant);
+  const auto now = get_time();
+  if (tags.bytes_lim > 0 && !admit_bytes(tenant, tags.bytes_lim, now)) {
+    ldout(cct, 10) << "tenant " << tenant << " over its bytes/s limit" << dendl;
+    return -EAGAIN;
+  }
+
+  auto& yield = y.get_yield_context();
+  boost::system::error_code ec;
+  async_request(tenant, now, 1, yield[ec]);
+  if (ec) {
+    if (ec == boost::system::errc::resource_unavailable_try_again) {
+      ldout(cct, 10) << "tenant " << tenant << " over its ops/s limit" << dendl;
+      return -EAGAIN;
+    }
+    return -ec.value();
+  }
+
+  if (track_usage && (tags.lim > 0 || tags.bytes_lim > 0)) {
+    std::lock_guard l{mutex};
+    ++usage[tenant].first;
+  }
+  return 0;
+}
+
+bool AsyncTenantScheduler::admit_bytes(const std::string& tenant, double bytes_lim,
+                                       const Time& now)
+{
+  std::lock_guard l{mutex};
+  // start with a second's worth
+  auto [i, inserted] = byte_buckets.try_emplace(tenant,
+                                                ByteBucket{bytes_lim, now});
+  auto& b = i->second;
+  b.avail = std::min(bytes_lim, b.avail + (now - b.stamp) * bytes_lim);
+  b.stamp = now;
+  return b.avail > 0;
+}
+
+void AsyncTenantScheduler::release()
+{
+  --outstanding_requests;
+  schedule(crimson::dmclock::TimeZero);
+}
+
+void AsyncTenantScheduler::charge(const std::string& tenant, uint64_t bytes)
+{
+  if (!bytes) {
+    return;
+  }
+  const auto tags = config.get_tags(tenant);
+  if (tags.lim <= 0 && tags.bytes_lim <= 0) {
+    return;
+  }
+
+  const auto now = get_time();
+  std::lock_guard l{mutex};
+  if (track_usage) {
+    usage[tenant].second += bytes;
+  }
+  if (tags.bytes_lim > 0) {
+    auto i = byte_buckets.find(tenant);
+    if (i != byte_buckets.end()) {
+      i->second.avail -= bytes;
+    }
+  }
+
+  // forget the tenants that are idle and out of debt
+  if (++completions % 4096 == 0) {
+    for (auto i = byte_buckets.begin(); i != byte_buckets.end();) {
+      if (now - i->second.stamp > 10 && i->second.avail > 0) {
+        i = byte_buckets.erase(i);
+      } else {
+        ++i;
+      }
+    }
+  }
+}
+
+std::map<std::string, std::pair<uint64_t, uint64_t>> AsyncTenantScheduler::take_usage()
+{
+  std::lock_guard l{mutex};
+  return std::exchange(usage, {});
+}
+
+void AsyncTenantScheduler::set_remote_usage(std::map<std::string, RemoteUsage>&& usage)
+{
+  config.set_remote(std::move(usage));
+  queue.update_client_infos();
+}
+
+void AsyncTenantScheduler::cancel()
+{
+  queue.remove_by_req_filter([&] (RequestRef&& request) {
+      auto c = static_cast<Completion*>(request.release());
+      Completion::dispatch(std::unique_ptr<Completion>{c},
+                           boost::asio::error::operation_aborted,
+                           PhaseType::priority);
+      return true;
+    });
+  timer.cancel();
+}
+
+void AsyncTenantScheduler::schedule(const Time& time)
+{
+  timer.expires_at(Clock::from_double(time));
+  timer.async_wait([this] (boost::system::error_code ec) {
+      // process requests unless the wait was canceled. note that a canceled
+      // wait may execute after this AsyncTenantScheduler destructs
+      if (ec != boost::asio::error::operation_aborted) {
+        process(get_time());
+      }
+    });
+}
+
+void AsyncTenantScheduler::process(const Time& now)
+{
+  assert(get_executor().running_in_this_thread());
+
+  while (outstanding_requests < max_requests) {
+    auto pull = queue.pull_request(now);
+
+    if (pull.is_none()) {
+      timer.cancel();
+      break;
+    }
+    if (pull.is_future()) {
+      schedule(pull.getTime());
+      break;
+    }
+    ++outstanding_requests;
+
+    auto& r = pull.get_retn();
+    auto phase = r.phase;
+    auto c = static_cast<Completion*>(r.request.release());
+    Completion::post(std::unique_ptr<Completion>{c},
+                     boost::system::error_code{}, phase);
+  }
+}
+
+} // namespace rgw::dmclock
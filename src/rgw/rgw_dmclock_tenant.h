@@ -0,0 +1,201 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+#ifndef RGW_DMCLOCK_TENANT_H
+#define RGW_DMCLOCK_TENANT_H
+
+#include <map>
+#include <string>
+
+#include <boost/asio.hpp>
+
+#include "common/async/completion.h"
+#include "common/async/yield_context.h"
+#include "common/ceph_mutex.h"
+#include "rgw_dmclock_scheduler.h"
+
+namespace rgw::dmclock {
+  namespace async = ceph::async;
+
+/// usage of a tenant by the other gateways, as a rate
+struct RemoteUsage {
+  double ops = 0; //< ops/s
+  double bytes = 0; //< bytes/s
+  uint32_t gateways = 0; //< number of gateways reporting it
+};
+
+/*
+ * QoS tags of users and buckets. Tenants are keyed "user:<uid>" and
+ * "bucket:<tenant/name>". Each gets the rgw_dmclock_user_* or
+ * rgw_dmclock_bucket_* tags, unless rgw_dmclock_tenant_tags names it.
+ *
+ * Limits are fleet-wide when usage is shared between gateways: a tenant's
+ * limit here is what the other gateways left of it, but never less than an
+ * even split.
+ */
+class TenantConfig : public md_config_obs_t {
+ public:
+  struct Tags {
+    double res = 0; //< ops/s
+    double wgt = 1;
+    double lim = 0; //< ops/s, 0 for none
+    double bytes_lim = 0; //< bytes/s, 0 for none
+  };
+
+  explicit TenantConfig(CephContext *cct);
+
+  /// dmclock ClientInfoFunc
+  ClientInfo* operator()(const std::string& tenant);
+
+  /// effective tags of a tenant
+  Tags get_tags(const std::string& tenant);
+
+  /// replace the usage by other gateways
+  void set_remote(std::map<std::string, RemoteUsage>&& usage);
+
+  const char** get_tracked_conf_keys() const override;
+  void handle_conf_change(const ConfigProxy& conf,
+                          const std::set<std::string>& changed) override;
+
+ private:
+  CephContext *const cct;
+  ceph::mutex mutex = ceph::make_mutex("rgw::dmclock::TenantConfig");
+  Tags user_tags;
+  Tags bucket_tags;
+  std::map<std::string, Tags> overrides;
+  std::map<std::string, RemoteUsage> remote;
+
+  ClientInfo user_info{0, 1, 0};
+  ClientInfo bucket_info{0, 1, 0};
+  /// tenants that don't use the defaults. dmclock keeps pointers to these,
+  /// so entries are reset rather than erased
+  std::map<std::string, ClientInfo> infos;
+
+  void update(const ConfigProxy& conf);
+  Tags effective(const std::string& tenant) const;
+  void update_info(const std::string& tenant);
+};
+
+struct TenantRequest {
+  std::string tenant;
+  Time started;
+  Cost cost;
+};
+
+/*
+ * A dmclock TenantScheduler whose requests complete on a boost::asio
+ * executor. Requests over a tenant's ops/s or bytes/s limit are rejected.
+ * Bytes are charged once the request is done, so a tenant over its bytes/s
+ * limit is rejected until it has paid back.
+ */
+class AsyncTenantScheduler : public md_config_obs_t, public TenantScheduler {
+ public:
+  AsyncTenantScheduler(CephContext *cct, boost::asio::io_context& context);
+  ~AsyncTenantScheduler();
+
+  using executor_type = boost::asio::io_context::executor_type;
+
+  executor_type get_executor() noexcept {
+    return timer.get_executor();
+  }
+
+  int schedule_request(const std::string& user, const std::string& bucket,
+                       optional_yield y) override;
+
+  void request_complete(const std::string& user, const std::string& bucket,
+                        uint64_t bytes) override;
+
+  /// cancel all queued requests, completing them with operation_aborted
+  void cancel();
+
+  /// start or stop counting usage for take_usage()
+  void set_track_usage(bool track) { track_usage = track; }
+
+  /// usage of limited tenants since the last call, as ops and bytes
+  std::map<std::string, std::pair<uint64_t, uint64_t>> take_usage();
+
+  /// replace the usage by other gateways
+  void set_remote_usage(std::map<std::string, RemoteUsage>&& usage);
+
+  const char** get_tracked_conf_keys() const override;
+  void handle_conf_change(const ConfigProxy& conf,
+                          const std::set<std::string>& changed) override;
+
+ private:
+  CephContext *const cct;
+  TenantConfig config;
+
+  static constexpr bool IsDelayed = false;
+  using Queue = crimson::dmclock::PullPriorityQueue<std::string, TenantRequest, IsDelayed>;
+  using RequestRef = typename Queue::RequestRef;
+  Queue queue;
+
+  using Signature = void(boost::system::error_code, PhaseType);
+  using Completion = async::Completion<Signature, async::AsBase<TenantRequest>>;
+
+  using Clock = ceph::coarse_real_clock;
+  using Timer = boost::asio::basic_waitable_timer<Clock,
+        boost::asio::wait_traits<Clock>, executor_type>;
+  Timer timer;
+
+  /// concurrency beyond which requests wait their turn
+  std::atomic<int64_t> max_requests;
+  std::atomic<int64_t> outstanding_requests = 0;
+
+  struct ByteBucket {
+    double avail; //< bytes; negative when in debt
+    Time stamp;
+  };
+  ceph::mutex mutex = ceph::make_mutex("rgw::dmclock::AsyncTenantScheduler");
+  std::map<std::string, ByteBucket> byte_buckets;
+  uint64_t completions = 0;
+  std::atomic<bool> track_usage{false};
+  std::map<std::string, std::pair<uint64_t, uint64_t>> usage;
+
+  /// wait for a tenant's turn, taking a slot of max_requests
+  int schedule(const std::string& tenant, optional_yield y);
+  /// give back a slot of max_requests
+  void release();
+  /// charge a tenant for the bytes of a completed request
+  void charge(const std::string& tenant, uint64_t bytes);
+  bool admit_bytes(const std::string& tenant, double bytes_lim,
+                   const Time& now);
+
+  template <typename CompletionToken>
+  auto async_request(const std::string& tenant, const Time& time, Cost cost,
+                     CompletionToken&& token);
+
+  void set_max_requests(const ConfigProxy& conf);
+  void schedule(const Time& time);
+  void process(const Time& now);
+};
+
+template <typename CompletionToken>
+auto AsyncTenantScheduler::async_request(const std::string& tenant,
+                                         const Time& time, Cost cost,
+                                         CompletionToken&& token)
+{
+  boost::asio::async_completion<CompletionToken, Signature> init(token);
+
+  auto ex1 = get_executor();
+  auto& handler = init.completion_handler;
+
+  auto completion = Completion::create(ex1, std::move(handler),
+                                       TenantRequest{tenant, time, cost});
+  auto req = RequestRef{std::move(completion)};
+  int r = queue.add_request(std::move(req), tenant, {}, time, cost);
+  if (r == 0) {
+    schedule(crimson::dmclock::TimeZero);
+  } else {
+    boost::system::error_code ec(r, boost::system::system_category());
+    auto completion = static_cast<Completion*>(req.release());
+    async::post(std::unique_ptr<Completion>{completion},
+                ec, PhaseType::priority);
+  }
+
+  return init.result.get();
+}
+
+} // namespace rgw::dmclock
+
+#endif /* RGW_DMCLOCK_TENANT_H */
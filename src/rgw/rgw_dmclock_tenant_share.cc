@@ -0,0 +1,157 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+#include "common/Thread.h"
+#include "common/errno.h"
+
+#include "rgw_dmclock_tenant_share.h"
+#include "rgw_sal_rados.h"
+#include "rgw_tools.h"
+#include "rgw_zone.h"
+#include "services/svc_zone.h"
+
+#define dout_subsys ceph_subsys_rgw
+#undef dout_prefix
+#define dout_prefix (*_dout << "rgw tenant qos: ")
+
+namespace rgw::dmclock {
+
+static const std::string usage_oid = "qos.tenant_usage";
+
+TenantUsageShare::TenantUsageShare(CephContext *cct,
+                                   rgw::sal::RGWRadosStore *store,
+                                   AsyncTenantScheduler *scheduler)
+  : cct(cct), store(store), scheduler(scheduler),
+    key(store->getRados()->host_id)
+{}
+
+TenantUsageShare::~TenantUsageShare()
+{
+  stop();
+}
+
+void TenantUsageShare::start()
+{
+  scheduler->set_track_usage(true);
+  thread = make_named_thread("rgw_qos_share", &TenantUsageShare::run, this);
+}
+
+void TenantUsageShare::stop()
+{
+  {
+    std::lock_guard l{mutex};
+    stopping = true;
+  }
+  cond.notify_all();
+  if (thread.joinable()) {
+    thread.join();
+  }
+  scheduler->set_track_usage(false);
+}
+
+void TenantUsageShare::run()
+{
+  librados::IoCtx ioctx;
+  const auto& pool = store->svc()->zone->get_zone_params().log_pool;
+  int r = rgw_init_ioctx(store->getRados()->get_rados_handle(), pool,
+                         ioctx, true);
+  if (r < 0) {
+    lderr(cct) << "ERROR: failed to open " << pool << ": "
+        << cpp_strerror(r) << ", not sharing usage" << dendl;
+    return;
+  }
+
+  std::unique_lock l{mutex};
+  while (!stopping) {
+    const uint32_t interval = std::max<int64_t>(1,
+      cct->_conf.get_val<int64_t>("rgw_dmclock_tenant_share_interval"));
+    cond.wait_for(l, std::chrono::seconds(interval));
+    if (stopping) {
+      break;
+    }
+    l.unlock();
+    r = share(ioctx, interval);
+    if (r < 0) {
+      ldout(cct, 0) << "WARNING: failed to share tenant usage: "
+          << cpp_strerror(r) << dendl;
+    }
+    l.lock();
+  }
+}
+
+int TenantUsageShare::share(librados::IoCtx& ioctx, uint32_t interval)
+{
+  TenantUsageRecord record;
+  record.stamp = ceph::real_clock::now();
+  record.interval = interval;
+  record.usage = scheduler->take_usage();
+
+  {
+    bufferlist bl;
+    encode(record, bl);
+    librados::ObjectWriteOperation op;
+    op.create(false);
+    op.omap_set({{key, std::move(bl)}});
+    int r = ioctx.operate(usage_oid, &op);
+    if (r < 0) {
+      return r;
+    }
+  }
+
+  // add up the others' records. records of gateways that stopped sharing
+  // no longer count after a few intervals, and are removed a while later
+  std::map<std::string, RemoteUsage> remote;
+  std::set<std::string> stale;
+  std::string marker;
+  bool more = true;
+  while (more) {
+    std::map<std::string, bufferlist> vals;
+    int r = ioctx.omap_get_vals2(usage_oid, marker, 1000, &vals, &more);
+    if (r < 0) {
+      return r;
+    }
+    for (auto& [k, bl] : vals) {
+      marker = k;
+      if (k == key) {
+        continue;
+      }
+      TenantUsageRecord other;
+      try {
+        auto p = bl.cbegin();
+        decode(other, p);
+      } catch (const buffer::error&) {
+        stale.insert(k);
+        continue;
+      }
+      const auto age = std::chrono::duration_cast<std::chrono::seconds>(
+        record.stamp - other.stamp).count();
+      const int64_t period = std::max<uint32_t>(other.interval, interval);
+      if (age > 10 * period) {
+        stale.insert(k);
+        continue;
+      }
+      if (age > 3 * period || other.interval == 0) {
+        continue;
+      }
+      for (auto& [tenant, u] : other.usage) {
+        auto& ru = remote[tenant];
+        ru.ops += double(u.first) / other.interval;
+        ru.bytes += double(u.second) / other.interval;
+        ++ru.gateways;
+      }
+    }
+  }
+
+  if (!stale.empty()) {
+    librados::ObjectWriteOperation op;
+    op.omap_rm_keys(stale);
+    ioctx.operate(usage_oid, &op);
+  }
+
+  ldout(cct, 20) << "shared usage of " << record.usage.size()
+      << " tenants, " << remote.size() << " used elsewhere" << dendl;
+  scheduler->set_remote_usage(std::move(remote));
+  return 0;
+}
+
+} // namespace rgw::dmclock
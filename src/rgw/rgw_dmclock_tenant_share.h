@@ -0,0 +1,77 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+#ifndef RGW_DMCLOCK_TENANT_SHARE_H
+#define RGW_DMCLOCK_TENANT_SHARE_H
+
+#include <map>
+#include <string>
+#include <thread>
+
+#include "include/encoding.h"
+#include "include/rados/librados.hpp"
+#include "common/ceph_mutex.h"
+#include "common/ceph_time.h"
+#include "rgw_dmclock_tenant.h"
+
+namespace rgw::sal { class RGWRadosStore; }
+
+namespace rgw::dmclock {
+
+/// one gateway's usage of the limited tenants over an interval
+struct TenantUsageRecord {
+  ceph::real_time stamp;
+  uint32_t interval = 0; //< seconds
+  std::map<std::string, std::pair<uint64_t, uint64_t>> usage; //< ops, bytes
+
+  void encode(bufferlist& bl) const {
+    ENCODE_START(1, 1, bl);
+    encode(stamp, bl);
+    encode(interval, bl);
+    encode(usage, bl);
+    ENCODE_FINISH(bl);
+  }
+  void decode(bufferlist::const_iterator& bl) {
+    DECODE_START(1, bl);
+    decode(stamp, bl);
+    decode(interval, bl);
+    decode(usage, bl);
+    DECODE_FINISH(bl);
+  }
+};
+WRITE_CLASS_ENCODER(TenantUsageRecord)
+
+/*
+ * Shares the usage of limited tenants between the gateways of a zone, so
+ * that their limits hold for the whole fleet behind a load balancer.
+ * Every rgw_dmclock_tenant_share_interval seconds each gateway writes its
+ * usage under its own omap key of one object in the log pool, and reads
+ * back the others'. That's a write and a read per gateway and interval,
+ * whatever the request rate.
+ */
+class TenantUsageShare {
+  CephContext *const cct;
+  rgw::sal::RGWRadosStore *const store;
+  AsyncTenantScheduler *const scheduler;
+  const std::string key; //< this gateway's omap key
+
+  ceph::mutex mutex = ceph::make_mutex("rgw::dmclock::TenantUsageShare");
+  ceph::condition_variable cond;
+  bool stopping = false;
+  std::thread thread;
+
+  void run();
+  int share(librados::IoCtx& ioctx, uint32_t interval);
+
+ public:
+  TenantUsageShare(CephContext *cct, rgw::sal::RGWRadosStore *store,
+                   AsyncTenantScheduler *scheduler);
+  ~TenantUsageShare();
+
+  void start();
+  void stop();
+};
+
+} // namespace rgw::dmclock
+
+#endif /* RGW_DMCLOCK_TENANT_SHARE_H */
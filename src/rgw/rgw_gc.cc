@@ -296,18 +296,40 @@ class RGWGCIOManager {
       IndexIO = 2,
     } type{UnknownIO};
     librados::AioCompletion *c{nullptr};
-    string oid;
     int index{-1};
-    string tag;
+    /* the tail objects removed by a TailIO batch, as (oid, tag) */
+    std::vector<std::pair<string, string>> objs;
+    std::unique_ptr<std::vector<int>> rvals;
+    size_t num_ops{1}; // charged against max_aio
+  };
+
+  /* tail removes waiting to be sent, one batch per pool and locator */
+  struct Batch {
+    IoCtx ioctx;
+    int index{-1};
+    std::vector<ObjectWriteOperation> ops;
+    std::vector<std::pair<string, string>> objs;
   };
 
   deque<IO> ios;
+  size_t ios_ops{0}; // rados ops in flight in ios
+  std::map<std::pair<string, string>, Batch> batches;
+  size_t batch_size;
   vector<std::vector<string> > remove_tags;
   /* tracks the number of remaining shadow objects for a given tag in order to
    * only remove the tag once all shadow objects have themselves been removed
    */
   vector<map<string, size_t> > tag_io_size;
 
+  /* tail objects sent and completed, to tell when the queue entries of a
+   * listing page are done with */
+  uint64_t scheduled{0};
+  uint64_t completed{0};
+  vector<bool> queue_failed;
+
+  uint64_t retired{0};
+  uint64_t removed{0};
+
 #define MAX_AIO_DEFAULT 10
   size_t max_aio{MAX_AIO_DEFAULT};
 
@@ -316,73 +338,181 @@ public:
                                                   cct(_cct),
                                                   gc(_gc),
                                                   remove_tags(cct->_conf->rgw_gc_max_objs),
-                                                  tag_io_size(cct->_conf->rgw_gc_max_objs) {
+                                                  tag_io_size(cct->_conf->rgw_gc_max_objs),
+                                                  queue_failed(cct->_conf->rgw_gc_max_objs) {
     max_aio = cct->_conf->rgw_gc_max_concurrent_io;
+    /* a batch never takes more than the whole io budget */
+    batch_size = std::clamp<int64_t>(
+      cct->_conf.get_val<int64_t>("rgw_gc_batch_size"), 1,
+      std::max<size_t>(1, max_aio));
   }
 
   ~RGWGCIOManager() {
-    for (auto io : ios) {
+    for (auto& io : ios) {
+      if (io.rvals && !io.c->is_complete()) {
+        /* the batch still writes its results there */
+        io.rvals.release();
+      }
       io.c->release();
     }
   }
 
-  int schedule_io(IoCtx *ioctx, const string& oid, ObjectWriteOperation *op,
+  uint64_t get_scheduled() const { return scheduled; }
+  uint64_t get_completed() const { return completed; }
+  bool has_queue_failed(int index) const { return queue_failed[index]; }
+  uint64_t get_retired() const { return retired; }
+  uint64_t get_removed() const { return removed; }
+
+  void reset_queue_state(int index) {
+    queue_failed[index] = false;
+  }
+
+  /* queue the removal of a tail object. removals are sent in batches of
+   * rgw_gc_batch_size per pool. each removal in a batch counts against
+   * rgw_gc_max_concurrent_io */
+  int schedule_io(const string& pool, const string& loc, const string& oid,
 		  int index, const string& tag) {
-    while (ios.size() > max_aio) {
+    auto key = std::make_pair(pool, loc);
+    auto b = batches.find(key);
+    if (b == batches.end()) {
+      Batch batch;
+      int ret = rgw_init_ioctx(gc->get_rados_handle(), pool, batch.ioctx);
+      if (ret < 0) {
+        ldpp_dout(dpp, 0) << "ERROR: failed to create ioctx pool=" <<
+          pool << dendl;
+        return ret;
+      }
+      batch.ioctx.locator_set_key(loc);
+      batch.index = index;
+      batch.ops.reserve(batch_size);
+      b = batches.emplace(std::move(key), std::move(batch)).first;
+    }
+
+    auto& batch = b->second;
+    batch.ops.emplace_back();
+    cls_refcount_put(batch.ops.back(), tag, true);
+    batch.objs.emplace_back(oid, tag);
+    if (batch.ops.size() >= batch_size) {
+      int ret = send_batch(batch);
+      batches.erase(b);
+      return ret;
+    }
+    return 0;
+  }
+
+  int send_batch(Batch& batch) {
+    if (batch.ops.empty()) {
+      return 0;
+    }
+    while (!ios.empty() && ios_ops + batch.ops.size() > max_aio) {
       if (gc->going_down()) {
-        return 0;
+        /* the batch is dropped, so the queue entries of its tail objects
+         * must stay for the next gc pass */
+        if (gc->transitioned_objects_cache[batch.index]) {
+          queue_failed[batch.index] = true;
+        }
+        return -EAGAIN;
       }
       auto ret = handle_next_completion();
       //Return error if we are using queue, else ignore it
-      if (gc->transitioned_objects_cache[index] && ret < 0) {
+      if (gc->transitioned_objects_cache[batch.index] && ret < 0) {
         return ret;
       }
     }
 
-    auto c = librados::Rados::aio_create_completion(nullptr, nullptr);
-    int ret = ioctx->aio_operate(oid, c, op);
+    std::vector<std::pair<std::string, ObjectWriteOperation*>> ops;
+    ops.reserve(batch.ops.size());
+    for (size_t i = 0; i < batch.ops.size(); ++i) {
+      ops.emplace_back(batch.objs[i].first, &batch.ops[i]);
+    }
+    IO io{IO::TailIO};
+    io.index = batch.index;
+    io.rvals = std::make_unique<std::vector<int>>();
+    io.c = librados::Rados::aio_create_completion(nullptr, nullptr);
+    int ret = batch.ioctx.aio_operate_batch(ops, io.c, io.rvals.get(), 0);
     if (ret < 0) {
+      io.c->release();
+      if (gc->transitioned_objects_cache[batch.index]) {
+        queue_failed[batch.index] = true;
+      }
       return ret;
     }
-    ios.push_back(IO{IO::TailIO, c, oid, index, tag});
-
+    ldpp_dout(dpp, 20) << __func__ << " sent " << ops.size()
+      << " removes on gc shard index=" << batch.index << dendl;
+    scheduled += ops.size();
+    io.num_ops = ops.size();
+    io.objs = std::move(batch.objs);
+    ios_ops += io.num_ops;
+    ios.push_back(std::move(io));
     return 0;
   }
 
+  /* send what's left in partial batches */
+  int flush_batches() {
+    int ret_val = 0;
+    for (auto& [key, batch] : batches) {
+      int ret = send_batch(batch);
+      if (ret < 0) {
+        ldpp_dout(dpp, 0) << "WARNING: failed to send gc batch on pool=" <<
+          key.first << " ret=" << ret << dendl;
+        ret_val = ret;
+      }
+    }
+    batches.clear();
+    return ret_val;
+  }
+
   int handle_next_completion() {
     ceph_assert(!ios.empty());
     IO& io = ios.front();
     io.c->wait_for_complete();
     int ret = io.c->get_return_value();
     io.c->release();
+    ios_ops -= io.num_ops;
 
-    if (ret == -ENOENT) {
-      ret = 0;
-    }
-
-    if (io.type == IO::IndexIO && ! gc->transitioned_objects_cache[io.index]) {
-      if (ret < 0) {
+    if (io.type == IO::IndexIO) {
+      if (ret < 0 && ret != -ENOENT) {
         ldpp_dout(dpp, 0) << "WARNING: gc cleanup of tags on gc shard index=" <<
 	  io.index << " returned error, ret=" << ret << dendl;
       }
-      goto done;
+      ios.pop_front();
+      return (ret == -ENOENT ? 0 : ret);
     }
 
-    if (ret < 0) {
-      ldpp_dout(dpp, 0) << "WARNING: gc could not remove oid=" << io.oid <<
-	", ret=" << ret << dendl;
-      goto done;
-    }
-
-    if (! gc->transitioned_objects_cache[io.index]) {
-      schedule_tag_removal(io.index, io.tag);
+    ret = 0;
+    for (size_t i = 0; i < io.objs.size(); ++i) {
+      int r = (*io.rvals)[i];
+      if (r == -ENOENT) {
+        r = 0;
+      }
+      if (r < 0) {
+        ldpp_dout(dpp, 0) << "WARNING: gc could not remove oid=" <<
+          io.objs[i].first << ", ret=" << r << dendl;
+        if (gc->transitioned_objects_cache[io.index]) {
+          queue_failed[io.index] = true;
+        }
+        if (ret == 0) {
+          ret = r;
+        }
+        continue;
+      }
+      ++removed;
+      if (! gc->transitioned_objects_cache[io.index]) {
+        schedule_tag_removal(io.index, io.objs[i].second);
+      }
     }
-
-  done:
+    completed += io.objs.size();
     ios.pop_front();
     return ret;
   }
 
+  /* handle the completions that are already in, without waiting */
+  void reap_completions() {
+    while (!ios.empty() && ios.front().c->is_complete()) {
+      handle_next_completion();
+    }
+  }
+
   /* This is a request to schedule a tag removal. It will be called once when
    * there are no shadow objects. But it will also be called for every shadow
    * object when there are any. Since we do not want the tag to be removed
@@ -416,7 +546,7 @@ public:
   }
 
   int drain_ios() {
-    int ret_val = 0;
+    int ret_val = flush_batches();
     while (!ios.empty()) {
       if (gc->going_down()) {
         return -EAGAIN;
@@ -465,7 +595,9 @@ public:
       /* log the count of tags retired for rate estimation */
       perfcounter->inc(l_rgw_gc_retire, rt.size());
     }
-    ios.push_back(index_io);
+    retired += rt.size();
+    ios_ops += index_io.num_ops;
+    ios.push_back(std::move(index_io));
   }
 
   void flush_remove_tags() {
@@ -489,6 +621,7 @@ public:
       /* log the count of tags retired for rate estimation */
       perfcounter->inc(l_rgw_gc_retire, num_entries);
     }
+    retired += num_entries;
     return 0;
   }
 }; // class RGWGCIOManger
@@ -501,7 +634,8 @@ int RGWGC::process(int index, int max_secs, bool expired_only,
     expired_only << dendl;
 
   rados::cls::lock::Lock l(gc_index_lock_name);
-  utime_t end = ceph_clock_now();
+  const utime_t start = ceph_clock_now();
+  utime_t end = start;
 
   /* max_secs should be greater than zero. We don't want a zero max_secs
    * to be translated as no timeout, since we'd then need to break the
@@ -526,7 +660,32 @@ int RGWGC::process(int index, int max_secs, bool expired_only,
   string marker;
   string next_marker;
   bool truncated;
-  IoCtx *ctx = new IoCtx;
+  /* listing pages of the queue whose entries wait for their tail removes,
+   * as (tail objects scheduled at the end of the page, entries) */
+  std::deque<std::pair<uint64_t, int>> pages;
+  /* remove the entries of the pages at the head of the queue whose tail
+   * removes are all done. the next pages are listed and their removes
+   * sent in the meantime */
+  auto trim_pages = [&] {
+    if (io_manager.has_queue_failed(index)) {
+      return 0;
+    }
+    int num_entries = 0;
+    while (!pages.empty() &&
+	   io_manager.get_completed() >= pages.front().first) {
+      num_entries += pages.front().second;
+      pages.pop_front();
+    }
+    if (num_entries == 0) {
+      return 0;
+    }
+    ldpp_dout(this, 5) << "RGWGC::process removing " << num_entries <<
+      " entries, marker: " << marker << dendl;
+    return io_manager.remove_queue_entries(index, num_entries);
+  };
+  const uint64_t retired = io_manager.get_retired();
+  const uint64_t removed = io_manager.get_removed();
+  io_manager.reset_queue_state(index);
   do {
     int max = 100;
     std::list<cls_rgw_gc_obj_info> entries;
@@ -576,7 +735,6 @@ int RGWGC::process(int index, int max_secs, bool expired_only,
 
     marker = next_marker;
 
-    string last_pool;
     std::list<cls_rgw_gc_obj_info>::iterator iter;
     for (iter = entries.begin(); iter != entries.end(); ++iter) {
       cls_rgw_gc_obj_info& info = *iter;
@@ -603,32 +761,12 @@ int RGWGC::process(int index, int max_secs, bool expired_only,
 	for (liter = chain.objs.begin(); liter != chain.objs.end(); ++liter) {
 	  cls_rgw_obj& obj = *liter;
 
-	  if (obj.pool != last_pool) {
-	    delete ctx;
-	    ctx = new IoCtx;
-	    ret = rgw_init_ioctx(store->get_rados_handle(), obj.pool, *ctx);
-	    if (ret < 0) {
-        if (transitioned_objects_cache[index]) {
-          goto done;
-        }
-	      last_pool = "";
-	      ldpp_dout(this, 0) << "ERROR: failed to create ioctx pool=" <<
-		obj.pool << dendl;
-	      continue;
-	    }
-	    last_pool = obj.pool;
-	  }
-
-	  ctx->locator_set_key(obj.loc);
-
 	  const string& oid = obj.key.name; /* just stored raw oid there */
 
 	  ldpp_dout(this, 5) << "RGWGC::process removing " << obj.pool <<
 	    ":" << obj.key.name << dendl;
-	  ObjectWriteOperation op;
-	  cls_refcount_put(op, info.tag, true);
 
-	  ret = io_manager.schedule_io(ctx, oid, &op, index, info.tag);
+	  ret = io_manager.schedule_io(obj.pool, obj.loc, oid, index, info.tag);
 	  if (ret < 0) {
 	    ldpp_dout(this, 0) <<
 	      "WARNING: failed to schedule deletion for oid=" << oid << dendl;
@@ -646,13 +784,13 @@ int RGWGC::process(int index, int max_secs, bool expired_only,
       } // else -- chains not empty
     } // entries loop
     if (transitioned_objects_cache[index] && entries.size() > 0) {
-      ret = io_manager.drain_ios();
+      ret = io_manager.flush_batches();
       if (ret < 0) {
         goto done;
       }
-      //Remove the entries from the queue
-      ldpp_dout(this, 5) << "RGWGC::process removing entries, marker: " << marker << dendl;
-      ret = io_manager.remove_queue_entries(index, entries.size());
+      pages.emplace_back(io_manager.get_scheduled(), entries.size());
+      io_manager.reap_completions();
+      ret = trim_pages();
       if (ret < 0) {
         ldpp_dout(this, 0) <<
           "WARNING: failed to remove queue entries" << dendl;
@@ -661,16 +799,135 @@ int RGWGC::process(int index, int max_secs, bool expired_only,
     }
   } while (truncated);
 
+  if (transitioned_objects_cache[index] && !pages.empty()) {
+    ret = io_manager.drain_ios();
+    if (ret < 0) {
+      goto done;
+    }
+  }
+
 done:
   /* we don't drain here, because if we're going down we don't want to
-   * hold the system if backend is unresponsive
+   * hold the system if backend is unresponsive; only the entries whose
+   * removes already completed are taken off the queue. batches are
+   * sent though, as a batch only holds removes of one gc shard
    */
+  io_manager.flush_batches();
+  if (transitioned_objects_cache[index]) {
+    io_manager.reap_completions();
+    if (trim_pages() < 0) {
+      ldpp_dout(this, 0) <<
+        "WARNING: failed to remove queue entries" << dendl;
+    }
+  }
+  put_stats(index, start, io_manager.get_retired() - retired,
+            io_manager.get_removed() - removed);
   l.unlock(&store->gc_pool_ctx, obj_names[index]);
-  delete ctx;
 
   return 0;
 }
 
+void RGWGC::put_stats(int index, const utime_t& start, uint64_t retired,
+                      uint64_t removed)
+{
+  RGWGCShardStats stats;
+  stats.last_run = start;
+  stats.duration = ceph_clock_now() - start;
+  stats.retired = retired;
+  stats.removed = removed;
+  bufferlist bl;
+  encode(stats, bl);
+  int ret = store->gc_pool_ctx.setxattr(obj_names[index], RGW_GC_STATS_ATTR, bl);
+  if (ret < 0) {
+    ldpp_dout(this, 5) << "WARNING: failed to write stats of gc shard index=" <<
+      index << " ret=" << ret << dendl;
+  }
+}
+
+int RGWGC::throughput(uint64_t max_backlog,
+                      std::vector<RGWGCThroughput>& result)
+{
+  result.clear();
+  result.resize(max_objs);
+  for (int i = 0; i < max_objs; i++) {
+    auto& t = result[i];
+    t.index = i;
+
+    bufferlist bl;
+    int ret = store->gc_pool_ctx.getxattr(obj_names[i], RGW_GC_STATS_ATTR, bl);
+    if (ret >= 0) {
+      try {
+        auto iter = bl.cbegin();
+        decode(t.last, iter);
+      } catch (buffer::error& err) {
+        ldpp_dout(this, 0) << "ERROR: failed to decode stats of gc shard index="
+          << i << dendl;
+      }
+    } else if (ret != -ENOENT && ret != -ENODATA) {
+      return ret;
+    }
+
+    /* count the expired entries of both the omap log and the queue */
+    string marker, next_marker;
+    bool truncated = true;
+    while (truncated && t.backlog < max_backlog) {
+      std::list<cls_rgw_gc_obj_info> entries;
+      ret = cls_rgw_gc_list(store->gc_pool_ctx, obj_names[i], marker,
+                            std::min<uint64_t>(1000, max_backlog - t.backlog),
+                            true, entries, &truncated, next_marker);
+      if (ret == -ENOENT) {
+        break;
+      }
+      if (ret < 0) {
+        return ret;
+      }
+      t.backlog += entries.size();
+      marker = next_marker;
+    }
+    marker.clear();
+    truncated = true;
+    while (truncated && t.backlog < max_backlog) {
+      std::list<cls_rgw_gc_obj_info> entries;
+      ret = cls_rgw_gc_queue_list_entries(store->gc_pool_ctx, obj_names[i],
+                                          marker,
+                                          std::min<uint64_t>(1000, max_backlog - t.backlog),
+                                          true, entries, &truncated, next_marker);
+      if (ret == -ENOENT) {
+        break;
+      }
+      if (ret < 0) {
+        return ret;
+      }
+      t.backlog += entries.size();
+      marker = next_marker;
+    }
+    t.backlog_truncated = (t.backlog >= max_backlog);
+  }
+  return 0;
+}
+
+void RGWGCShardStats::dump(Formatter *f) const
+{
+  encode_json("last_run", last_run, f);
+  encode_json("duration", duration, f);
+  encode_json("retired", retired, f);
+  encode_json("removed", removed, f);
+}
+
+void RGWGCThroughput::dump(Formatter *f) const
+{
+  encode_json("index", index, f);
+  encode_json("backlog", backlog, f);
+  encode_json("backlog_truncated", backlog_truncated, f);
+  encode_json("last_pass", last, f);
+  const double secs = std::max(last.duration.to_double(), 1.0);
+  const double rate = last.retired / secs;
+  encode_json("drain_rate", rate, f);
+  if (rate > 0) {
+    encode_json("est_drain_secs", uint64_t(backlog / rate), f);
+  }
+}
+
 int RGWGC::process(bool expired_only)
 {
   int max_secs = cct->_conf->rgw_gc_processor_max_time;
@@ -19,6 +19,46 @@
 
 class RGWGCIOManager;
 
+#define RGW_GC_STATS_ATTR "rgw.gc_stats"
+
+/* what the last gc pass over a gc shard did, kept in an xattr of the
+ * shard object */
+struct RGWGCShardStats {
+  utime_t last_run;
+  utime_t duration;
+  uint64_t retired{0}; // gc entries retired
+  uint64_t removed{0}; // tail objects removed
+
+  void encode(bufferlist& bl) const {
+    ENCODE_START(1, 1, bl);
+    encode(last_run, bl);
+    encode(duration, bl);
+    encode(retired, bl);
+    encode(removed, bl);
+    ENCODE_FINISH(bl);
+  }
+  void decode(bufferlist::const_iterator& bl) {
+    DECODE_START(1, bl);
+    decode(last_run, bl);
+    decode(duration, bl);
+    decode(retired, bl);
+    decode(removed, bl);
+    DECODE_FINISH(bl);
+  }
+  void dump(Formatter *f) const;
+};
+WRITE_CLASS_ENCODER(RGWGCShardStats)
+
+/* the backlog of a gc shard and the rate its last pass drained it at */
+struct RGWGCThroughput {
+  int index{0};
+  uint64_t backlog{0}; // expired entries
+  bool backlog_truncated{false};
+  RGWGCShardStats last;
+
+  void dump(Formatter *f) const;
+};
+
 class RGWGC : public DoutPrefixProvider {
   CephContext *cct;
   RGWRados *store;
@@ -29,6 +69,8 @@ class RGWGC : public DoutPrefixProvider {
   static constexpr uint64_t seed = 8675309;
 
   int tag_index(const string& tag);
+  void put_stats(int index, const utime_t& start, uint64_t retired,
+                 uint64_t removed);
 
   class GCWorker : public Thread {
     const DoutPrefixProvider *dpp;
@@ -71,6 +113,12 @@ public:
               RGWGCIOManager& io_manager);
   int process(bool expired_only);
 
+  /* report the backlog of every gc shard, counting up to max_backlog
+   * entries of each, and what its last pass did */
+  int throughput(uint64_t max_backlog, std::vector<RGWGCThroughput>& result);
+
+  librados::Rados* get_rados_handle() { return store->get_rados_handle(); }
+
   bool going_down();
   void start_processor();
   void stop_processor();
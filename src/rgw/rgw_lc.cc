@@ -7,6 +7,8 @@
 #include <algorithm>
 #include <tuple>
 #include <functional>
+#include <deque>
+#include <thread>
 
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string.hpp>
@@ -23,6 +25,7 @@
 #include "rgw_common.h"
 #include "rgw_bucket.h"
 #include "rgw_lc.h"
+#include "rgw_lc_checkpoint.h"
 #include "rgw_zone.h"
 #include "rgw_string.h"
 #include "rgw_multi.h"
@@ -438,6 +441,16 @@ public:
     list_params.prefix = prefix;
   }
 
+  void set_shard_id(int shard_id) {
+    list_params.shard_id = shard_id;
+  }
+
+  /* resume after a checkpointed key */
+  void set_marker(const rgw_obj_key& marker) {
+    list_params.marker = marker;
+    pre_obj.key = marker;
+  }
+
   int init() {
     return fetch();
   }
@@ -503,6 +516,11 @@ public:
 
 }; /* LCObjsLister */
 
+struct LCBucketStats {
+  std::atomic<uint64_t> evaluated{0};
+  std::atomic<uint64_t> removed{0};
+};
+
 struct op_env {
 
   using LCWorker = RGWLC::LCWorker;
@@ -512,6 +530,9 @@ struct op_env {
   LCWorker* worker;
   rgw::sal::RGWBucket* bucket;
   LCObjsLister& ol;
+  LCShardProgress* progress{nullptr};
+  uint64_t page{0}; // of the entry in progress
+  LCBucketStats* stats{nullptr};
 
   op_env(lc_op& _op, rgw::sal::RGWRadosStore *_store, LCWorker* _worker,
 	 rgw::sal::RGWBucket* _bucket, LCObjsLister& _ol)
@@ -590,8 +611,17 @@ static int remove_expired_obj(lc_op_ctx& oc, bool remove_indeed)
   ACLOwner bucket_owner;
   bucket_owner.set_id(bucket_info.owner);
 
-  return obj->delete_object(&oc.rctx, obj_owner, bucket_owner, meta.mtime, false, 0,
-			    version_id, null_yield);
+  ret = obj->delete_object(&oc.rctx, obj_owner, bucket_owner, meta.mtime,
+			   false, 0, version_id, null_yield);
+  if (ret >= 0) {
+    if (oc.env.stats) {
+      ++oc.env.stats->removed;
+    }
+    if (perfcounter) {
+      perfcounter->inc(l_rgw_lc_remove);
+    }
+  }
+  return ret;
 } /* remove_expired_obj */
 
 class LCOpAction {
@@ -645,6 +675,10 @@ class LCOpRule {
 public:
   LCOpRule(op_env& _env) : env(_env) {}
 
+  op_env& get_env() {
+    return env;
+  }
+
   boost::optional<std::string> get_next_key_name() {
     return next_key_name;
   }
@@ -769,7 +803,7 @@ class RGWLC::WorkPool
 {
   using TVector = ceph::containers::tiny_vector<WorkQ, 3>;
   TVector wqs;
-  uint64_t ix;
+  std::atomic<uint64_t> ix;
 
 public:
   WorkPool(RGWLC::LCWorker* wk, uint16_t n_threads, uint32_t qmax)
@@ -793,9 +827,9 @@ public:
     }
   }
 
+  /* called by every shard lister of the worker */
   void enqueue(WorkItem item) {
-    const auto tix = ix;
-    ix = (ix+1) % wqs.size();
+    const auto tix = ix++ % wqs.size();
     (wqs[tix]).enqueue(std::move(item));
   }
 
@@ -1428,6 +1462,72 @@ int LCOpRule::process(rgw_bucket_dir_entry& o,
 
 }
 
+/* list one index shard of the bucket for a rule and queue its entries
+ * to the worker's work pool. the lister stays in *plister, as the queued
+ * rules refer to it until the pool is drained */
+static int lc_list_shard(rgw::sal::RGWRadosStore* store,
+			 rgw::sal::RGWBucket* bucket,
+			 RGWLC::LCWorker* worker, RGWLC::WorkPool* workpool,
+			 lc_op& op, const std::string& prefix, uint32_t shard,
+			 LCCheckpoint& checkpoint, LCShardProgress& progress,
+			 LCBucketStats& stats,
+			 std::unique_ptr<LCObjsLister>* plister,
+			 std::function<bool()> should_stop)
+{
+  auto cp = checkpoint.get(op.id, shard);
+  if (cp && cp->complete) {
+    return 0;
+  }
+
+  *plister = std::make_unique<LCObjsLister>(store, bucket);
+  auto& ol = **plister;
+  ol.set_prefix(prefix);
+  ol.set_shard_id(shard);
+  if (cp) {
+    ol.set_marker(cp->marker);
+  }
+
+  int ret = ol.init();
+  if (ret < 0) {
+    return (ret == -ENOENT ? 0 : ret);
+  }
+
+  auto save_marker = [&] {
+    rgw_obj_key marker;
+    bool complete;
+    if (progress.get_marker(&marker, &complete)) {
+      int r = checkpoint.save(op.id, shard, marker, complete);
+      if (r < 0) {
+	ldout(store->ctx(), 0) << "WARNING: lc_list_shard(): failed to "
+			       << "checkpoint shard " << shard << " of "
+			       << bucket << ": " << cpp_strerror(r) << dendl;
+      }
+    }
+  };
+
+  op_env oenv(op, store, worker, bucket, ol);
+  oenv.progress = &progress;
+  oenv.stats = &stats;
+  LCOpRule orule(oenv);
+  orule.build(); // why can't ctor do it?
+  rgw_bucket_dir_entry* o{nullptr};
+  auto fetch_barrier = [&] {
+    progress.page_done(ol.get_prev_obj().key, false);
+    save_marker();
+  };
+  for (; ol.get_obj(&o, fetch_barrier); ol.next()) {
+    if (should_stop()) {
+      return -EINTR;
+    }
+    orule.update();
+    orule.get_env().page = progress.add_listed();
+    std::tuple<LCOpRule, rgw_bucket_dir_entry> t1 = {orule, *o};
+    workpool->enqueue(WorkItem{t1});
+  }
+  progress.page_done(ol.get_prev_obj().key, true);
+  return 0;
+}
+
 int RGWLC::bucket_lc_process(string& shard_id, LCWorker* worker,
 			     time_t stop_at, bool once)
 {
@@ -1440,10 +1540,20 @@ int RGWLC::bucket_lc_process(string& shard_id, LCWorker* worker,
   string bucket_tenant = result[0];
   string bucket_name = result[1];
   string bucket_marker = result[2];
+
+  /* a bucket removed in the middle of a pass leaves its markers behind */
+  auto remove_checkpoint = [&] {
+    store->getRados()->get_lc_pool_ctx()->remove(
+      lc_checkpoint_oid(bucket_marker));
+  };
+
   int ret = store->get_bucket(nullptr, bucket_tenant, bucket_name, &bucket, null_yield);
   if (ret < 0) {
     ldpp_dout(this, 0) << "LC:get_bucket for " << bucket_name
 		       << " failed" << dendl;
+    if (ret == -ENOENT) {
+      remove_checkpoint();
+    }
     return ret;
   }
 
@@ -1451,6 +1561,9 @@ int RGWLC::bucket_lc_process(string& shard_id, LCWorker* worker,
   if (ret < 0) {
     ldpp_dout(this, 0) << "LC:get_bucket_info for " << bucket_name
 		       << " failed" << dendl;
+    if (ret == -ENOENT) {
+      remove_checkpoint();
+    }
     return ret;
   }
 
@@ -1466,12 +1579,15 @@ int RGWLC::bucket_lc_process(string& shard_id, LCWorker* worker,
 		       << bucket_tenant << ":" << bucket_name
 		       << " cur_marker=" << bucket->get_marker()
                        << " orig_marker=" << bucket_marker << dendl;
+    remove_checkpoint();
     return -ENOENT;
   }
 
   map<string, bufferlist>::iterator aiter = bucket->get_attrs().find(RGW_ATTR_LC);
-  if (aiter == bucket->get_attrs().end())
+  if (aiter == bucket->get_attrs().end()) {
+    remove_checkpoint();
     return 0;
+  }
 
   bufferlist::const_iterator iter{&aiter->second};
   try {
@@ -1497,6 +1613,16 @@ int RGWLC::bucket_lc_process(string& shard_id, LCWorker* worker,
 	<< wq->thr_name() 
 	<< dendl;
     }
+    auto& env = op_rule.get_env();
+    if (env.stats) {
+      ++env.stats->evaluated;
+    }
+    if (perfcounter) {
+      perfcounter->inc(l_rgw_lc_eval);
+    }
+    if (env.progress) {
+      env.progress->add_processed(env.page);
+    }
   };
   worker->workpool->setf(pf);
 
@@ -1505,15 +1631,52 @@ int RGWLC::bucket_lc_process(string& shard_id, LCWorker* worker,
 		      << prefix_map.size()
 		      << dendl;
 
+  /* each index shard is listed on its own, up to rgw_lc_max_shard_lister
+   * at a time, and all of them feed the worker's work pool */
+  const uint32_t num_shards = std::max<uint32_t>(1,
+    bucket->get_info().layout.current_index.layout.normal.num_shards);
+  const uint32_t num_listers = std::min<uint32_t>(num_shards,
+    std::max<int64_t>(1, cct->_conf.get_val<int64_t>("rgw_lc_max_shard_lister")));
+
+  LCCheckpoint checkpoint(cct, *store->getRados()->get_lc_pool_ctx(),
+			  bucket->get_key(), num_shards);
+  ret = checkpoint.load();
+  if (ret < 0) {
+    ldpp_dout(this, 0) << "WARNING: failed to read lc checkpoint of "
+		       << bucket << ", starting over: " << cpp_strerror(ret)
+		       << dendl;
+  }
+
+  LCBucketStats stats;
+  const auto start = ceph::mono_clock::now();
+  auto log_stats = [&] {
+    const auto secs = std::max(1.0, std::chrono::duration<double>(
+				 ceph::mono_clock::now() - start).count());
+    ldpp_dout(this, 5) << "RGWLC::bucket_lc_process(): " << bucket
+		       << " evaluated=" << stats.evaluated.load()
+		       << " removed=" << stats.removed.load()
+		       << " (" << stats.evaluated.load() / secs << "/s evaluated, "
+		       << stats.removed.load() / secs << "/s removed)" << dendl;
+  };
+
+  std::atomic<bool> stopped{false};
+  auto should_stop = [&] {
+    if (!stopped && (worker_should_stop(stop_at, once) || going_down())) {
+      stopped = true;
+    }
+    return bool(stopped);
+  };
+
   rgw_obj_key pre_marker;
   rgw_obj_key next_marker;
   for(auto prefix_iter = prefix_map.begin(); prefix_iter != prefix_map.end();
       ++prefix_iter) {
 
-    if (worker_should_stop(stop_at, once)) {
+    if (should_stop()) {
       ldout(cct, 5) << __func__ << " interval budget EXPIRED worker "
 		     << worker->ix
 		     << dendl;
+      log_stats();
       return 0;
     }
 
@@ -1531,27 +1694,69 @@ int RGWLC::bucket_lc_process(string& shard_id, LCWorker* worker,
       pre_marker = next_marker;
     }
 
-    LCObjsLister ol(store, bucket.get());
-    ol.set_prefix(prefix_iter->first);
-
-    ret = ol.init();
-    if (ret < 0) {
-      if (ret == (-ENOENT))
-        return 0;
-      ldpp_dout(this, 0) << "ERROR: store->list_objects():" <<dendl;
-      return ret;
+    const std::string& prefix = prefix_iter->first;
+    std::vector<std::unique_ptr<LCObjsLister>> listers(num_shards);
+    std::vector<LCShardProgress> progress(num_shards);
+    std::atomic<uint32_t> next_shard{0};
+    std::atomic<int> list_ret{0};
+    auto list_shards = [&] {
+      for (uint32_t shard = next_shard++; shard < num_shards;
+	   shard = next_shard++) {
+	int r = lc_list_shard(store, bucket.get(), worker, worker->workpool,
+			      op, prefix, shard, checkpoint, progress[shard],
+			      stats, &listers[shard], should_stop);
+	if (r == -EINTR) {
+	  return;
+	}
+	if (r < 0) {
+	  ldpp_dout(this, 0) << "ERROR: failed to list shard " << shard
+			     << " of " << bucket << ": " << cpp_strerror(r)
+			     << dendl;
+	  list_ret = r;
+	}
+      }
+    };
+    std::vector<std::thread> threads;
+    for (uint32_t i = 1; i < num_listers; ++i) {
+      threads.emplace_back(make_named_thread("lc_lister", list_shards));
     }
-
-    op_env oenv(op, store, worker, bucket.get(), ol);
-    LCOpRule orule(oenv);
-    orule.build(); // why can't ctor do it?
-    rgw_bucket_dir_entry* o{nullptr};
-    for (; ol.get_obj(&o /* , fetch_barrier */); ol.next()) {
-      orule.update();
-      std::tuple<LCOpRule, rgw_bucket_dir_entry> t1 = {orule, *o};
-      worker->workpool->enqueue(WorkItem{t1});
+    list_shards();
+    for (auto& t : threads) {
+      t.join();
     }
     worker->workpool->drain();
+
+    /* every queued entry is processed now, so the markers are final */
+    for (uint32_t shard = 0; shard < num_shards; ++shard) {
+      rgw_obj_key marker;
+      bool complete;
+      if (progress[shard].get_marker(&marker, &complete)) {
+	int r = checkpoint.save(op.id, shard, marker, complete);
+	if (r < 0) {
+	  ldpp_dout(this, 0) << "WARNING: failed to checkpoint shard " << shard
+			     << " of " << bucket << ": " << cpp_strerror(r)
+			     << dendl;
+	}
+      }
+    }
+    if (stopped) {
+      ldout(cct, 5) << __func__ << " interval budget EXPIRED worker "
+		     << worker->ix
+		     << dendl;
+      log_stats();
+      return 0;
+    }
+    if (list_ret < 0) {
+      log_stats();
+      return list_ret;
+    }
+  }
+
+  log_stats();
+  ret = checkpoint.remove();
+  if (ret < 0) {
+    ldpp_dout(this, 0) << "WARNING: failed to remove lc checkpoint of "
+		       << bucket << ": " << cpp_strerror(ret) << dendl;
   }
 
   ret = handle_multipart_expiration(bucket.get(), prefix_map, worker, stop_at, once);
@@ -2050,6 +2255,9 @@ int RGWLC::remove_bucket_config(RGWBucketInfo& bucket_info,
     return sal_lc->rm_entry(oid, entry);
   });
 
+  /* drop the markers of an unfinished pass */
+  store->getRados()->get_lc_pool_ctx()->remove(lc_checkpoint_oid(bucket.marker));
+
   return ret;
 } /* RGWLC::remove_bucket_config */
 
@@ -0,0 +1,133 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+#include "rgw_lc_checkpoint.h"
+
+#include "fmt/format.h"
+
+#define dout_subsys ceph_subsys_rgw
+
+void LCShardProgress::advance()
+{
+  while (!pages.empty() && pages.front().listed &&
+	 pages.front().outstanding == 0) {
+    if (!pages.front().last.empty()) {
+      marker = std::move(pages.front().last);
+    }
+    pages.pop_front();
+    ++first;
+    dirty = true;
+  }
+}
+
+uint64_t LCShardProgress::add_listed()
+{
+  std::lock_guard l{lock};
+  ++pages.back().outstanding;
+  return first + pages.size() - 1;
+}
+
+void LCShardProgress::add_processed(uint64_t page)
+{
+  std::lock_guard l{lock};
+  ceph_assert(page >= first && page - first < pages.size());
+  --pages[page - first].outstanding;
+  advance();
+}
+
+void LCShardProgress::page_done(const rgw_obj_key& last, bool done)
+{
+  std::lock_guard l{lock};
+  if (listing_done) {
+    return;
+  }
+  pages.back().listed = true;
+  pages.back().last = last;
+  if (!done) {
+    pages.emplace_back();
+  }
+  listing_done = done;
+  advance();
+}
+
+bool LCShardProgress::get_marker(rgw_obj_key* m, bool* complete)
+{
+  std::lock_guard l{lock};
+  if (!dirty) {
+    return false;
+  }
+  dirty = false;
+  *m = marker;
+  *complete = listing_done && pages.empty();
+  return true;
+}
+
+std::string lc_checkpoint_oid(const std::string& bucket_marker)
+{
+  return "lc_checkpoint." + bucket_marker;
+}
+
+static std::string get_key(const std::string& rule_id, uint32_t shard)
+{
+  return fmt::format("{:05d}/{}", shard, rule_id);
+}
+
+int LCCheckpoint::load()
+{
+  std::string start_after;
+  bool more = true;
+  while (more) {
+    std::map<std::string, bufferlist> vals;
+    int r = ioctx.omap_get_vals2(oid, start_after, 1000, &vals, &more);
+    if (r == -ENOENT) {
+      return 0;
+    }
+    if (r < 0) {
+      return r;
+    }
+    for (auto& [key, bl] : vals) {
+      lc_shard_checkpoint cp;
+      try {
+	auto iter = bl.cbegin();
+	decode(cp, iter);
+      } catch (buffer::error& err) {
+	ldout(cct, 0) << "ERROR: failed to decode lc checkpoint " << key
+		      << " of " << oid << dendl;
+	continue;
+      }
+      /* markers don't carry over a reshard */
+      if (cp.num_shards == num_shards) {
+	entries.emplace(key, std::move(cp));
+      }
+    }
+    if (!vals.empty()) {
+      start_after = vals.rbegin()->first;
+    }
+  }
+  return 0;
+}
+
+const lc_shard_checkpoint* LCCheckpoint::get(const std::string& rule_id,
+					     uint32_t shard) const
+{
+  auto i = entries.find(get_key(rule_id, shard));
+  return i == entries.end() ? nullptr : &i->second;
+}
+
+int LCCheckpoint::save(const std::string& rule_id, uint32_t shard,
+		       const rgw_obj_key& marker, bool complete)
+{
+  lc_shard_checkpoint cp;
+  cp.num_shards = num_shards;
+  cp.marker = marker;
+  cp.complete = complete;
+  std::map<std::string, bufferlist> vals;
+  encode(cp, vals[get_key(rule_id, shard)]);
+  return ioctx.omap_set(oid, vals);
+}
+
+int LCCheckpoint::remove()
+{
+  int r = ioctx.remove(oid);
+  return r == -ENOENT ? 0 : r;
+}
@@ -0,0 +1,102 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+#pragma once
+
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "include/rados/librados.hpp"
+#include "rgw_common.h"
+
+/* tracks how far the work pool got through the entries listed from one
+ * bucket index shard. entries are processed out of order, so the shard's
+ * marker only moves past a listing page once every entry of that page and
+ * of the pages before it was processed */
+class LCShardProgress {
+  struct page {
+    uint64_t outstanding{0}; // listed entries not processed yet
+    rgw_obj_key last;
+    bool listed{false}; // the listing moved on to the next page
+  };
+
+  std::mutex lock;
+  uint64_t first{0}; // sequence number of pages.front()
+  std::deque<page> pages; // the back is the page being listed
+  bool listing_done{false};
+  rgw_obj_key marker;
+  bool dirty{false};
+
+  void advance();
+
+public:
+  LCShardProgress() : pages(1) {}
+
+  /* count an entry of the page being listed, and return that page's
+   * sequence number for add_processed() */
+  uint64_t add_listed();
+
+  void add_processed(uint64_t page);
+
+  /* the listing finished the page being listed, whose last entry is last */
+  void page_done(const rgw_obj_key& last, bool done);
+
+  /* return the marker and whether the shard is done, if it changed since
+   * the last call */
+  bool get_marker(rgw_obj_key* m, bool* complete);
+}; /* LCShardProgress */
+
+struct lc_shard_checkpoint {
+  uint32_t num_shards{0};
+  rgw_obj_key marker;
+  bool complete{false};
+
+  void encode(bufferlist& bl) const {
+    ENCODE_START(1, 1, bl);
+    encode(num_shards, bl);
+    encode(marker, bl);
+    encode(complete, bl);
+    ENCODE_FINISH(bl);
+  }
+  void decode(bufferlist::const_iterator& bl) {
+    DECODE_START(1, bl);
+    decode(num_shards, bl);
+    decode(marker, bl);
+    decode(complete, bl);
+    DECODE_FINISH(bl);
+  }
+};
+WRITE_CLASS_ENCODER(lc_shard_checkpoint)
+
+std::string lc_checkpoint_oid(const std::string& bucket_marker);
+
+/* the per-shard listing markers of a bucket's lifecycle pass, kept in the
+ * lc pool so that a pass cut short by a restart or by the end of the work
+ * window resumes where it stopped instead of listing the bucket again.
+ * they are removed once a pass over every shard completes, or once the
+ * bucket is gone */
+class LCCheckpoint {
+  CephContext *cct;
+  librados::IoCtx& ioctx;
+  const std::string oid;
+  const uint32_t num_shards;
+  std::map<std::string, lc_shard_checkpoint> entries;
+
+public:
+  LCCheckpoint(CephContext *cct, librados::IoCtx& ioctx,
+	       const rgw_bucket& bucket, uint32_t num_shards)
+    : cct(cct), ioctx(ioctx), oid(lc_checkpoint_oid(bucket.marker)),
+      num_shards(num_shards) {}
+
+  int load();
+
+  const lc_shard_checkpoint* get(const std::string& rule_id,
+				 uint32_t shard) const;
+
+  int save(const std::string& rule_id, uint32_t shard,
+	   const rgw_obj_key& marker, bool complete);
+
+  int remove();
+}; /* LCCheckpoint */
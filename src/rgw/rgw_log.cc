@@ -1,7 +1,12 @@
 // -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
 // vim: ts=8 sw=2 smarttab ft=cpp
 
+#include <array>
+#include <atomic>
+#include <thread>
+
 #include "common/Clock.h"
+#include "common/Thread.h"
 #include "common/Timer.h"
 #include "common/utf8.h"
 #include "common/OutputDataSocket.h"
@@ -11,6 +16,7 @@
 #include "rgw_log.h"
 #include "rgw_acl.h"
 #include "rgw_client_io.h"
+#include "rgw_perf_counters.h"
 #include "rgw_rest.h"
 #include "rgw_zone.h"
 
@@ -89,9 +95,17 @@ string render_log_object_name(const string& format,
 class UsageLogger {
   CephContext *cct;
   RGWRados *store;
-  map<rgw_user_bucket, RGWUsageBatch> usage_map;
-  ceph::mutex lock = ceph::make_mutex("UsageLogger");
-  int32_t num_entries;
+  /* requests add to the shard of their user and bucket, so that they
+   * don't all wait on one lock */
+  static constexpr size_t num_shards = 16;
+  struct Shard {
+    ceph::mutex lock = ceph::make_mutex("UsageLogger::shard");
+    map<rgw_user_bucket, RGWUsageBatch> usage_map;
+  };
+  std::array<Shard, num_shards> shards;
+  std::atomic<int32_t> num_entries{0};
+  std::atomic<bool> flush_pending{false};
+  ceph::mutex ts_lock = ceph::make_mutex("UsageLogger::ts_lock");
   ceph::mutex timer_lock = ceph::make_mutex("UsageLogger::timer_lock");
   SafeTimer timer;
   utime_t round_timestamp;
@@ -106,12 +120,21 @@ class UsageLogger {
     }
   };
 
+  class C_UsageLogFlush : public Context {
+    UsageLogger *logger;
+  public:
+    explicit C_UsageLogFlush(UsageLogger *_l) : logger(_l) {}
+    void finish(int r) override {
+      logger->flush();
+    }
+  };
+
   void set_timer() {
     timer.add_event_after(cct->_conf->rgw_usage_log_tick_interval, new C_UsageLogTimeout(this));
   }
 public:
 
-  UsageLogger(CephContext *_cct, RGWRados *_store) : cct(_cct), store(_store), num_entries(0), timer(cct, timer_lock) {
+  UsageLogger(CephContext *_cct, RGWRados *_store) : cct(_cct), store(_store), timer(cct, timer_lock) {
     timer.init();
     std::lock_guard l{timer_lock};
     set_timer();
@@ -131,22 +154,34 @@ public:
   }
 
   void insert_user(utime_t& timestamp, const rgw_user& user, rgw_usage_log_entry& entry) {
-    lock.lock();
-    if (timestamp.sec() > round_timestamp + 3600)
-      recalc_round_timestamp(timestamp);
-    entry.epoch = round_timestamp.sec();
+    real_time rt;
+    {
+      std::lock_guard l{ts_lock};
+      if (timestamp.sec() > round_timestamp + 3600)
+        recalc_round_timestamp(timestamp);
+      entry.epoch = round_timestamp.sec();
+      rt = round_timestamp.to_real_time();
+    }
     bool account;
     string u = user.to_str();
     rgw_user_bucket ub(u, entry.bucket);
-    real_time rt = round_timestamp.to_real_time();
-    usage_map[ub].insert(rt, entry, &account);
+    auto& shard = shards[std::hash<string>{}(u + entry.bucket) % num_shards];
+    {
+      std::lock_guard l{shard.lock};
+      shard.usage_map[ub].insert(rt, entry, &account);
+    }
     if (account)
       num_entries++;
     bool need_flush = (num_entries > cct->_conf->rgw_usage_log_flush_threshold);
-    lock.unlock();
-    if (need_flush) {
-      std::lock_guard l{timer_lock};
-      flush();
+    if (need_flush && !flush_pending.exchange(true)) {
+      /* flush on the timer thread rather than making this request wait.
+       * if the timer is busy, it's flushing already */
+      std::unique_lock l{timer_lock, std::try_to_lock};
+      if (l.owns_lock()) {
+        timer.add_event_after(0, new C_UsageLogFlush(this));
+      } else {
+        flush_pending = false;
+      }
     }
   }
 
@@ -160,10 +195,16 @@ public:
 
   void flush() {
     map<rgw_user_bucket, RGWUsageBatch> old_map;
-    lock.lock();
-    old_map.swap(usage_map);
+    flush_pending = false;
     num_entries = 0;
-    lock.unlock();
+    for (auto& shard : shards) {
+      map<rgw_user_bucket, RGWUsageBatch> m;
+      {
+        std::lock_guard l{shard.lock};
+        m.swap(shard.usage_map);
+      }
+      old_map.merge(m);
+    }
 
     store->log_usage(old_map);
   }
@@ -237,6 +278,110 @@ static void log_usage(struct req_state *s, const string& op_name)
   usage_logger->insert(ts, entry);
 }
 
+/*
+ * Batches the ops log entries headed to the same rados object, and appends
+ * them every rgw_ops_log_flush_interval_ms on a thread of its own. Entries
+ * are dropped rather than queued beyond rgw_ops_log_max_queued.
+ */
+class OpsLogBatcher {
+  CephContext *cct;
+  RGWRados *store;
+
+  ceph::mutex lock = ceph::make_mutex("OpsLogBatcher");
+  ceph::condition_variable cond;
+  map<string, bufferlist> pending; /* by object name */
+  uint64_t queued_bytes = 0;
+  bool stopping = false;
+  std::thread thread;
+
+  void run() {
+    std::unique_lock l{lock};
+    while (!stopping) {
+      const auto interval = std::chrono::milliseconds(
+        cct->_conf.get_val<uint64_t>("rgw_ops_log_flush_interval_ms"));
+      cond.wait_for(l, interval);
+      map<string, bufferlist> batch;
+      batch.swap(pending);
+      queued_bytes = 0;
+      l.unlock();
+      write(batch);
+      l.lock();
+    }
+  }
+
+  void write(map<string, bufferlist>& batch) {
+    const auto& log_pool = store->svc.zone->get_zone_params().log_pool;
+    for (auto& [oid, bl] : batch) {
+      rgw_raw_obj obj(log_pool, oid);
+      int ret = store->append_async(obj, bl.length(), bl);
+      if (ret == -ENOENT) {
+        ret = store->create_pool(log_pool);
+        if (ret >= 0) {
+          ret = store->append_async(obj, bl.length(), bl);
+        }
+      }
+      if (ret < 0) {
+        ldout(cct, 0) << "ERROR: failed to log ops to " << oid
+            << ": ret=" << ret << dendl;
+      }
+      if (perfcounter) {
+        perfcounter->inc(l_rgw_ops_log_append);
+      }
+    }
+  }
+
+public:
+  OpsLogBatcher(CephContext *cct, RGWRados *store)
+    : cct(cct), store(store) {
+    thread = make_named_thread("rgw_ops_log", &OpsLogBatcher::run, this);
+  }
+
+  ~OpsLogBatcher() {
+    {
+      std::lock_guard l{lock};
+      stopping = true;
+    }
+    cond.notify_all();
+    thread.join();
+    write(pending);
+  }
+
+  /* returns false if the entry was dropped */
+  bool queue(const string& oid, bufferlist& bl) {
+    const uint64_t max_queued =
+      cct->_conf.get_val<Option::size_t>("rgw_ops_log_max_queued");
+    std::lock_guard l{lock};
+    if (queued_bytes + bl.length() > max_queued) {
+      if (perfcounter) {
+        perfcounter->inc(l_rgw_ops_log_dropped);
+      }
+      return false;
+    }
+    queued_bytes += bl.length();
+    pending[oid].claim_append(bl);
+    if (perfcounter) {
+      perfcounter->inc(l_rgw_ops_log_queued);
+    }
+    return true;
+  }
+};
+
+static OpsLogBatcher *ops_log_batcher = nullptr;
+
+void rgw_log_ops_init(CephContext *cct, RGWRados *store)
+{
+  if (cct->_conf->rgw_enable_ops_log && cct->_conf->rgw_ops_log_rados &&
+      cct->_conf.get_val<uint64_t>("rgw_ops_log_flush_interval_ms") > 0) {
+    ops_log_batcher = new OpsLogBatcher(cct, store);
+  }
+}
+
+void rgw_log_ops_finalize()
+{
+  delete ops_log_batcher;
+  ops_log_batcher = nullptr;
+}
+
 void rgw_format_ops_log_entry(struct rgw_log_entry& entry, Formatter *formatter)
 {
   formatter->open_object_section("log_entry");
@@ -463,15 +608,21 @@ int rgw_log_op(RGWRados *store, RGWREST* const rest, struct req_state *s,
     string oid = render_log_object_name(s->cct->_conf->rgw_log_object_name, &bdt,
 				        entry.bucket_id, entry.bucket);
 
-    rgw_raw_obj obj(store->svc.zone->get_zone_params().log_pool, oid);
+    if (ops_log_batcher) {
+      if (!ops_log_batcher->queue(oid, bl)) {
+        ldout(s->cct, 5) << "ops log queue is full, dropped entry" << dendl;
+      }
+    } else {
+      rgw_raw_obj obj(store->svc.zone->get_zone_params().log_pool, oid);
 
-    ret = store->append_async(obj, bl.length(), bl);
-    if (ret == -ENOENT) {
-      ret = store->create_pool(store->svc.zone->get_zone_params().log_pool);
-      if (ret < 0)
-        goto done;
-      // retry
       ret = store->append_async(obj, bl.length(), bl);
+      if (ret == -ENOENT) {
+        ret = store->create_pool(store->svc.zone->get_zone_params().log_pool);
+        if (ret < 0)
+          goto done;
+        // retry
+        ret = store->append_async(obj, bl.length(), bl);
+      }
     }
   }
 
@@ -54,13 +54,18 @@ bool verify(const std::string& script, std::string& err_msg)
 
 static const std::string SCRIPT_OID_PREFIX("script.");
 
-int read_script(rgw::sal::RGWRadosStore* store, const std::string& tenant, optional_yield y, context ctx, std::string& script)
+std::string script_oid(context ctx, const std::string& tenant)
+{
+  return SCRIPT_OID_PREFIX + to_string(ctx) + tenant;
+}
+
+int read_script(rgw::sal::RGWRadosStore* store, const std::string& tenant, optional_yield y, context ctx, std::string& script,
+    obj_version* version)
 {
   RGWSysObjectCtx obj_ctx(store->svc()->sysobj->init_obj_ctx());
   RGWObjVersionTracker objv_tracker;
 
-  const auto script_oid = SCRIPT_OID_PREFIX + to_string(ctx) + tenant;
-  rgw_raw_obj obj(store->svc()->zone->get_zone_params().log_pool, script_oid);
+  rgw_raw_obj obj(store->svc()->zone->get_zone_params().log_pool, script_oid(ctx, tenant));
 
   bufferlist bl;
   
@@ -86,6 +91,12 @@ int read_script(rgw::sal::RGWRadosStore* store, const std::string& tenant, optio
     return -EIO;
   }
 
+  if (version) {
+    // the system object cache keeps the version, and is invalidated by
+    // watch/notify when the script is written or removed
+    *version = objv_tracker.read_version;
+  }
+
   return 0;
 }
 
@@ -94,8 +105,7 @@ int write_script(rgw::sal::RGWRadosStore* store, const std::string& tenant, opti
   RGWSysObjectCtx obj_ctx(store->svc()->sysobj->init_obj_ctx());
   RGWObjVersionTracker objv_tracker;
 
-  const auto script_oid = SCRIPT_OID_PREFIX + to_string(ctx) + tenant;
-  rgw_raw_obj obj(store->svc()->zone->get_zone_params().log_pool, script_oid);
+  rgw_raw_obj obj(store->svc()->zone->get_zone_params().log_pool, script_oid(ctx, tenant));
 
   bufferlist bl;
   ceph::encode(script, bl);
@@ -121,8 +131,7 @@ int delete_script(rgw::sal::RGWRadosStore* store, const std::string& tenant, opt
 {
   RGWObjVersionTracker objv_tracker;
 
-  const auto script_oid = SCRIPT_OID_PREFIX + to_string(ctx) + tenant;
-  rgw_raw_obj obj(store->svc()->zone->get_zone_params().log_pool, script_oid);
+  rgw_raw_obj obj(store->svc()->zone->get_zone_params().log_pool, script_oid(ctx, tenant));
 
   const auto rc = rgw_delete_system_obj(
       store->svc()->sysobj, 
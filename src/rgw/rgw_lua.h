@@ -5,6 +5,7 @@
 
 class lua_State;
 class rgw_user;
+struct obj_version;
 namespace rgw::sal {
   class RGWRadosStore;
 }
@@ -22,6 +23,9 @@ enum class context {
 // return "none" if not matched
 context to_context(const std::string& s);
 
+// name of the object that stores the lua script of a context
+std::string script_oid(context ctx, const std::string& tenant);
+
 // verify a lua script
 bool verify(const std::string& script, std::string& err_msg);
 
@@ -29,7 +33,9 @@ bool verify(const std::string& script, std::string& err_msg);
 int write_script(rgw::sal::RGWRadosStore* store, const std::string& tenant, optional_yield y, context ctx, const std::string& script);
 
 // read the stored lua script from a context
-int read_script(rgw::sal::RGWRadosStore* store, const std::string& tenant, optional_yield y, context ctx, std::string& script);
+// and its version, when "version" is not null
+int read_script(rgw::sal::RGWRadosStore* store, const std::string& tenant, optional_yield y, context ctx, std::string& script,
+    obj_version* version = nullptr);
 
 // delete the stored lua script from a context
 int delete_script(rgw::sal::RGWRadosStore* store, const std::string& tenant, optional_yield y, context ctx);
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <list>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <lua.hpp>
@@ -10,6 +13,7 @@
 #include "rgw_zone.h"
 #include "rgw_acl.h"
 #include "rgw_sal_rados.h"
+#include "rgw_perf_counters.h"
 
 #define dout_subsys ceph_subsys_rgw
 
@@ -277,7 +281,7 @@ struct StringMapMetaTable : public EmptyMetaTable {
     auto map = reinterpret_cast<MapType*>(lua_touserdata(L, lua_upvalueindex(1)));
     ceph_assert(map);
     lua_pushlightuserdata(L, map);
-    lua_pushcclosure(L, stateless_iter, ONE_UPVAL); // push the stateless iterator function
+    push_request_closure<stateless_iter, ONE_UPVAL>(L); // push the stateless iterator function
     lua_pushnil(L);                                 // indicate this is the first call
     // return stateless_iter, nil
 
@@ -373,7 +377,7 @@ struct GrantsMetaTable : public EmptyMetaTable {
     auto map = reinterpret_cast<ACLGrantMap*>(lua_touserdata(L, lua_upvalueindex(1)));
     ceph_assert(map);
     lua_pushlightuserdata(L, map);
-    lua_pushcclosure(L, stateless_iter, ONE_UPVAL); // push the stateless iterator function
+    push_request_closure<stateless_iter, ONE_UPVAL>(L); // push the stateless iterator function
     lua_pushnil(L);                                 // indicate this is the first call
     // return stateless_iter, nil
 
@@ -481,7 +485,7 @@ struct StatementsMetaTable : public EmptyMetaTable {
     auto statements = reinterpret_cast<Type*>(lua_touserdata(L, lua_upvalueindex(1)));
     ceph_assert(statements);
     lua_pushlightuserdata(L, statements);
-    lua_pushcclosure(L, stateless_iter, ONE_UPVAL); // push the stateless iterator function
+    push_request_closure<stateless_iter, ONE_UPVAL>(L); // push the stateless iterator function
     lua_pushnil(L);                                 // indicate this is the first call
     // return stateless_iter, nil
 
@@ -540,7 +544,7 @@ struct PolicyMetaTable : public EmptyMetaTable {
         pushstring(L, policy->id.get());
       }
     } else if (strcasecmp(index, "Statements") == 0) {
-      create_metatable<StatementsMetaTable>(L, &(policy->statements));
+      create_metatable<StatementsMetaTable>(L, false, &(policy->statements));
     } else {
       throw_unknown_field(index, TableName());
     }
@@ -571,7 +575,7 @@ struct PoliciesMetaTable : public EmptyMetaTable {
     auto policies = reinterpret_cast<Type*>(lua_touserdata(L, lua_upvalueindex(1)));
     ceph_assert(policies);
     lua_pushlightuserdata(L, policies);
-    lua_pushcclosure(L, stateless_iter, ONE_UPVAL); // push the stateless iterator function
+    push_request_closure<stateless_iter, ONE_UPVAL>(L); // push the stateless iterator function
     lua_pushnil(L);                                 // indicate this is the first call
     // return stateless_iter, nil
 
@@ -721,7 +725,7 @@ struct RequestMetaTable : public EmptyMetaTable {
       create_metatable<ObjectMetaTable>(L, false, s->object);
     } else if (strcasecmp(index, "CopyFrom") == 0) {
       if (s->op_type == RGW_OP_COPY_OBJ) {
-        create_metatable<CopyFromMetaTable>(L, s);
+        create_metatable<CopyFromMetaTable>(L, false, s);
       } else {
         lua_pushnil(L);
       }
@@ -767,47 +771,182 @@ struct RequestMetaTable : public EmptyMetaTable {
   }
 };
 
-int execute(
+namespace {
+
+// a lua state that runs a single stored script. the compiled script is kept
+// in the registry, and each run gets a fresh global environment, so that
+// globals set by one request are not seen by the next. tables shared by the
+// runs (e.g. "string", or the global table behind the environment) are still
+// writable, but the Request tables and functions kept there fail after their
+// run is over
+struct ScriptState {
+  lua_State* L = nullptr;
+  obj_version version;
+  int chunk = LUA_NOREF;
+};
+
+// idle lua states of a thread, least recently used first
+class StatePool {
+  std::list<std::pair<std::string, ScriptState>> idle;
+
+public:
+  ~StatePool() {
+    for (auto& [key, state] : idle) {
+      lua_close(state.L);
+    }
+  }
+
+  // take the idle state of a script, if it runs the given version
+  std::optional<ScriptState> take(const std::string& key, const obj_version& version) {
+    auto i = std::find_if(idle.begin(), idle.end(),
+        [&key] (const auto& e) { return e.first == key; });
+    if (i == idle.end()) {
+      return std::nullopt;
+    }
+    auto state = i->second;
+    idle.erase(i);
+    if (!(state.version == version)) {
+      // the script changed
+      lua_close(state.L);
+      return std::nullopt;
+    }
+    return state;
+  }
+
+  void put(const std::string& key, const ScriptState& state, size_t max) {
+    idle.emplace_back(key, state);
+    while (idle.size() > max) {
+      lua_close(idle.front().second.L);
+      idle.pop_front();
+    }
+  }
+};
+
+thread_local StatePool state_pool;
+
+// the parts of the environment that don't depend on the request
+void init_state(lua_State* L, CephContext* cct)
+{
+  luaL_openlibs(L);
+  create_debug_action(L, cct);
+}
+
+// start a run, and push the Request table, with its ops log action
+void push_request_table(
+    lua_State* L,
     rgw::sal::RGWRadosStore* store,
     RGWREST* rest,
     OpsLogSocket* olog,
-    req_state* s, 
-    const char* op_name,
-    const std::string& script) 
+    req_state* s,
+    const char* op_name)
 {
-  auto L = luaL_newstate();
-  lua_state_guard lguard(L);
-
-  luaL_openlibs(L);
-
-  create_debug_action(L, s->cct);  
-
-  create_metatable<RequestMetaTable>(L, true, s, const_cast<char*>(op_name));
-  
-  // add the ops log action
-  lua_getglobal(L, RequestMetaTable::TableName().c_str());
-  ceph_assert(lua_istable(L, -1));
+  start_run(L);
+  create_metatable<RequestMetaTable>(L, false, s, const_cast<char*>(op_name));
   pushstring(L, RequestLogAction);
   lua_pushlightuserdata(L, store);
   lua_pushlightuserdata(L, rest);
   lua_pushlightuserdata(L, olog);
   lua_pushlightuserdata(L, s);
   lua_pushlightuserdata(L, const_cast<char*>(op_name));
-  lua_pushcclosure(L, RequestLog, FIVE_UPVALS);
+  push_request_closure<RequestLog, FIVE_UPVALS>(L);
   lua_rawset(L, -3);
+}
+
+} // anonymous namespace
+
+int execute(
+    rgw::sal::RGWRadosStore* store,
+    RGWREST* rest,
+    OpsLogSocket* olog,
+    req_state* s, 
+    const char* op_name,
+    const std::string& script,
+    const std::string& script_key,
+    const obj_version* version)
+{
+  const auto max_states = s->cct->_conf.get_val<uint64_t>("rgw_lua_max_cached_states");
+  if (max_states == 0 || script_key.empty() || !version || version->ver == 0) {
+    auto L = luaL_newstate();
+    lua_state_guard lguard(L);
+
+    init_state(L, s->cct);
+    push_request_table(L, store, rest, olog, s, op_name);
+    lua_setglobal(L, RequestMetaTable::TableName().c_str());
+
+    try {
+      // execute the lua script
+      if (luaL_dostring(L, script.c_str()) != LUA_OK) {
+        const std::string err(lua_tostring(L, -1));
+        ldout(s->cct, 1) << "Lua ERROR: " << err << dendl;
+        return -1;
+      }
+    } catch (const std::runtime_error& e) {
+      ldout(s->cct, 1) << "Lua ERROR: " << e.what() << dendl;
+      return -1;
+    }
+
+    return 0;
+  }
+
+  auto state = state_pool.take(script_key, *version);
+  if (state) {
+    if (perfcounter) perfcounter->inc(l_rgw_lua_state_reuse);
+  } else {
+    state.emplace();
+    state->L = luaL_newstate();
+    state->version = *version;
+  }
+  lua_State* L = state->L;
+  // closed on failure, rather than reused
+  lua_state_guard lguard(L);
 
   try {
+    if (state->chunk == LUA_NOREF) {
+      init_state(L, s->cct);
+      if (luaL_loadstring(L, script.c_str()) != LUA_OK) {
+        const std::string err(lua_tostring(L, -1));
+        ldout(s->cct, 1) << "Lua ERROR: " << err << dendl;
+        return -1;
+      }
+      state->chunk = luaL_ref(L, LUA_REGISTRYINDEX);
+      if (perfcounter) perfcounter->inc(l_rgw_lua_script_load);
+    }
+
+    lua_rawgeti(L, LUA_REGISTRYINDEX, state->chunk);
+    // the environment of this run. reads fall back to the globals
+    lua_newtable(L);
+    lua_newtable(L);
+    lua_pushglobaltable(L);
+    lua_setfield(L, -2, "__index");
+    lua_setmetatable(L, -2);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, -2, "_G");
+    push_request_table(L, store, rest, olog, s, op_name);
+    lua_setfield(L, -2, RequestMetaTable::TableName().c_str());
+    // it becomes the _ENV upvalue of the script
+    lua_setupvalue(L, -2, 1);
+
     // execute the lua script
-    if (luaL_dostring(L, script.c_str()) != LUA_OK) {
+    if (lua_pcall(L, 0, 0, 0) != LUA_OK) {
       const std::string err(lua_tostring(L, -1));
       ldout(s->cct, 1) << "Lua ERROR: " << err << dendl;
       return -1;
     }
+
+    // drop the environment, and invalidate whatever the script kept of the
+    // request
+    end_run(L);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, state->chunk);
+    lua_pushglobaltable(L);
+    lua_setupvalue(L, -2, 1);
+    lua_settop(L, 0);
   } catch (const std::runtime_error& e) {
     ldout(s->cct, 1) << "Lua ERROR: " << e.what() << dendl;
     return -1;
   }
 
+  lguard.reset();
+  state_pool.put(script_key, *state, max_states);
   return 0;
 }
 
@@ -6,6 +6,7 @@
 class req_state;
 class RGWREST;
 class OpsLogSocket;
+struct obj_version;
 namespace rgw::sal {
   class RGWRadosStore;
 }
@@ -13,13 +14,17 @@ namespace rgw::sal {
 namespace rgw::lua::request {
 
 // execute a lua script in the Request context
+// when the script's key and version are given, the lua state of an earlier
+// run of the same version is reused, with the script already compiled
 int execute(
     rgw::sal::RGWRadosStore* store,
     RGWREST* rest,
     OpsLogSocket* olog,
     req_state *s, 
     const char* op_name,
-    const std::string& script);
+    const std::string& script,
+    const std::string& script_key = "",
+    const obj_version* version = nullptr);
 
 }
 
@@ -30,6 +30,27 @@ void create_debug_action(lua_State* L, CephContext* cct) {
   lua_setglobal(L, RGWDebugLogAction);
 }
 
+constexpr const char* RGWRunToken{"RGWRunToken"};
+
+void start_run(lua_State* L) {
+  auto valid = reinterpret_cast<bool*>(lua_newuserdata(L, sizeof(bool)));
+  *valid = true;
+  lua_setfield(L, LUA_REGISTRYINDEX, RGWRunToken);
+}
+
+void end_run(lua_State* L) {
+  lua_getfield(L, LUA_REGISTRYINDEX, RGWRunToken);
+  auto valid = reinterpret_cast<bool*>(lua_touserdata(L, -1));
+  if (valid) {
+    *valid = false;
+  }
+  lua_pop(L, 1);
+}
+
+void push_run_token(lua_State* L) {
+  lua_getfield(L, LUA_REGISTRYINDEX, RGWRunToken);
+}
+
 void stack_dump(lua_State* L) {
   int top = lua_gettop(L);
   std::cout << std::endl << " ----------------  Stack Dump ----------------" << std::endl;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <ctime>
@@ -33,7 +34,7 @@ class lua_state_guard {
   lua_State* l;
 public:
   lua_state_guard(lua_State* _l) : l(_l) {}
-  ~lua_state_guard() {lua_close(l);}
+  ~lua_state_guard() {if (l) lua_close(l);}
   void reset(lua_State* _l=nullptr) {l = _l;}
 };
 
@@ -48,6 +49,39 @@ constexpr auto ONE_RETURNVAL    = 1;
 constexpr auto TWO_RETURNVALS   = 2;
 constexpr auto THREE_RETURNVALS = 3;
 constexpr auto FOUR_RETURNVALS  = 4;
+
+// closures that point into a request are valid only while its script runs.
+// a lua state that is reused by later requests may still reach them (e.g. if
+// the script stored them in the "string" table), so each of them takes the
+// token of its run as an extra, last, upvalue, and fails once the run is over
+
+// start a run: closures pushed from now on are valid until end_run()
+void start_run(lua_State* L);
+
+// invalidate the closures of the current run
+void end_run(lua_State* L);
+
+// push the token of the current run
+void push_run_token(lua_State* L);
+
+template<lua_CFunction Closure, int Upvals>
+int run_checked_closure(lua_State* L)
+{
+  const auto valid = reinterpret_cast<const bool*>(lua_touserdata(L, lua_upvalueindex(Upvals + 1)));
+  if (!valid || !*valid) {
+    throw std::runtime_error("trying to access a request that is no longer valid");
+  }
+  return Closure(L);
+}
+
+// same as lua_pushcclosure(), for a closure whose upvalues point into the request
+template<lua_CFunction Closure, int Upvals>
+void push_request_closure(lua_State* L)
+{
+  push_run_token(L);
+  lua_pushcclosure(L, (run_checked_closure<Closure, Upvals>), Upvals + 1);
+}
+
 // utility functions to create a metatable
 // and tie it to an unnamed table
 //
@@ -103,25 +137,25 @@ void create_metatable(lua_State* L, bool toplevel, Upvalues... upvalues)
   for (const auto upvalue : upvalue_arr) {
     lua_pushlightuserdata(L, upvalue);
   }
-  lua_pushcclosure(L, MetaTable::IndexClosure, upvals_size);
+  push_request_closure<MetaTable::IndexClosure, upvals_size>(L);
   lua_rawset(L, -3);
   lua_pushliteral(L, "__newindex");
   for (const auto upvalue : upvalue_arr) {
     lua_pushlightuserdata(L, upvalue);
   }
-  lua_pushcclosure(L, MetaTable::NewIndexClosure, upvals_size);
+  push_request_closure<MetaTable::NewIndexClosure, upvals_size>(L);
   lua_rawset(L, -3);
   lua_pushliteral(L, "__pairs");
   for (const auto upvalue : upvalue_arr) {
     lua_pushlightuserdata(L, upvalue);
   }
-  lua_pushcclosure(L, MetaTable::PairsClosure, upvals_size);
+  push_request_closure<MetaTable::PairsClosure, upvals_size>(L);
   lua_rawset(L, -3);
   lua_pushliteral(L, "__len");
   for (const auto upvalue : upvalue_arr) {
     lua_pushlightuserdata(L, upvalue);
   }
-  lua_pushcclosure(L, MetaTable::LenClosure, upvals_size);
+  push_request_closure<MetaTable::LenClosure, upvals_size>(L);
   lua_rawset(L, -3);
   // tie metatable and table
   lua_setmetatable(L, -2);
@@ -355,6 +355,7 @@ int radosgw_Main(int argc, const char **argv)
   mutex.unlock();
 
   rgw_log_usage_init(g_ceph_context, store->getRados());
+  rgw_log_ops_init(g_ceph_context, store->getRados());
 
   RGWREST rest;
 
@@ -647,6 +648,7 @@ int radosgw_Main(int argc, const char **argv)
   shutdown_async_signal_handler();
 
   rgw_log_usage_finalize();
+  rgw_log_ops_finalize();
 
   delete olog;
 
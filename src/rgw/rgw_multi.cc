@@ -4,16 +4,19 @@
 #include <string.h>
 
 #include <iostream>
+#include <limits>
 #include <map>
 
 #include "include/types.h"
 
 #include "rgw_xml.h"
+#include "rgw_aio_throttle.h"
 #include "rgw_multi.h"
 #include "rgw_op.h"
 #include "rgw_sal.h"
 #include "rgw_sal_rados.h"
 
+#include "services/svc_rados.h"
 #include "services/svc_sys_obj.h"
 #include "services/svc_tier_rados.h"
 
@@ -200,6 +203,139 @@ int list_multipart_parts(rgw::sal::RGWRadosStore *store, struct req_state *s,
 			      next_marker, truncated, assume_unsorted);
 }
 
+void get_multipart_parts_pages(const map<int, string>& expected,
+			       int max_parts,
+			       vector<RGWMultipartPartsPage>& pages)
+{
+  pages.clear();
+  auto e = expected.begin();
+  int last_num = 0;
+  while (e != expected.end()) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%08d", last_num);
+
+    RGWMultipartPartsPage page;
+    page.start_after = string("part.") + buf;
+    for (; e != expected.end() && page.max_entries < max_parts; ++e) {
+      last_num = e->first;
+      ++page.max_entries;
+    }
+    if (e == expected.end()) {
+      ++page.max_entries;
+    }
+    pages.push_back(std::move(page));
+  }
+}
+
+int decode_multipart_parts(CephContext *cct,
+			   const vector<map<string, bufferlist>>& pages,
+			   const map<int, string>& expected,
+			   map<uint32_t, RGWUploadPartInfo>& parts,
+			   bool *matched)
+{
+  parts.clear();
+  *matched = true;
+  auto e = expected.begin();
+  for (auto& vals : pages) {
+    for (auto& [key, bl] : vals) {
+      RGWUploadPartInfo info;
+      try {
+	auto bli = bl.cbegin();
+	decode(info, bli);
+      } catch (buffer::error& err) {
+	ldout(cct, 0) << "ERROR: could not part info, caught buffer::error" <<
+	  dendl;
+	return -EIO;
+      }
+      if (e == expected.end() || info.num != (uint32_t)e->first) {
+	/* a part is missing or wasn't asked for, or a gateway that doesn't
+	 * sort the omap keys worked on this upload */
+	parts.clear();
+	*matched = false;
+	return 0;
+      }
+      ++e;
+      parts[info.num] = std::move(info);
+    }
+  }
+  return 0;
+}
+
+int read_multipart_parts(rgw::sal::RGWRadosStore *store, struct req_state *s,
+			 const string& upload_id,
+			 const string& meta_oid,
+			 const map<int, string>& expected,
+			 int max_parts, int window,
+			 map<uint32_t, RGWUploadPartInfo>& parts,
+			 optional_yield y)
+{
+  RGWBucketInfo& bucket_info = s->bucket->get_info();
+  CephContext *cct = s->cct;
+
+  if (!is_v2_upload_id(upload_id)) {
+    /* the omap isn't sorted by part number, it's read whole anyway */
+    return list_multipart_parts(store, bucket_info, cct, upload_id, meta_oid,
+				std::numeric_limits<int>::max(), 0, parts,
+				nullptr, nullptr, true);
+  }
+
+  rgw_obj obj;
+  obj.init_ns(bucket_info.bucket, meta_oid, RGW_OBJ_NS_MULTIPART);
+  obj.set_in_extra_data(true);
+
+  rgw_raw_obj raw_obj;
+  store->getRados()->obj_to_raw(bucket_info.placement_rule, obj, &raw_obj);
+
+  auto rados_obj = store->svc()->rados->obj(raw_obj);
+  int r = rados_obj.open();
+  if (r < 0) {
+    return r;
+  }
+
+  vector<RGWMultipartPartsPage> pages;
+  get_multipart_parts_pages(expected, max_parts, pages);
+  vector<map<string, bufferlist>> vals(pages.size());
+  vector<int> rvals(pages.size(), 0);
+  auto aio = rgw::make_throttle(std::max(window, 1), y);
+  for (size_t i = 0; i < pages.size(); ++i) {
+    librados::ObjectReadOperation op;
+    op.omap_get_vals2(pages[i].start_after, string(), pages[i].max_entries,
+		      &vals[i], nullptr, &rvals[i]);
+    auto completed = aio->get(rados_obj,
+			      rgw::Aio::librados_op(std::move(op), y), 1, i);
+    r = rgw::check_for_errors(completed);
+    if (r < 0) {
+      aio->drain();
+      return r;
+    }
+  }
+  r = rgw::check_for_errors(aio->drain());
+  if (r < 0) {
+    return r;
+  }
+  for (auto rval : rvals) {
+    if (rval < 0) {
+      return rval;
+    }
+  }
+
+  bool matched;
+  r = decode_multipart_parts(cct, vals, expected, parts, &matched);
+  if (r < 0) {
+    return r;
+  }
+  if (!matched) {
+    /* read it all and let the caller sort it out */
+    ldout(cct, 10) << "parts of " << meta_oid << " don't match the "
+      "requested ones, reading them all" << dendl;
+    return list_multipart_parts(store, bucket_info, cct, upload_id,
+				meta_oid, std::numeric_limits<int>::max(),
+				0, parts, nullptr, nullptr, true);
+  }
+
+  return 0;
+}
+
 int abort_multipart_upload(rgw::sal::RGWRadosStore *store, CephContext *cct,
 			   RGWObjectCtx *obj_ctx, RGWBucketInfo& bucket_info,
 			   RGWMPObj& mp_obj)
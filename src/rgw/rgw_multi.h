@@ -5,6 +5,7 @@
 #define CEPH_RGW_MULTI_H
 
 #include <map>
+#include "common/async/yield_context.h"
 #include "rgw_xml.h"
 #include "rgw_obj_manifest.h"
 #include "rgw_compression_types.h"
@@ -123,6 +124,37 @@ extern int list_multipart_parts(rgw::sal::RGWRadosStore *store, struct req_state
                                 int *next_marker, bool *truncated,
                                 bool assume_unsorted = false);
 
+/* an omap read of read_multipart_parts() */
+struct RGWMultipartPartsPage {
+  string start_after;
+  int max_entries{0};
+};
+
+/* each page starts after the last part the previous one should hold. the
+ * last page asks for one more, to catch parts the client didn't list */
+extern void get_multipart_parts_pages(const map<int, string>& expected,
+                                      int max_parts,
+                                      vector<RGWMultipartPartsPage>& pages);
+
+/* decodes the parts read in the pages into parts. *matched is cleared if
+ * they aren't the expected ones, in which case the omap is read whole */
+extern int decode_multipart_parts(CephContext *cct,
+                                  const vector<map<string, bufferlist>>& pages,
+                                  const map<int, string>& expected,
+                                  map<uint32_t, RGWUploadPartInfo>& parts,
+                                  bool *matched);
+
+/* reads all the parts of an upload, as for its completion. expected holds
+ * the part numbers the client asked for, which tell where each page of
+ * max_parts parts starts, so that up to window pages are read at once */
+extern int read_multipart_parts(rgw::sal::RGWRadosStore *store, struct req_state *s,
+                                const string& upload_id,
+                                const string& meta_oid,
+                                const map<int, string>& expected,
+                                int max_parts, int window,
+                                map<uint32_t, RGWUploadPartInfo>& parts,
+                                optional_yield y);
+
 extern int abort_multipart_upload(rgw::sal::RGWRadosStore *store, CephContext *cct, RGWObjectCtx *obj_ctx,
                                 RGWBucketInfo& bucket_info, RGWMPObj& mp_obj);
 
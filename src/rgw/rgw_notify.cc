@@ -682,7 +682,7 @@ int publish_reserve(EventType event_type,
       const auto& queue_name = topic_cfg.dest.arn_topic;
       cls_2pc_queue_reserve(op, res.size, 1, &obl, &rval);
       auto ret = rgw_rados_operate(res.store->getRados()->get_notif_pool_ctx(), 
-          queue_name, &op, res.s->yield, librados::OPERATION_RETURNVEC);
+          queue_name, &op, res.yield, librados::OPERATION_RETURNVEC);
       if (ret < 0) {
         ldout(res.s->cct, 1) << "ERROR: failed to reserve notification on queue: " << queue_name 
           << ". error: " << ret << dendl;
@@ -732,7 +732,7 @@ int publish_commit(const rgw::sal::RGWObject* obj,
         cls_2pc_queue_abort(op, topic.res_id);
         auto ret = rgw_rados_operate(res.store->getRados()->get_notif_pool_ctx(),
             topic.cfg.dest.arn_topic, &op,
-            res.s->yield);
+            res.yield);
         if (ret < 0) {
           ldout(res.s->cct, 1) << "ERROR: failed to abort reservation: " << topic.res_id << 
             " when trying to make a larger reservation on queue: " << queue_name
@@ -744,7 +744,7 @@ int publish_commit(const rgw::sal::RGWObject* obj,
         int rval;
         cls_2pc_queue_reserve(op, bl.length(), 1, &obl, &rval);
         ret = rgw_rados_operate(res.store->getRados()->get_notif_pool_ctx(), 
-          queue_name, &op, res.s->yield, librados::OPERATION_RETURNVEC);
+          queue_name, &op, res.yield, librados::OPERATION_RETURNVEC);
         if (ret < 0) {
           ldout(res.s->cct, 1) << "ERROR: failed to reserve extra space on queue: " << queue_name
             << ". error: " << ret << dendl;
@@ -761,7 +761,7 @@ int publish_commit(const rgw::sal::RGWObject* obj,
       cls_2pc_queue_commit(op, bl_data_vec, topic.res_id);
       const auto ret = rgw_rados_operate(res.store->getRados()->get_notif_pool_ctx(),
             queue_name, &op,
-            res.s->yield);
+            res.yield);
       topic.res_id = cls_2pc_reservation::NO_ID;
       if (ret < 0) {
         ldout(res.s->cct, 1) << "ERROR: failed to commit reservation to queue: " << queue_name
@@ -776,7 +776,7 @@ int publish_commit(const rgw::sal::RGWObject* obj,
                 RGWHTTPArgs(topic.cfg.dest.push_endpoint_args), 
                 res.s->cct);
         ldout(res.s->cct, 20) << "INFO: push endpoint created: " << topic.cfg.dest.push_endpoint << dendl;
-        const auto ret = push_endpoint->send_to_completion_async(res.s->cct, record_with_endpoint.record, res.s->yield);
+        const auto ret = push_endpoint->send_to_completion_async(res.s->cct, record_with_endpoint.record, res.yield);
         if (ret < 0) {
           ldout(res.s->cct, 1) << "ERROR: push to endpoint " << topic.cfg.dest.push_endpoint << " failed. error: " << ret << dendl;
           if (perfcounter) perfcounter->inc(l_rgw_pubsub_push_failed);
@@ -805,7 +805,7 @@ int publish_abort(reservation_t& res) {
     cls_2pc_queue_abort(op, topic.res_id);
     const auto ret = rgw_rados_operate(res.store->getRados()->get_notif_pool_ctx(),
       queue_name, &op,
-      res.s->yield);
+      res.yield);
     if (ret < 0) {
       ldout(res.s->cct, 1) << "ERROR: failed to abort reservation: " << topic.res_id << 
         " from queue: " << queue_name << ". error: " << ret << dendl;
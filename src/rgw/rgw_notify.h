@@ -57,9 +57,15 @@ struct reservation_t {
   const req_state* const s;
   size_t size;
   const rgw::sal::RGWObject* const object;
+  // the request's, unless the op runs on a coroutine of its own
+  optional_yield yield;
 
   reservation_t(rgw::sal::RGWRadosStore* _store, const req_state* _s, const rgw::sal::RGWObject* _object) : 
-      store(_store), s(_s), object(_object) {}
+      store(_store), s(_s), object(_object), yield(_s->yield) {}
+
+  reservation_t(rgw::sal::RGWRadosStore* _store, const req_state* _s, const rgw::sal::RGWObject* _object,
+      optional_yield _yield) :
+      store(_store), s(_s), object(_object), yield(_yield) {}
 
   // dtor doing resource leak guarding
   // aborting the reservation if not already committed or aborted
@@ -0,0 +1,204 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+#include "rgw_obj_head_cache.h"
+#include "rgw_cache.h"
+#include "rgw_perf_counters.h"
+
+#define dout_subsys ceph_subsys_rgw
+
+RGWObjHeadCache::RGWObjHeadCache(CephContext *_cct,
+				 RGWSI_Notify *_notify_svc)
+  : cct(_cct), notify_svc(_notify_svc)
+{
+  const auto& conf = cct->_conf;
+  const auto num_shards =
+    std::max<uint64_t>(1, conf.get_val<uint64_t>("rgw_obj_head_cache_shards"));
+  const auto size = conf.get_val<uint64_t>("rgw_obj_head_cache_size");
+  max_per_shard = std::max<uint64_t>(1, size / num_shards);
+  expiry = std::chrono::seconds(
+    conf.get_val<uint64_t>("rgw_obj_head_cache_expiry_interval"));
+  max_data = conf.get_val<Option::size_t>("rgw_obj_head_cache_max_data");
+
+  shards.reserve(num_shards);
+  for (uint64_t i = 0; i < num_shards; ++i) {
+    shards.emplace_back(std::make_unique<Shard>());
+  }
+
+  notify_svc->register_watch_cb(this);
+}
+
+RGWObjHeadCache::~RGWObjHeadCache()
+{
+  notify_svc->unregister_watch_cb(this);
+}
+
+std::string RGWObjHeadCache::get_key(const rgw_raw_obj& obj)
+{
+  std::string buf;
+  buf.reserve(obj.pool.name.size() + obj.pool.ns.size() + obj.oid.size() +
+	      obj.loc.size() + 3);
+  buf.append(obj.pool.name).append("+").append(obj.pool.ns).append("+")
+    .append(obj.loc).append("+").append(obj.oid);
+  return buf;
+}
+
+RGWObjHeadCache::Shard& RGWObjHeadCache::get_shard(const std::string& key)
+{
+  return *shards[std::hash<std::string>{}(key) % shards.size()];
+}
+
+uint64_t RGWObjHeadCache::get_gen(const std::string& key)
+{
+  auto& shard = get_shard(key);
+  std::lock_guard l{shard.lock};
+  return shard.gen;
+}
+
+bool RGWObjHeadCache::find(const std::string& key, RGWObjHeadCacheEntry& head)
+{
+  if (!enabled) {
+    return false;
+  }
+
+  auto& shard = get_shard(key);
+  std::unique_lock l{shard.lock};
+  auto iter = shard.entries.find(key);
+  if (iter == shard.entries.end()) {
+    l.unlock();
+    ldout(cct, 20) << "obj head cache get: name=" << key << " : miss" << dendl;
+    if (perfcounter) {
+      perfcounter->inc(l_rgw_obj_head_cache_miss);
+    }
+    return false;
+  }
+
+  auto& entry = iter->second;
+  if (expiry.count() &&
+      (ceph::coarse_mono_clock::now() - entry.time_added) > expiry) {
+    shard.lru.erase(entry.lru_iter);
+    shard.entries.erase(iter);
+    l.unlock();
+    ldout(cct, 20) << "obj head cache get: name=" << key
+		   << " : expiry miss" << dendl;
+    if (perfcounter) {
+      perfcounter->inc(l_rgw_obj_head_cache_miss);
+    }
+    return false;
+  }
+
+  shard.lru.splice(shard.lru.begin(), shard.lru, entry.lru_iter);
+  head = entry.head;
+  l.unlock();
+
+  ldout(cct, 20) << "obj head cache get: name=" << key << " : hit" << dendl;
+  if (perfcounter) {
+    perfcounter->inc(l_rgw_obj_head_cache_hit);
+  }
+  return true;
+}
+
+void RGWObjHeadCache::put(const std::string& key, uint64_t gen,
+			  const RGWObjHeadCacheEntry& head)
+{
+  if (!enabled) {
+    return;
+  }
+
+  auto& shard = get_shard(key);
+  std::lock_guard l{shard.lock};
+  if (shard.gen != gen) {
+    ldout(cct, 20) << "obj head cache put: name=" << key
+		   << " : raced with invalidation, not caching" << dendl;
+    return;
+  }
+
+  auto [iter, inserted] = shard.entries.try_emplace(key);
+  auto& entry = iter->second;
+  if (inserted) {
+    shard.lru.push_front(key);
+    entry.lru_iter = shard.lru.begin();
+  } else {
+    shard.lru.splice(shard.lru.begin(), shard.lru, entry.lru_iter);
+  }
+  entry.head = head;
+  if (entry.head.has_data && entry.head.data.length() > max_data) {
+    entry.head.has_data = false;
+    entry.head.data.clear();
+  }
+  entry.time_added = ceph::coarse_mono_clock::now();
+
+  while (shard.entries.size() > max_per_shard) {
+    shard.entries.erase(shard.lru.back());
+    shard.lru.pop_back();
+  }
+}
+
+void RGWObjHeadCache::remove(const std::string& key)
+{
+  auto& shard = get_shard(key);
+  std::lock_guard l{shard.lock};
+  ++shard.gen;
+  auto iter = shard.entries.find(key);
+  if (iter != shard.entries.end()) {
+    shard.lru.erase(iter->second.lru_iter);
+    shard.entries.erase(iter);
+  }
+}
+
+void RGWObjHeadCache::invalidate(const rgw_raw_obj& obj, optional_yield y)
+{
+  remove(get_key(obj));
+
+  RGWCacheNotifyInfo info;
+  info.op = REMOVE_OBJ;
+  info.obj = obj;
+  bufferlist bl;
+  encode(info, bl);
+
+  if (!y) {
+    /* most writers complete the index without the request's yield
+     * context; don't block their thread on the notify round trip */
+    notify_svc->distribute_async(obj.oid, bl);
+    return;
+  }
+
+  int r = notify_svc->distribute(obj.oid, bl, y);
+  if (r < 0) {
+    ldout(cct, 0) << "ERROR: " << __func__ << "(): failed to distribute "
+		  << "obj head invalidation for " << obj << ": r=" << r << dendl;
+  }
+}
+
+int RGWObjHeadCache::watch_cb(uint64_t notify_id,
+			      uint64_t cookie,
+			      uint64_t notifier_id,
+			      bufferlist& bl)
+{
+  RGWCacheNotifyInfo info;
+  try {
+    auto iter = bl.cbegin();
+    decode(info, iter);
+  } catch (buffer::error& err) {
+    /* the metadata cache reports bad notifications */
+    return 0;
+  }
+
+  /* the metadata cache shares the control objects; its updates never
+   * name a user object head, so any op only drops what we may hold */
+  remove(get_key(info.obj));
+  return 0;
+}
+
+void RGWObjHeadCache::set_enabled(bool status)
+{
+  enabled = status;
+  if (!status) {
+    for (auto& shard : shards) {
+      std::lock_guard l{shard->lock};
+      ++shard->gen;
+      shard->entries.clear();
+      shard->lru.clear();
+    }
+  }
+}
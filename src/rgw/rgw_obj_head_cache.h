@@ -0,0 +1,92 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/ceph_mutex.h"
+#include "common/ceph_time.h"
+#include "rgw_common.h"
+#include "services/svc_notify.h"
+
+/* what get_obj_state() reads from a head object */
+struct RGWObjHeadCacheEntry {
+  uint64_t size{0};
+  ceph::real_time mtime;
+  uint64_t epoch{0};
+  std::map<std::string, bufferlist> attrs;
+  bool has_data{false};
+  bufferlist data;
+};
+
+/*
+ * Bounded LRU of user object heads, split into independently locked
+ * shards. Gateways that modify an object notify the others through the
+ * control objects, which drop the entry; the expiry interval bounds
+ * staleness if a notify is lost. The cache stays disabled while any
+ * watch on the control objects is broken, like the metadata cache.
+ */
+class RGWObjHeadCache : public RGWSI_Notify::CB {
+  struct Entry {
+    RGWObjHeadCacheEntry head;
+    ceph::coarse_mono_time time_added;
+    std::list<std::string>::iterator lru_iter;
+  };
+
+  struct Shard {
+    ceph::mutex lock = ceph::make_mutex("RGWObjHeadCache::Shard");
+    std::unordered_map<std::string, Entry> entries;
+    std::list<std::string> lru;
+    uint64_t gen{0};
+  };
+
+  CephContext *cct;
+  RGWSI_Notify *notify_svc;
+
+  std::vector<std::unique_ptr<Shard>> shards;
+  size_t max_per_shard;
+  ceph::timespan expiry;
+  uint64_t max_data;
+
+  std::atomic<bool> enabled{false};
+
+  Shard& get_shard(const std::string& key);
+  void remove(const std::string& key);
+
+public:
+  RGWObjHeadCache(CephContext *_cct, RGWSI_Notify *_notify_svc);
+  ~RGWObjHeadCache() override;
+
+  static std::string get_key(const rgw_raw_obj& obj);
+
+  uint64_t get_max_data() const {
+    return max_data;
+  }
+
+  /* sample before reading the head from rados and hand back to put(),
+   * so a read that raced with an invalidation is not cached */
+  uint64_t get_gen(const std::string& key);
+
+  /* entries may lack the head data (has_data), which readers then fetch
+   * from rados as usual */
+  bool find(const std::string& key, RGWObjHeadCacheEntry& head);
+  void put(const std::string& key, uint64_t gen,
+	   const RGWObjHeadCacheEntry& head);
+
+  /* drop the entry here and on all other gateways. without a yield
+   * context, the notify is sent without waiting for the acks */
+  void invalidate(const rgw_raw_obj& obj, optional_yield y);
+
+  int watch_cb(uint64_t notify_id,
+	       uint64_t cookie,
+	       uint64_t notifier_id,
+	       bufferlist& bl) override;
+  void set_enabled(bool status) override;
+};
@@ -10,6 +10,7 @@
 #include <string_view>
 
 #include <boost/algorithm/string/predicate.hpp>
+#include <boost/asio/deadline_timer.hpp>
 #include <boost/optional.hpp>
 #include <boost/utility/in_place_factory.hpp>
 
@@ -1550,7 +1551,7 @@ int RGWGetObj::read_user_manifest_part(rgw::sal::RGWBucket* bucket,
           << ", actual read size=" << ent.meta.size << dendl;
       return -EIO;
     }
-    decompress.emplace(s->cct, &cs_info, partial_content, filter);
+    decompress.emplace(s->cct, &cs_info, partial_content, filter, s->yield);
     filter = &*decompress;
   }
   else
@@ -2148,7 +2149,7 @@ void RGWGetObj::execute(optional_yield y)
   if (need_decompress) {
       s->obj_size = cs_info.orig_size;
       s->object->set_obj_size(cs_info.orig_size);
-      decompress.emplace(s->cct, &cs_info, partial_content, filter);
+      decompress.emplace(s->cct, &cs_info, partial_content, filter, s->yield);
       filter = &*decompress;
   }
 
@@ -3657,7 +3658,7 @@ int RGWPutObj::get_data(const off_t fst, const off_t lst, bufferlist& bl)
   if (need_decompress)
   {
     obj_size = cs_info.orig_size;
-    decompress.emplace(s->cct, &cs_info, partial_content, filter);
+    decompress.emplace(s->cct, &cs_info, partial_content, filter, s->yield);
     filter = &*decompress;
   }
 
@@ -3907,7 +3908,7 @@ void RGWPutObj::execute(optional_yield y)
         ldpp_dout(this, 1) << "Cannot load plugin for compression type "
             << compression_type << dendl;
       } else {
-        compressor.emplace(s->cct, plugin, filter);
+        compressor.emplace(s->cct, plugin, filter, s->yield);
         filter = &*compressor;
       }
     }
@@ -4217,7 +4218,7 @@ void RGWPostObj::execute(optional_yield y)
           ldpp_dout(this, 1) << "Cannot load plugin for compression type "
                            << compression_type << dendl;
         } else {
-          compressor.emplace(s->cct, plugin, filter);
+          compressor.emplace(s->cct, plugin, filter, s->yield);
           filter = &*compressor;
         }
       }
@@ -5963,8 +5964,8 @@ void RGWCompleteMultipart::execute(optional_yield y)
   int total_parts = 0;
   int handled_parts = 0;
   int max_parts = 1000;
-  int marker = 0;
-  bool truncated;
+  int window =
+    s->cct->_conf.get_val<int64_t>("rgw_multipart_complete_window");
   RGWCompressionInfo cs_info;
   bool compressed = false;
   uint64_t accounted_size = 0;
@@ -6004,17 +6005,22 @@ void RGWCompleteMultipart::execute(optional_yield y)
   }
   attrs = meta_obj->get_attrs();
 
-  do {
-    op_ret = list_multipart_parts(store, s, upload_id, meta_oid, max_parts,
-				  marker, obj_parts, &marker, &truncated);
+  {
+    const auto list_start = ceph::coarse_mono_clock::now();
+    op_ret = read_multipart_parts(store, s, upload_id, meta_oid, parts->parts,
+				  max_parts, window, obj_parts, y);
     if (op_ret == -ENOENT) {
       op_ret = -ERR_NO_SUCH_UPLOAD;
     }
     if (op_ret < 0)
       return;
+    if (perfcounter) {
+      perfcounter->tinc(l_rgw_complete_mp_list_lat,
+                        ceph::coarse_mono_clock::now() - list_start);
+    }
 
-    total_parts += obj_parts.size();
-    if (!truncated && total_parts != (int)parts->parts.size()) {
+    total_parts = obj_parts.size();
+    if (total_parts != (int)parts->parts.size()) {
       ldpp_dout(this, 0) << "NOTICE: total parts mismatch: have: " << total_parts
 		       << " expected: " << parts->parts.size() << dendl;
       op_ret = -ERR_INVALID_PART;
@@ -6103,7 +6109,7 @@ void RGWCompleteMultipart::execute(optional_yield y)
       ofs += obj_part.size;
       accounted_size += obj_part.accounted_size;
     }
-  } while (truncated);
+  }
   hash.Final((unsigned char *)final_etag);
 
   buf_to_hex((unsigned char *)final_etag, sizeof(final_etag), final_etag_str);
@@ -6411,13 +6417,122 @@ void RGWDeleteMultiObj::pre_exec()
   rgw_bucket_object_pre_exec(s);
 }
 
+void RGWDeleteMultiObj::wait_flush(optional_yield y,
+				   boost::asio::deadline_timer *formatter_flush_cond,
+				   std::function<bool()> predicate)
+{
+  if (y && formatter_flush_cond) {
+    auto yc = y.get_yield_context();
+    while (!predicate()) {
+      boost::system::error_code ec;
+      formatter_flush_cond->async_wait(yc[ec]);
+      rgw_flush_formatter(s, s->formatter);
+    }
+  }
+}
+
+void RGWDeleteMultiObj::handle_individual_object(rgw_obj_key& o, optional_yield y,
+						 boost::asio::deadline_timer *formatter_flush_cond)
+{
+  RGWObjectCtx *obj_ctx = static_cast<RGWObjectCtx *>(s->obj_ctx);
+  std::string version_id;
+  std::unique_ptr<rgw::sal::RGWObject> obj = bucket->get_object(o);
+  if (s->iam_policy || ! s->iam_user_policies.empty()) {
+    auto usr_policy_res = eval_user_policies(s->iam_user_policies, s->env,
+                                            boost::none,
+                                            o.instance.empty() ?
+                                            rgw::IAM::s3DeleteObject :
+                                            rgw::IAM::s3DeleteObjectVersion,
+                                            ARN(obj->get_obj()));
+    if (usr_policy_res == Effect::Deny) {
+      send_partial_response(o, false, "", -EACCES, formatter_flush_cond);
+      return;
+    }
+
+    rgw::IAM::Effect e = Effect::Pass;
+    if (s->iam_policy) {
+      e = s->iam_policy->eval(s->env,
+				   *s->auth.identity,
+				   o.instance.empty() ?
+				   rgw::IAM::s3DeleteObject :
+				   rgw::IAM::s3DeleteObjectVersion,
+				   ARN(obj->get_obj()));
+    }
+    if ((e == Effect::Deny) || 
+        (usr_policy_res == Effect::Pass && e == Effect::Pass && !acl_allowed)) {
+	      send_partial_response(o, false, "", -EACCES, formatter_flush_cond);
+	      return;
+    }
+  }
+
+  // verify_object_lock
+  bool check_obj_lock = obj->have_instance() && bucket->get_info().obj_lock_enabled();
+  if (check_obj_lock) {
+    int get_attrs_response = obj->get_obj_attrs(s->obj_ctx, y);
+    if (get_attrs_response < 0) {
+      if (get_attrs_response == -ENOENT) {
+        // object maybe delete_marker, skip check_obj_lock
+        check_obj_lock = false;
+      } else {
+        // Something went wrong.
+        send_partial_response(o, false, "", get_attrs_response, formatter_flush_cond);
+        return;
+      }
+    }
+  }
+
+  if (check_obj_lock) {
+    int object_lock_response = verify_object_lock(this, obj->get_attrs(), bypass_perm, bypass_governance_mode);
+    if (object_lock_response != 0) {
+      send_partial_response(o, false, "", object_lock_response, formatter_flush_cond);
+      return;
+    }
+  }
+  // make reservation for notification if needed
+  const auto versioned_object = s->bucket->versioning_enabled();
+  rgw::notify::reservation_t res(store, s, obj.get(), y);
+  const auto event_type = versioned_object && obj->get_instance().empty() ? 
+      rgw::notify::ObjectRemovedDeleteMarkerCreated : rgw::notify::ObjectRemovedDelete;
+  int ret = rgw::notify::publish_reserve(event_type, res);
+  if (ret < 0) {
+    send_partial_response(o, false, "", ret, formatter_flush_cond);
+    return;
+  }
+
+  obj->set_atomic(obj_ctx);
+
+  ret = obj->delete_object(obj_ctx, s->owner, s->bucket_owner, ceph::real_time(),
+				false, 0, version_id, y);
+  if (ret == -ENOENT) {
+    ret = 0;
+  }
+
+  send_partial_response(o, obj->get_delete_marker(), version_id, ret, formatter_flush_cond);
+
+  const auto obj_state = obj_ctx->get_state(obj->get_obj());
+  bufferlist etag_bl;
+  const auto etag = obj_state->get_attr(RGW_ATTR_ETAG, etag_bl) ? etag_bl.to_str() : "";
+
+  // send request to notification manager
+  ret = rgw::notify::publish_commit(obj.get(), obj_state->size, obj_state->mtime, etag, event_type, res);
+  if (ret < 0) {
+    ldpp_dout(this, 1) << "ERROR: publishing notification failed, with error: " << ret << dendl;
+    // too late to rollback operation, hence op_ret is not set here
+  }
+}
+
 void RGWDeleteMultiObj::execute(optional_yield y)
 {
   RGWMultiDelDelete *multi_delete;
-  vector<rgw_obj_key>::iterator iter;
   RGWMultiDelXMLParser parser;
-  RGWObjectCtx *obj_ctx = static_cast<RGWObjectCtx *>(s->obj_ctx);
   char* buf;
+  /* with a yield context, the objects are deleted by up to
+   * rgw_multi_obj_del_max_aio coroutines at once, whose results are
+   * flushed to the client by this one */
+  std::optional<boost::asio::deadline_timer> formatter_flush_cond;
+  uint32_t aio_count = 0;
+  const uint32_t max_aio = std::max<int64_t>(1,
+    s->cct->_conf.get_val<int64_t>("rgw_multi_obj_del_max_aio"));
 
   buf = data.c_str();
   if (!buf) {
@@ -6475,94 +6590,31 @@ void RGWDeleteMultiObj::execute(optional_yield y)
     goto done;
   }
 
-  for (iter = multi_delete->objects.begin();
-        iter != multi_delete->objects.end();
-        ++iter) {
-    std::string version_id;
-    std::unique_ptr<rgw::sal::RGWObject> obj = bucket->get_object(*iter);
-    if (s->iam_policy || ! s->iam_user_policies.empty()) {
-      auto usr_policy_res = eval_user_policies(s->iam_user_policies, s->env,
-                                              boost::none,
-                                              iter->instance.empty() ?
-                                              rgw::IAM::s3DeleteObject :
-                                              rgw::IAM::s3DeleteObjectVersion,
-                                              ARN(obj->get_obj()));
-      if (usr_policy_res == Effect::Deny) {
-        send_partial_response(*iter, false, "", -EACCES);
-        continue;
-      }
-
-      rgw::IAM::Effect e = Effect::Pass;
-      if (s->iam_policy) {
-        e = s->iam_policy->eval(s->env,
-				   *s->auth.identity,
-				   iter->instance.empty() ?
-				   rgw::IAM::s3DeleteObject :
-				   rgw::IAM::s3DeleteObjectVersion,
-				   ARN(obj->get_obj()));
-      }
-      if ((e == Effect::Deny) || 
-          (usr_policy_res == Effect::Pass && e == Effect::Pass && !acl_allowed)) {
-	      send_partial_response(*iter, false, "", -EACCES);
-	      continue;
-      }
-    }
-
-    // verify_object_lock
-    bool check_obj_lock = obj->have_instance() && bucket->get_info().obj_lock_enabled();
-    if (check_obj_lock) {
-      int get_attrs_response = obj->get_obj_attrs(s->obj_ctx, s->yield);
-      if (get_attrs_response < 0) {
-        if (get_attrs_response == -ENOENT) {
-          // object maybe delete_marker, skip check_obj_lock
-          check_obj_lock = false;
-        } else {
-          // Something went wrong.
-          send_partial_response(*iter, false, "", get_attrs_response);
-          continue;
-        }
-      }
-    }
-
-    if (check_obj_lock) {
-      int object_lock_response = verify_object_lock(this, obj->get_attrs(), bypass_perm, bypass_governance_mode);
-      if (object_lock_response != 0) {
-        send_partial_response(*iter, false, "", object_lock_response);
-        continue;
-      }
-    }
-    // make reservation for notification if needed
-    const auto versioned_object = s->bucket->versioning_enabled();
-    rgw::notify::reservation_t res(store, s, obj.get());
-    const auto event_type = versioned_object && obj->get_instance().empty() ? 
-        rgw::notify::ObjectRemovedDeleteMarkerCreated : rgw::notify::ObjectRemovedDelete;
-    op_ret = rgw::notify::publish_reserve(event_type, res);
-    if (op_ret < 0) {
-      send_partial_response(*iter, false, "", op_ret);
-      continue;
-    }
-
-    obj->set_atomic(obj_ctx);
-
-    op_ret = obj->delete_object(obj_ctx, s->owner, s->bucket_owner, ceph::real_time(),
-				false, 0, version_id, s->yield);
-    if (op_ret == -ENOENT) {
-      op_ret = 0;
-    }
-
-    send_partial_response(*iter, obj->get_delete_marker(), version_id, op_ret);
-
-    const auto obj_state = obj_ctx->get_state(obj->get_obj());
-    bufferlist etag_bl;
-    const auto etag = obj_state->get_attr(RGW_ATTR_ETAG, etag_bl) ? etag_bl.to_str() : "";
+  if (y) {
+    formatter_flush_cond.emplace(y.get_io_context(),
+				 boost::posix_time::pos_infin);
+  }
 
-    // send request to notification manager
-    const auto ret = rgw::notify::publish_commit(obj.get(), obj_state->size, obj_state->mtime, etag, event_type, res);
-    if (ret < 0) {
-      ldpp_dout(this, 1) << "ERROR: publishing notification failed, with error: " << ret << dendl;
-      // too late to rollback operation, hence op_ret is not set here
+  for (const auto& key : multi_delete->objects) {
+    if (formatter_flush_cond) {
+      wait_flush(y, &*formatter_flush_cond,
+		 [&aio_count, max_aio] { return aio_count < max_aio; });
+      ++aio_count;
+      spawn::spawn(y.get_yield_context(),
+		   [this, &y, &aio_count, key, &formatter_flush_cond]
+		   (spawn::yield_context yield) mutable {
+	handle_individual_object(key, optional_yield{y.get_io_context(), yield},
+				 &*formatter_flush_cond);
+	--aio_count;
+	formatter_flush_cond->cancel();
+      });
+    } else {
+      auto k = key;
+      handle_individual_object(k, y, nullptr);
     }
   }
+  wait_flush(y, formatter_flush_cond ? &*formatter_flush_cond : nullptr,
+	     [&aio_count] { return aio_count == 0; });
 
   /*  set the return code to zero, errors at this point will be
   dumped to the response */
@@ -7052,7 +7104,7 @@ int RGWBulkUploadOp::handle_file(const std::string_view path,
       ldpp_dout(this, 1) << "Cannot load plugin for rgw_compression_type "
           << compression_type << dendl;
     } else {
-      compressor.emplace(s->cct, plugin, filter);
+      compressor.emplace(s->cct, plugin, filter, s->yield);
       filter = &*compressor;
     }
   }
@@ -25,6 +25,7 @@
 #include <boost/optional.hpp>
 #include <boost/utility/in_place_factory.hpp>
 #include <boost/function.hpp>
+#include <boost/asio/deadline_timer.hpp>
 
 #include "common/armor.h"
 #include "common/mime.h"
@@ -1910,6 +1911,12 @@ protected:
   bool bypass_perm;
   bool bypass_governance_mode;
 
+  /* waits for predicate, flushing the results of the deletes in between */
+  void wait_flush(optional_yield y,
+                  boost::asio::deadline_timer *formatter_flush_cond,
+                  std::function<bool()> predicate);
+  void handle_individual_object(rgw_obj_key& o, optional_yield y,
+                                boost::asio::deadline_timer *formatter_flush_cond);
 
 public:
   RGWDeleteMultiObj() {
@@ -1925,8 +1932,11 @@ public:
   virtual int get_params(optional_yield y) = 0;
   virtual void send_status() = 0;
   virtual void begin_response() = 0;
+  /* formats the result for key. results are flushed right away, unless
+   * formatter_flush_cond is given: then it's signalled instead */
   virtual void send_partial_response(rgw_obj_key& key, bool delete_marker,
-                                     const string& marker_version_id, int ret) = 0;
+                                     const string& marker_version_id, int ret,
+                                     boost::asio::deadline_timer *formatter_flush_cond) = 0;
   virtual void end_response() = 0;
   const char* name() const override { return "multi_object_delete"; }
   RGWOpType get_type() override { return RGW_OP_DELETE_MULTI_OBJ; }
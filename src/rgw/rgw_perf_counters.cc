@@ -31,6 +31,24 @@ int rgw_perf_start(CephContext *cct)
   plb.add_u64_counter(l_rgw_cache_hit, "cache_hit", "Cache hits");
   plb.add_u64_counter(l_rgw_cache_miss, "cache_miss", "Cache miss");
 
+  plb.add_u64_counter(l_rgw_obj_head_cache_hit, "obj_head_cache_hit",
+		      "Object head cache hits");
+  plb.add_u64_counter(l_rgw_obj_head_cache_miss, "obj_head_cache_miss",
+		      "Object head cache miss");
+
+  plb.add_u64_counter(l_rgw_datacache_hit, "datacache_hit",
+		      "Data cache hits");
+  plb.add_u64_counter(l_rgw_datacache_miss, "datacache_miss",
+		      "Data cache miss");
+  plb.add_u64_counter(l_rgw_datacache_hit_b, "datacache_hit_b",
+		      "Bytes served from the data cache", NULL, 0,
+		      unit_t(UNIT_BYTES));
+  plb.add_u64_counter(l_rgw_datacache_write_b, "datacache_write_b",
+		      "Bytes written to the data cache", NULL, 0,
+		      unit_t(UNIT_BYTES));
+  plb.add_u64_counter(l_rgw_datacache_evict, "datacache_evict",
+		      "Data cache evictions");
+
   plb.add_u64_counter(l_rgw_keystone_token_cache_hit, "keystone_token_cache_hit", "Keystone token cache hits");
   plb.add_u64_counter(l_rgw_keystone_token_cache_miss, "keystone_token_cache_miss", "Keystone token cache miss");
 
@@ -49,6 +67,10 @@ int rgw_perf_start(CephContext *cct)
 		      "Lifecycle non-current transition");
   plb.add_u64_counter(l_rgw_lc_abort_mpu, "lc_abort_mpu",
 		      "Lifecycle abort multipart upload");
+  plb.add_u64_counter(l_rgw_lc_eval, "lc_eval",
+		      "Lifecycle objects evaluated");
+  plb.add_u64_counter(l_rgw_lc_remove, "lc_remove",
+		      "Lifecycle objects removed");
 
   plb.add_u64_counter(l_rgw_pubsub_event_triggered, "pubsub_event_triggered", "Pubsub events with at least one topic");
   plb.add_u64_counter(l_rgw_pubsub_event_lost, "pubsub_event_lost", "Pubsub events lost");
@@ -59,7 +81,64 @@ int rgw_perf_start(CephContext *cct)
   plb.add_u64_counter(l_rgw_pubsub_push_failed, "pubsub_push_failed", "Pubsub events failed to be pushed to an endpoint");
   plb.add_u64(l_rgw_pubsub_push_pending, "pubsub_push_pending", "Pubsub events pending reply from endpoint");
   plb.add_u64_counter(l_rgw_pubsub_missing_conf, "pubsub_missing_conf", "Pubsub events could not be handled because of missing configuration");
-  
+
+  plb.add_u64_counter(l_rgw_bucket_list_shard_entries,
+		      "bucket_list_shard_entries",
+		      "Index entries read from bucket shards by ordered listing");
+  plb.add_u64_counter(l_rgw_bucket_list_entries, "bucket_list_entries",
+		      "Entries returned by ordered bucket listing");
+  plb.add_u64_counter(l_rgw_bucket_list_shard_refill,
+		      "bucket_list_shard_refill",
+		      "Single-shard refills during ordered bucket listing");
+
+  plb.add_u64_counter(l_rgw_bucket_index_complete_batch,
+		      "bucket_index_complete_batch",
+		      "Batched bucket index completion calls");
+  plb.add_u64_counter(l_rgw_bucket_index_complete_batched,
+		      "bucket_index_complete_batched",
+		      "Bucket index completions sent in batches");
+
+  plb.add_u64_avg(l_rgw_get_obj_window, "get_obj_window",
+		  "Peak readahead window of object reads");
+  plb.add_u64_counter(l_rgw_get_obj_window_grow, "get_obj_window_grow",
+		      "Object read windows grown for fast clients");
+  plb.add_u64_counter(l_rgw_get_obj_window_shrink, "get_obj_window_shrink",
+		      "Object read windows shrunk for slow clients");
+  plb.add_u64_counter(l_rgw_get_obj_window_capped, "get_obj_window_capped",
+		      "Object read window growth refused by rgw_get_obj_window_total");
+
+  plb.add_u64_counter(l_rgw_select_scan_b, "select_scan_b",
+		      "Bytes read from objects by S3 Select requests");
+  plb.add_u64_counter(l_rgw_select_process_b, "select_process_b",
+		      "Bytes of the scan ranges queried by S3 Select requests");
+  plb.add_u64_counter(l_rgw_select_return_b, "select_return_b",
+		      "Record bytes returned by S3 Select requests");
+
+  plb.add_u64_counter(l_rgw_tenant_qos_reject, "tenant_qos_reject",
+		      "Requests rejected over a user or bucket limit");
+  plb.add_time_avg(l_rgw_tenant_qos_wait, "tenant_qos_wait",
+		   "Time requests waited in the user and bucket queues");
+
+  plb.add_time_avg(l_rgw_complete_mp_list_lat, "complete_mp_list_lat",
+		   "Time multipart completions spent reading the parts");
+
+  plb.add_u64_counter(l_rgw_ssl_handshake, "ssl_handshake",
+		      "SSL handshakes by the beast frontend");
+  plb.add_u64_counter(l_rgw_ssl_handshake_resumed, "ssl_handshake_resumed",
+		      "SSL handshakes that resumed a session");
+
+  plb.add_u64_counter(l_rgw_ops_log_queued, "ops_log_queued",
+		      "Ops log entries queued for batched writes");
+  plb.add_u64_counter(l_rgw_ops_log_dropped, "ops_log_dropped",
+		      "Ops log entries dropped with the queue full");
+  plb.add_u64_counter(l_rgw_ops_log_append, "ops_log_append",
+		      "Batched appends to ops log objects");
+
+  plb.add_u64_counter(l_rgw_lua_script_load, "lua_script_load",
+		      "Lua scripts compiled");
+  plb.add_u64_counter(l_rgw_lua_state_reuse, "lua_state_reuse",
+		      "Lua scripts run in a reused state");
+
   perfcounter = plb.create_perf_counters();
   cct->get_perfcounters_collection()->add(perfcounter);
   return 0;
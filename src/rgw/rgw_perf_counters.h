@@ -28,6 +28,15 @@ enum {
   l_rgw_cache_hit,
   l_rgw_cache_miss,
 
+  l_rgw_obj_head_cache_hit,
+  l_rgw_obj_head_cache_miss,
+
+  l_rgw_datacache_hit,
+  l_rgw_datacache_miss,
+  l_rgw_datacache_hit_b,
+  l_rgw_datacache_write_b,
+  l_rgw_datacache_evict,
+
   l_rgw_keystone_token_cache_hit,
   l_rgw_keystone_token_cache_miss,
 
@@ -39,6 +48,8 @@ enum {
   l_rgw_lc_transition_current,
   l_rgw_lc_transition_noncurrent,
   l_rgw_lc_abort_mpu,
+  l_rgw_lc_eval,
+  l_rgw_lc_remove,
 
   l_rgw_pubsub_event_triggered,
   l_rgw_pubsub_event_lost,
@@ -50,6 +61,37 @@ enum {
   l_rgw_pubsub_push_pending,
   l_rgw_pubsub_missing_conf,
 
+  l_rgw_bucket_list_shard_entries,
+  l_rgw_bucket_list_entries,
+  l_rgw_bucket_list_shard_refill,
+
+  l_rgw_bucket_index_complete_batch,
+  l_rgw_bucket_index_complete_batched,
+
+  l_rgw_get_obj_window,
+  l_rgw_get_obj_window_grow,
+  l_rgw_get_obj_window_shrink,
+  l_rgw_get_obj_window_capped,
+
+  l_rgw_select_scan_b,
+  l_rgw_select_process_b,
+  l_rgw_select_return_b,
+
+  l_rgw_tenant_qos_reject,
+  l_rgw_tenant_qos_wait,
+
+  l_rgw_complete_mp_list_lat,
+
+  l_rgw_ssl_handshake,
+  l_rgw_ssl_handshake_resumed,
+
+  l_rgw_ops_log_queued,
+  l_rgw_ops_log_dropped,
+  l_rgw_ops_log_append,
+
+  l_rgw_lua_script_load,
+  l_rgw_lua_state_reuse,
+
   l_rgw_last,
 };
 
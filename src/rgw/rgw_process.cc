@@ -181,7 +181,8 @@ int process_request(rgw::sal::RGWRadosStore* const store,
                     OpsLogSocket* const olog,
                     optional_yield yield,
 		    rgw::dmclock::Scheduler *scheduler,
-                    int* http_ret)
+                    int* http_ret,
+                    rgw::dmclock::TenantScheduler *tenant_scheduler)
 {
   int ret = client_io->init(g_ceph_context);
 
@@ -225,6 +226,7 @@ int process_request(rgw::sal::RGWRadosStore* const store,
                                                frontend_prefix,
                                                client_io, &mgr, &init_error);
   rgw::dmclock::SchedulerCompleter c;
+  std::optional<std::pair<std::string, std::string>> tenant;
   if (init_error != 0) {
     abort_early(s, nullptr, init_error, nullptr, yield);
     goto done;
@@ -241,13 +243,15 @@ int process_request(rgw::sal::RGWRadosStore* const store,
   }
   {
     std::string script;
-    auto rc = rgw::lua::read_script(store, s->bucket_tenant, s->yield, rgw::lua::context::preRequest, script);
+    obj_version script_version;
+    auto rc = rgw::lua::read_script(store, s->bucket_tenant, s->yield, rgw::lua::context::preRequest, script, &script_version);
     if (rc == -ENOENT) {
       // no script, nothing to do
     } else if (rc < 0) {
       ldpp_dout(op, 5) << "WARNING: failed to read pre request script. error: " << rc << dendl;
     } else {
-      rc = rgw::lua::request::execute(store, rest, olog, s, op->name(), script);
+      rc = rgw::lua::request::execute(store, rest, olog, s, op->name(), script,
+          rgw::lua::script_oid(rgw::lua::context::preRequest, s->bucket_tenant), &script_version);
       if (rc < 0) {
         ldpp_dout(op, 5) << "WARNING: failed to execute pre request script. error: " << rc << dendl;
       }
@@ -296,6 +300,33 @@ int process_request(rgw::sal::RGWRadosStore* const store,
       goto done;
     }
 
+    if (tenant_scheduler) {
+      std::string user = s->user->get_id().to_str();
+      std::string bucket;
+      if (!s->bucket_name.empty()) {
+        bucket = rgw_make_bucket_entry_name(s->bucket_tenant, s->bucket_name);
+      }
+      const auto start = ceph::coarse_mono_clock::now();
+      ret = tenant_scheduler->schedule_request(user, bucket, yield);
+      if (ret < 0) {
+        if (ret == -EAGAIN) {
+          ret = -ERR_RATE_LIMITED;
+          if (perfcounter) {
+            perfcounter->inc(l_rgw_tenant_qos_reject);
+          }
+        }
+        ldpp_dout(op, 2) << "tenant scheduling failed with " << ret
+            << " user=" << user << " bucket=" << bucket << dendl;
+        abort_early(s, op, ret, handler, yield);
+        goto done;
+      }
+      if (perfcounter) {
+        perfcounter->tinc(l_rgw_tenant_qos_wait,
+                          ceph::coarse_mono_clock::now() - start);
+      }
+      tenant.emplace(std::move(user), std::move(bucket));
+    }
+
     ret = rgw_process_authenticated(handler, op, req, s, yield);
     if (ret < 0) {
       abort_early(s, op, ret, handler, yield);
@@ -309,13 +340,15 @@ int process_request(rgw::sal::RGWRadosStore* const store,
 done:
   if (op) {
     std::string script;
-    auto rc = rgw::lua::read_script(store, s->bucket_tenant, s->yield, rgw::lua::context::postRequest, script);
+    obj_version script_version;
+    auto rc = rgw::lua::read_script(store, s->bucket_tenant, s->yield, rgw::lua::context::postRequest, script, &script_version);
     if (rc == -ENOENT) {
       // no script, nothing to do
     } else if (rc < 0) {
       ldpp_dout(op, 5) << "WARNING: failed to read post request script. error: " << rc << dendl;
     } else {
-      rc = rgw::lua::request::execute(store, rest, olog, s, op->name(), script);
+      rc = rgw::lua::request::execute(store, rest, olog, s, op->name(), script,
+          rgw::lua::script_oid(rgw::lua::context::postRequest, s->bucket_tenant), &script_version);
       if (rc < 0) {
         ldpp_dout(op, 5) << "WARNING: failed to execute post request script. error: " << rc << dendl;
       }
@@ -333,6 +366,12 @@ done:
     rgw_log_op(store->getRados(), rest, s, (op ? op->name() : "unknown"), olog);
   }
 
+  if (tenant) {
+    tenant_scheduler->request_complete(tenant->first, tenant->second,
+                                       ACCOUNTING_IO(s)->get_bytes_sent() +
+                                       ACCOUNTING_IO(s)->get_bytes_received());
+  }
+
   if (http_ret != nullptr) {
     *http_ret = s->err.http_ret;
   }
@@ -29,6 +29,7 @@ extern void signal_shutdown();
 
 namespace rgw::dmclock {
   class Scheduler;
+  class TenantScheduler;
 }
 
 struct RGWProcessEnv {
@@ -185,7 +186,8 @@ extern int process_request(rgw::sal::RGWRadosStore* store,
                            OpsLogSocket* olog,
                            optional_yield y,
                            rgw::dmclock::Scheduler *scheduler,
-                           int* http_ret = nullptr);
+                           int* http_ret = nullptr,
+                           rgw::dmclock::TenantScheduler *tenant_scheduler = nullptr);
 
 extern int rgw_process_authenticated(RGWHandler_REST* handler,
                                      RGWOp*& op,
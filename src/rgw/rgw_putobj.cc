@@ -13,6 +13,13 @@
  *
  */
 
+#include <algorithm>
+
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
+
+#include "common/ceph_context.h"
 #include "rgw_putobj.h"
 
 namespace rgw::putobj {
@@ -96,4 +103,138 @@ int StripeProcessor::process(bufferlist&& data, uint64_t offset)
   return Pipe::process(std::move(data), offset - bounds.first);
 }
 
+class OffloadPool {
+  boost::asio::thread_pool threads;
+ public:
+  explicit OffloadPool(size_t num_threads) : threads(num_threads) {}
+  ~OffloadPool() { threads.join(); }
+
+  template <typename F>
+  void post(F&& f) {
+    boost::asio::post(threads, std::forward<F>(f));
+  }
+};
+
+static OffloadPool* get_offload_pool(CephContext* cct)
+{
+  const auto num_threads =
+      cct->_conf.get_val<uint64_t>("rgw_put_obj_offload_threads");
+  if (!num_threads) {
+    return nullptr;
+  }
+  struct Singleton {
+    std::unique_ptr<OffloadPool> pool;
+    explicit Singleton(size_t n) : pool(std::make_unique<OffloadPool>(n)) {}
+  };
+  auto& singleton = cct->lookup_or_create_singleton_object<Singleton>(
+      "rgw::putobj::OffloadPool", false, num_threads);
+  return singleton.pool.get();
+}
+
+struct OrderedOffload::Job {
+  uint64_t offset = 0;
+  bufferlist in;
+  bufferlist out;
+  int result = 0;
+  bool done = false;
+};
+
+OrderedOffload::OrderedOffload(CephContext* cct, Transform transform,
+                               Emit emit, optional_yield y)
+  : transform(std::move(transform)), emit(std::move(emit)),
+    pool(get_offload_pool(cct)),
+    window(std::max<uint64_t>(
+        2, cct->_conf.get_val<uint64_t>("rgw_put_obj_offload_threads"))),
+    y(y)
+{}
+
+OrderedOffload::~OrderedOffload()
+{
+  // jobs still running refer to this; wait for them after an error. this
+  // blocks, as the coroutine may be unwinding
+  std::unique_lock l{lock};
+  cond.wait(l, [this] {
+      return std::all_of(pending.begin(), pending.end(),
+                         [] (const auto& job) { return job->done; });
+    });
+}
+
+int OrderedOffload::submit(bufferlist&& in, uint64_t offset)
+{
+  if (!pool) {
+    bufferlist out;
+    int r = transform(in, offset, out);
+    return emit(r, std::move(out), offset);
+  }
+
+  auto job = std::make_shared<Job>();
+  job->offset = offset;
+  job->in = std::move(in);
+  {
+    std::lock_guard l{lock};
+    pending.push_back(job);
+  }
+  pool->post([this, job] {
+      bufferlist out;
+      int r = transform(job->in, job->offset, out);
+      std::lock_guard l{lock};
+      job->in.clear();
+      job->out = std::move(out);
+      job->result = r;
+      job->done = true;
+      if (waiter) {
+        Completion::post(std::move(waiter), boost::system::error_code{});
+      }
+      cond.notify_all();
+    });
+  return complete(window);
+}
+
+int OrderedOffload::drain()
+{
+  return complete(0);
+}
+
+int OrderedOffload::complete(size_t max_pending)
+{
+  std::unique_lock l{lock};
+  while (!pending.empty()) {
+    auto& front = pending.front();
+    if (!front->done) {
+      if (pending.size() <= max_pending) {
+        break;
+      }
+      wait(l, *front);
+    }
+    auto job = std::move(pending.front());
+    pending.pop_front();
+    l.unlock();
+    int r = emit(job->result, std::move(job->out), job->offset);
+    if (r < 0) {
+      return r;
+    }
+    l.lock();
+  }
+  return 0;
+}
+
+void OrderedOffload::wait(std::unique_lock<ceph::mutex>& l, const Job& job)
+{
+  if (!y) {
+    cond.wait(l, [&job] { return job.done; });
+    return;
+  }
+  // suspend the coroutine rather than block the frontend thread. any job
+  // that finishes resumes it
+  auto& yield = y.get_yield_context();
+  while (!job.done) {
+    boost::asio::async_completion<spawn::yield_context, Signature> init(yield);
+    waiter = Completion::create(y.get_io_context().get_executor(),
+                                std::move(init.completion_handler));
+    l.unlock();
+    init.result.get();
+    l.lock();
+  }
+}
+
 } // namespace rgw::putobj
@@ -15,7 +15,15 @@
 
 #pragma once
 
+#include <deque>
+#include <functional>
+#include <memory>
+
 #include "include/buffer.h"
+#include "include/common_fwd.h"
+#include "common/async/completion.h"
+#include "common/async/yield_context.h"
+#include "common/ceph_mutex.h"
 
 namespace rgw::putobj {
 
@@ -76,4 +84,59 @@ class StripeProcessor : public Pipe {
   int process(bufferlist&& data, uint64_t data_offset) override;
 };
 
+class OffloadPool;
+
+// runs a cpu-bound transform of each chunk (compression, encryption) on
+// a worker pool shared by all uploads, with up to a window of chunks in
+// flight, and hands the results back in submission order. the caller
+// can meanwhile read and hash the next chunk. with
+// rgw_put_obj_offload_threads=0 the transform runs inline
+class OrderedOffload {
+ public:
+  // runs on a worker thread, so it must not touch state that is shared
+  // with other chunks
+  using Transform = std::function<int(bufferlist& in, uint64_t offset,
+                                      bufferlist& out)>;
+  // runs on the caller's thread in offset order with the result of the
+  // transform
+  using Emit = std::function<int(int result, bufferlist&& out,
+                                 uint64_t offset)>;
+
+  // waits suspend the coroutine of y, and only block the thread without it
+  OrderedOffload(CephContext* cct, Transform transform, Emit emit,
+                 optional_yield y);
+  ~OrderedOffload();
+
+  // queue a chunk and emit any that are ready. waits for the oldest
+  // when the window is full
+  int submit(bufferlist&& in, uint64_t offset);
+
+  // wait for and emit everything that was submitted
+  int drain();
+
+ private:
+  struct Job;
+
+  Transform transform;
+  Emit emit;
+  OffloadPool* pool;
+  size_t window;
+  optional_yield y;
+
+  ceph::mutex lock = ceph::make_mutex("rgw::putobj::OrderedOffload");
+  ceph::condition_variable cond;
+  std::deque<std::shared_ptr<Job>> pending;
+
+  using Signature = void(boost::system::error_code);
+  using Completion = ceph::async::Completion<Signature>;
+  // resumes the coroutine waiting for a job, if any
+  std::unique_ptr<Completion> waiter;
+
+  // wait for the job to finish
+  void wait(std::unique_lock<ceph::mutex>& l, const Job& job);
+
+  // emit completed jobs in order until no more than max_pending remain
+  int complete(size_t max_pending);
+};
+
 } // namespace rgw::putobj
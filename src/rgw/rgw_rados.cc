@@ -63,7 +63,10 @@ using namespace librados;
 #include "include/random.h"
 
 #include "rgw_gc.h"
+#include "rgw_datacache.h"
 #include "rgw_lc.h"
+#include "rgw_obj_head_cache.h"
+#include "rgw_perf_counters.h"
 
 #include "rgw_object_expirer_core.h"
 #include "rgw_sync.h"
@@ -864,12 +867,52 @@ int RGWIndexCompletionThread::process()
   return 0;
 }
 
+struct complete_op_batch {
+  CephContext *cct{nullptr};
+  RGWSI_RADOS::Obj bucket_obj;
+  vector<complete_op_data *> entries;
+  set<string> names; /* see rgw_bucket_complete_ops() */
+  std::shared_ptr<std::atomic<bool>> supported;
+};
+
+/*
+ * Coalesces the completions headed to the same bucket index shard within
+ * rgw_bucket_index_batch_window_ms into a single bucket_complete_ops call.
+ * Completions are sent after the client got its response, so the window
+ * only delays when the entries show up in listings.
+ */
+class RGWIndexBatchThread : public RGWRadosThread {
+  const uint64_t window_msec;
+  const size_t max_ops;
+
+  ceph::mutex lock = ceph::make_mutex("RGWIndexBatchThread::lock");
+  map<rgw_raw_obj, complete_op_batch> batches;
+  /* cleared once an OSD turns out not to know bucket_complete_ops */
+  std::shared_ptr<std::atomic<bool>> supported =
+    std::make_shared<std::atomic<bool>>(true);
+
+  uint64_t interval_msec() override {
+    return window_msec;
+  }
+
+  void flush(complete_op_batch&& batch);
+public:
+  RGWIndexBatchThread(RGWRados *_store, uint64_t window_msec, size_t max_ops)
+    : RGWRadosThread(_store, "index-batch"),
+      window_msec(window_msec), max_ops(max_ops) {}
+
+  /* returns false if the completion should be sent on its own */
+  bool add(RGWSI_RADOS::Obj& bucket_obj, complete_op_data *c);
+  int process() override;
+};
+
 class RGWIndexCompletionManager {
   RGWRados *store{nullptr};
   ceph::containers::tiny_vector<ceph::mutex> locks;
   vector<set<complete_op_data *> > completions;
 
   RGWIndexCompletionThread *completion_thread{nullptr};
+  RGWIndexBatchThread *batch_thread{nullptr};
 
   int num_shards;
 
@@ -908,7 +951,13 @@ public:
                          uint16_t bilog_op,
                          rgw_zone_set *zones_trace,
                          complete_op_data **result);
-  bool handle_completion(completion_t cb, complete_op_data *arg);
+  bool handle_completion(int r, complete_op_data *arg);
+
+  /* queue the completion to be sent with others for the same shard;
+   * returns false if it should be sent right away */
+  bool batch_completion(RGWSI_RADOS::Obj& bucket_obj, complete_op_data *arg) {
+    return batch_thread && batch_thread->add(bucket_obj, arg);
+  }
 
   int start() {
     completion_thread = new RGWIndexCompletionThread(store);
@@ -917,9 +966,23 @@ public:
       return ret;
     }
     completion_thread->start();
+
+    auto& conf = store->ctx()->_conf;
+    const auto window = conf.get_val<uint64_t>("rgw_bucket_index_batch_window_ms");
+    if (window > 0) {
+      batch_thread = new RGWIndexBatchThread(
+        store, window, conf.get_val<uint64_t>("rgw_bucket_index_batch_max_ops"));
+      batch_thread->start();
+    }
     return 0;
   }
   void stop() {
+    if (batch_thread) {
+      batch_thread->stop();
+      batch_thread->process(); /* send what's left */
+      delete batch_thread;
+      batch_thread = nullptr;
+    }
     if (completion_thread) {
       completion_thread->stop();
       delete completion_thread;
@@ -935,22 +998,179 @@ public:
   }
 };
 
-static void obj_complete_cb(completion_t cb, void *arg)
+static void complete_entry(complete_op_data *completion, int r)
 {
-  complete_op_data *completion = (complete_op_data *)arg;
   completion->lock.lock();
   if (completion->stopped) {
     completion->lock.unlock(); /* can drop lock, no one else is referencing us */
     delete completion;
     return;
   }
-  bool need_delete = completion->manager->handle_completion(cb, completion);
+  bool need_delete = completion->manager->handle_completion(r, completion);
   completion->lock.unlock();
   if (need_delete) {
     delete completion;
   }
 }
 
+static void obj_complete_cb(completion_t cb, void *arg)
+{
+  complete_entry((complete_op_data *)arg, rados_aio_get_return_value(cb));
+}
+
+/* send a single completion, the way RGWRados::cls_obj_complete_op() does */
+static void issue_complete_op(RGWSI_RADOS::Obj& bucket_obj, complete_op_data *c)
+{
+  librados::ObjectWriteOperation o;
+  cls_rgw_guard_bucket_resharding(o, -ERR_BUSY_RESHARDING);
+  cls_rgw_bucket_complete_op(o, c->op, c->tag, c->ver, c->key, c->dir_meta, &c->remove_objs,
+                             c->log_op, c->bilog_op, &c->zones_trace);
+  librados::AioCompletion *completion = c->rados_completion;
+  bucket_obj.aio_operate(completion, &o);
+  completion->release(); /* can't reference c here, as it might have already been released */
+}
+
+static void batch_complete_cb(completion_t cb, void *arg)
+{
+  std::unique_ptr<complete_op_batch> batch{static_cast<complete_op_batch *>(arg)};
+  int r = rados_aio_get_return_value(cb);
+
+  if (r < 0 && r != -ERR_BUSY_RESHARDING) {
+    /* nothing was applied; send them one by one */
+    if (r == -EOPNOTSUPP) {
+      if (batch->supported->exchange(false)) {
+        ldout(batch->cct, 1) << "bucket index does not support batched "
+            "completions, sending them one at a time" << dendl;
+      }
+    } else {
+      ldout(batch->cct, 5) << "batched bucket index completion failed, r=" << r
+          << ", sending them one at a time" << dendl;
+    }
+    for (auto c : batch->entries) {
+      issue_complete_op(batch->bucket_obj, c);
+    }
+    return;
+  }
+
+  for (auto c : batch->entries) {
+    c->rados_completion->release();
+    complete_entry(c, r);
+  }
+}
+
+static bool can_batch(const complete_op_batch& batch, const complete_op_data *c)
+{
+  if (batch.names.count(c->key.name)) {
+    return false;
+  }
+  for (auto& k : c->remove_objs) {
+    if (batch.names.count(k.name)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void RGWIndexBatchThread::flush(complete_op_batch&& batch)
+{
+  if (batch.entries.size() == 1) {
+    issue_complete_op(batch.bucket_obj, batch.entries.front());
+    return;
+  }
+
+  vector<rgw_cls_obj_complete_op> ops;
+  ops.reserve(batch.entries.size());
+  for (auto c : batch.entries) {
+    rgw_cls_obj_complete_op op;
+    op.op = c->op;
+    op.tag = c->tag;
+    op.key = c->key;
+    op.ver = c->ver;
+    op.meta = c->dir_meta;
+    op.log_op = c->log_op;
+    op.bilog_flags = c->bilog_op;
+    op.remove_objs = c->remove_objs;
+    op.zones_trace = c->zones_trace;
+    ops.push_back(std::move(op));
+  }
+
+  librados::ObjectWriteOperation o;
+  cls_rgw_guard_bucket_resharding(o, -ERR_BUSY_RESHARDING);
+  cls_rgw_bucket_complete_ops(o, std::move(ops));
+
+  ldout(cct, 20) << __func__ << "(): sending " << batch.entries.size()
+      << " completions to " << batch.bucket_obj.get_raw_obj() << dendl;
+  if (perfcounter) {
+    perfcounter->inc(l_rgw_bucket_index_complete_batch);
+    perfcounter->inc(l_rgw_bucket_index_complete_batched, batch.entries.size());
+  }
+
+  auto b = new complete_op_batch(std::move(batch));
+  librados::AioCompletion *completion =
+    librados::Rados::aio_create_completion(b, batch_complete_cb);
+  int r = b->bucket_obj.aio_operate(completion, &o);
+  completion->release();
+  if (r < 0) {
+    ldout(cct, 0) << "ERROR: " << __func__ << "(): failed to send batched "
+        "bucket index completion, r=" << r << dendl;
+    for (auto c : b->entries) {
+      issue_complete_op(b->bucket_obj, c);
+    }
+    delete b;
+  }
+}
+
+bool RGWIndexBatchThread::add(RGWSI_RADOS::Obj& bucket_obj, complete_op_data *c)
+{
+  if (!*supported) {
+    return false;
+  }
+
+  /* batches are sent under the lock so that completions for the same
+   * shard leave in the order they came in */
+  std::lock_guard l{lock};
+  /* checked under the lock, so that nothing is added after the final
+   * process() that stop() is followed by */
+  if (going_down()) {
+    return false;
+  }
+  auto iter = batches.find(bucket_obj.get_raw_obj());
+  if (iter != batches.end() && !can_batch(iter->second, c)) {
+    flush(std::move(iter->second));
+    batches.erase(iter);
+    iter = batches.end();
+  }
+  if (iter == batches.end()) {
+    iter = batches.emplace(bucket_obj.get_raw_obj(), complete_op_batch{}).first;
+    auto& batch = iter->second;
+    batch.cct = cct;
+    batch.bucket_obj = bucket_obj;
+    batch.supported = supported;
+  }
+
+  auto& batch = iter->second;
+  batch.entries.push_back(c);
+  batch.names.insert(c->key.name);
+  for (auto& k : c->remove_objs) {
+    batch.names.insert(k.name);
+  }
+  if (batch.entries.size() >= max_ops) {
+    flush(std::move(batch));
+    batches.erase(iter);
+  }
+  return true;
+}
+
+int RGWIndexBatchThread::process()
+{
+  std::lock_guard l{lock};
+  for (auto& [obj, batch] : batches) {
+    flush(std::move(batch));
+  }
+  batches.clear();
+  return 0;
+}
+
 
 void RGWIndexCompletionManager::create_completion(const rgw_obj& obj,
                                                   RGWModifyOp op, string& tag,
@@ -997,7 +1217,7 @@ void RGWIndexCompletionManager::create_completion(const rgw_obj& obj,
   completions[shard_id].insert(entry);
 }
 
-bool RGWIndexCompletionManager::handle_completion(completion_t cb, complete_op_data *arg)
+bool RGWIndexCompletionManager::handle_completion(int r, complete_op_data *arg)
 {
   int shard_id = arg->manager_shard_id;
   {
@@ -1013,7 +1233,6 @@ bool RGWIndexCompletionManager::handle_completion(completion_t cb, complete_op_d
     comps.erase(iter);
   }
 
-  int r = rados_aio_get_return_value(cb);
   if (r != -ERR_BUSY_RESHARDING) {
     return true;
   }
@@ -1077,6 +1296,8 @@ void RGWRados::finalize()
 
   delete binfo_cache;
   delete obj_tombstone_cache;
+  delete obj_head_cache;
+  delete datacache;
 
   if (reshard_wait.get()) {
     reshard_wait->stop();
@@ -1308,6 +1529,22 @@ int RGWRados::init_complete()
     obj_tombstone_cache = new tombstone_cache_t(cct->_conf->rgw_obj_tombstone_cache_size);
   }
 
+  if (use_cache &&
+      cct->_conf.get_val<uint64_t>("rgw_obj_head_cache_size") > 0) {
+    obj_head_cache = new RGWObjHeadCache(cct, svc.notify);
+  }
+
+  if (cct->_conf.get_val<bool>("rgw_datacache_enabled")) {
+    datacache = new RGWDataCache(cct);
+    ret = datacache->start();
+    if (ret < 0) {
+      ldout(cct, 0) << "ERROR: failed to start data cache, continuing "
+        "without it: " << cpp_strerror(-ret) << dendl;
+      delete datacache;
+      datacache = nullptr;
+    }
+  }
+
   reshard_wait = std::make_shared<RGWReshardWait>();
 
   reshard = new RGWReshard(this->store);
@@ -3379,7 +3616,7 @@ public:
 
     if (plugin && src_attrs.find(RGW_ATTR_CRYPT_MODE) == src_attrs.end()) {
       //do not compress if object is encrypted
-      compressor = boost::in_place(cct, plugin, filter);
+      compressor = boost::in_place(cct, plugin, filter, null_yield);
       // add a filter that buffers data so we don't try to compress tiny blocks.
       // libcurl reads in 16k at a time, and we need at least 64k to get a good
       // compression ratio
@@ -5323,7 +5560,36 @@ int RGWRados::get_obj_state_impl(RGWObjectCtx *rctx, const RGWBucketInfo& bucket
 
   int r = -ENOENT;
 
-  if (!assume_noent) {
+  if (!assume_noent && obj_head_cache) {
+    const string key = RGWObjHeadCache::get_key(raw_obj);
+    RGWObjHeadCacheEntry head;
+    if (obj_head_cache->find(key, head)) {
+      s->size = head.size;
+      s->mtime = head.mtime;
+      s->epoch = head.epoch;
+      s->attrset = std::move(head.attrs);
+      if (s->prefetch_data && head.has_data) {
+        s->data = std::move(head.data);
+      }
+      /* without the data, reads fetch it from the head object */
+      r = 0;
+    } else {
+      const uint64_t gen = obj_head_cache->get_gen(key);
+      r = RGWRados::raw_obj_stat(raw_obj, &s->size, &s->mtime, &s->epoch, &s->attrset, (s->prefetch_data ? &s->data : NULL), NULL, y);
+      if (r == 0 && !is_olh(s->attrset)) {
+        head.size = s->size;
+        head.mtime = s->mtime;
+        head.epoch = s->epoch;
+        head.attrs = s->attrset;
+        if (s->prefetch_data &&
+            s->data.length() <= obj_head_cache->get_max_data()) {
+          head.has_data = true;
+          head.data = s->data;
+        }
+        obj_head_cache->put(key, gen, head);
+      }
+    }
+  } else if (!assume_noent) {
     r = RGWRados::raw_obj_stat(raw_obj, &s->size, &s->mtime, &s->epoch, &s->attrset, (s->prefetch_data ? &s->data : NULL), NULL, y);
   }
 
@@ -5487,6 +5753,17 @@ int RGWRados::get_obj_state(RGWObjectCtx *rctx, const RGWBucketInfo& bucket_info
   return ret;
 }
 
+void RGWRados::invalidate_obj_head(const RGWBucketInfo& bucket_info,
+                                   const rgw_obj& obj, optional_yield y)
+{
+  if (!obj_head_cache) {
+    return;
+  }
+  rgw_raw_obj raw_obj;
+  obj_to_raw(bucket_info.placement_rule, obj, &raw_obj);
+  obj_head_cache->invalidate(raw_obj, y);
+}
+
 int RGWRados::Object::get_manifest(RGWObjManifest **pmanifest, optional_yield y)
 {
   RGWObjState *astate;
@@ -6083,10 +6360,12 @@ int RGWRados::Bucket::UpdateIndex::complete(int64_t poolid, uint64_t epoch,
                                             list<rgw_obj_index_key> *remove_objs, const string *user_data,
                                             bool appendable)
 {
+  RGWRados *store = target->get_store();
+  store->invalidate_obj_head(target->bucket_info, obj, null_yield);
+
   if (blind) {
     return 0;
   }
-  RGWRados *store = target->get_store();
   BucketShard *bs;
 
   int ret = get_bucket_shard(&bs);
@@ -6131,10 +6410,12 @@ int RGWRados::Bucket::UpdateIndex::complete_del(int64_t poolid, uint64_t epoch,
                                                 real_time& removed_mtime,
                                                 list<rgw_obj_index_key> *remove_objs)
 {
+  RGWRados *store = target->get_store();
+  store->invalidate_obj_head(target->bucket_info, obj, null_yield);
+
   if (blind) {
     return 0;
   }
-  RGWRados *store = target->get_store();
   BucketShard *bs;
 
   int ret = get_bucket_shard(&bs);
@@ -6156,10 +6437,12 @@ int RGWRados::Bucket::UpdateIndex::complete_del(int64_t poolid, uint64_t epoch,
 
 int RGWRados::Bucket::UpdateIndex::cancel()
 {
+  RGWRados *store = target->get_store();
+  store->invalidate_obj_head(target->bucket_info, obj, null_yield);
+
   if (blind) {
     return 0;
   }
-  RGWRados *store = target->get_store();
   BucketShard *bs;
 
   int ret = guard_reshard(&bs, [&](BucketShard *bs) -> int {
@@ -6300,13 +6583,18 @@ struct get_obj_data {
   RGWRados* store;
   RGWGetDataCB* client_cb;
   rgw::Aio* aio;
+  rgw::ReadWindow* window;
   uint64_t offset; // next offset to write to client
+  uint64_t issued; // end offset of the reads issued so far
   rgw::AioResultList completed; // completed read results, sorted by offset
   optional_yield yield;
+  // rados reads to keep in the data cache, by offset: (key, length)
+  std::map<uint64_t, std::pair<std::string, uint64_t>> cache_fills;
 
   get_obj_data(RGWRados* store, RGWGetDataCB* cb, rgw::Aio* aio,
-               uint64_t offset, optional_yield yield)
-    : store(store), client_cb(cb), aio(aio), offset(offset), yield(yield) {}
+               rgw::ReadWindow* window, uint64_t offset, optional_yield yield)
+    : store(store), client_cb(cb), aio(aio), window(window),
+      offset(offset), issued(offset), yield(yield) {}
 
   int flush(rgw::AioResultList&& results) {
     int r = rgw::check_for_errors(results);
@@ -6322,11 +6610,38 @@ struct get_obj_data {
       auto bl = std::move(completed.front().data);
       completed.pop_front_and_dispose(std::default_delete<rgw::AioResultEntry>{});
 
+      if (auto fill = cache_fills.find(offset); fill != cache_fills.end()) {
+        if (bl.length() == fill->second.second) {
+          store->get_datacache()->put(fill->second.first, bl);
+        }
+        cache_fills.erase(fill);
+      }
+
       offset += bl.length();
+      const auto start = ceph::mono_clock::now();
       int r = client_cb->handle_data(bl, 0, bl.length());
       if (r < 0) {
         return r;
       }
+      window->add_sent(bl.length(), ceph::mono_clock::now() - start);
+    }
+    return 0;
+  }
+
+  // wait for the client to catch up until a read of the given size fits
+  // in the window
+  int throttle(uint64_t cost) {
+    while (issued > offset && issued - offset + cost > window->get()) {
+      const auto start = ceph::mono_clock::now();
+      auto c = aio->wait();
+      window->add_wait(ceph::mono_clock::now() - start);
+      if (c.empty()) {
+        break;
+      }
+      int r = flush(std::move(c));
+      if (r < 0) {
+        return r;
+      }
     }
     return 0;
   }
@@ -6350,6 +6665,12 @@ struct get_obj_data {
   }
 };
 
+static rgw::WindowBudget& get_obj_window_budget()
+{
+  static rgw::WindowBudget budget;
+  return budget;
+}
+
 static int _get_obj_iterate_cb(const rgw_raw_obj& read_obj, off_t obj_ofs,
                                off_t read_ofs, off_t len, bool is_head_obj,
                                RGWObjState *astate, void *arg)
@@ -6404,7 +6725,23 @@ int RGWRados::get_obj_iterate_cb(const rgw_raw_obj& read_obj, off_t obj_ofs,
   const uint64_t cost = len;
   const uint64_t id = obj_ofs; // use logical object offset for sorting replies
 
-  auto completed = d->aio->get(obj, rgw::Aio::librados_op(std::move(op), d->yield), cost, id);
+  r = d->throttle(cost);
+  if (r < 0) {
+    return r;
+  }
+  d->issued = obj_ofs + len;
+
+  auto read = rgw::Aio::librados_op(std::move(op), d->yield);
+  if (!is_head_obj && datacache) {
+    /* the head is read with the atomic test, so only tail object
+     * chunks go through the data cache */
+    auto key = RGWDataCache::get_key(read_obj, read_ofs, len);
+    if (!datacache->get(key, read, d->yield)) {
+      d->cache_fills.emplace(id, std::make_pair(std::move(key), len));
+    }
+  }
+
+  auto completed = d->aio->get(obj, std::move(read), cost, id);
 
   return d->flush(std::move(completed));
 }
@@ -6418,8 +6755,14 @@ int RGWRados::Object::Read::iterate(int64_t ofs, int64_t end, RGWGetDataCB *cb,
   const uint64_t chunk_size = cct->_conf->rgw_get_obj_max_req_size;
   const uint64_t window_size = cct->_conf->rgw_get_obj_window_size;
 
+  /* the throttle enforces the largest window, and the adaptive window
+   * keeps each read within its current size */
   auto aio = rgw::make_throttle(window_size, y);
-  get_obj_data data(store, cb, &*aio, ofs, y);
+  rgw::ReadWindow window(get_obj_window_budget(),
+      cct->_conf.get_val<Option::size_t>("rgw_get_obj_min_window_size"),
+      window_size,
+      cct->_conf.get_val<Option::size_t>("rgw_get_obj_window_total"));
+  get_obj_data data(store, cb, &*aio, &window, ofs, y);
 
   int r = store->iterate_obj(obj_ctx, source->get_bucket_info(), state.obj,
                              ofs, end, chunk_size, _get_obj_iterate_cb, &data, y);
@@ -6429,7 +6772,18 @@ int RGWRados::Object::Read::iterate(int64_t ofs, int64_t end, RGWGetDataCB *cb,
     return r;
   }
 
-  return data.drain();
+  r = data.drain();
+
+  ldout(cct, 10) << "get_obj window: final=" << window.get()
+      << " peak=" << window.peak << " grows=" << window.grows
+      << " shrinks=" << window.shrinks << " capped=" << window.capped << dendl;
+  if (perfcounter) {
+    perfcounter->inc(l_rgw_get_obj_window, window.peak);
+    perfcounter->inc(l_rgw_get_obj_window_grow, window.grows);
+    perfcounter->inc(l_rgw_get_obj_window_shrink, window.shrinks);
+    perfcounter->inc(l_rgw_get_obj_window_capped, window.capped);
+  }
+  return r;
 }
 
 int RGWRados::iterate_obj(RGWObjectCtx& obj_ctx,
@@ -6801,7 +7155,7 @@ int RGWRados::bucket_index_link_olh(const RGWBucketInfo& bucket_info, RGWObjStat
 		      cls_rgw_obj_key key(obj_instance.key.get_index_key_name(), obj_instance.key.instance);
 		      auto& ref = bs->bucket_obj.get_ref();
 		      librados::ObjectWriteOperation op;
-		      cls_rgw_guard_bucket_resharding(op, -ERR_BUSY_RESHARDING);
+		      cls_rgw_guard_bucket_resharding(op, -ERR_BUSY_RESHARDING, key.name);
 		      cls_rgw_bucket_link_olh(op, key, olh_state.olh_tag,
                                               delete_marker, op_tag, meta, olh_epoch,
 					      unmod_since, high_precision_time,
@@ -6849,7 +7203,7 @@ int RGWRados::bucket_index_unlink_instance(const RGWBucketInfo& bucket_info, con
 		    [&](BucketShard *bs) -> int {
 		      auto& ref = bs->bucket_obj.get_ref();
 		      librados::ObjectWriteOperation op;
-		      cls_rgw_guard_bucket_resharding(op, -ERR_BUSY_RESHARDING);
+		      cls_rgw_guard_bucket_resharding(op, -ERR_BUSY_RESHARDING, key.name);
 		      cls_rgw_bucket_unlink_instance(op, key, op_tag,
 						     olh_tag, olh_epoch, svc.zone->get_zone().log_data, zones_trace);
                       return rgw_rados_operate(ref.pool.ioctx(), ref.obj.oid, &op, null_yield);
@@ -6993,7 +7347,7 @@ int RGWRados::bucket_index_trim_olh_log(const RGWBucketInfo& bucket_info, RGWObj
   ret = guard_reshard(&bs, obj_instance, bucket_info,
 		      [&](BucketShard *pbs) -> int {
 			ObjectWriteOperation op;
-			cls_rgw_guard_bucket_resharding(op, -ERR_BUSY_RESHARDING);
+			cls_rgw_guard_bucket_resharding(op, -ERR_BUSY_RESHARDING, key.name);
 			cls_rgw_trim_olh_log(op, key, ver, olh_tag);
                         return pbs->bucket_obj.operate(&op, null_yield);
                       });
@@ -7023,7 +7377,7 @@ int RGWRados::bucket_index_clear_olh(const RGWBucketInfo& bucket_info, RGWObjSta
 			  [&](BucketShard *pbs) -> int {
 			    ObjectWriteOperation op;
 			    auto& ref = pbs->bucket_obj.get_ref();
-			    cls_rgw_guard_bucket_resharding(op, -ERR_BUSY_RESHARDING);
+			    cls_rgw_guard_bucket_resharding(op, -ERR_BUSY_RESHARDING, key.name);
 			    cls_rgw_clear_olh(op, key, olh_tag);
                             return rgw_rados_operate(ref.pool.ioctx(), ref.obj.oid, &op, null_yield);
                           });
@@ -7179,6 +7533,8 @@ int RGWRados::apply_olh_log(RGWObjectCtx& obj_ctx, RGWObjState& state, const RGW
     return r;
   }
 
+  invalidate_obj_head(bucket_info, obj, null_yield);
+
   r = bucket_index_trim_olh_log(bucket_info, state, obj, last_ver);
   if (r < 0) {
     ldout(cct, 0) << "ERROR: could not trim olh log, r=" << r << dendl;
@@ -8118,6 +8474,22 @@ int RGWRados::bi_list(const RGWBucketInfo& bucket_info, int shard_id, const stri
   return bi_list(bs, filter_obj, marker, max, entries, is_truncated);
 }
 
+int RGWRados::reshard_log_list(const RGWBucketInfo& bucket_info, int shard_id,
+                               const string& marker, uint32_t max,
+                               vector<string> *names, bool *is_truncated)
+{
+  BucketShard bs(this);
+  int ret = bs.init(bucket_info.bucket, shard_id, bucket_info.layout.current_index, nullptr /* no RGWBucketInfo */);
+  if (ret < 0) {
+    ldout(cct, 5) << "bs.init() returned ret=" << ret << dendl;
+    return ret;
+  }
+
+  auto& ref = bs.bucket_obj.get_ref();
+  return cls_rgw_reshard_log_list(ref.pool.ioctx(), ref.obj.oid, marker, max,
+                                  names, is_truncated);
+}
+
 int RGWRados::gc_operate(string& oid, librados::ObjectWriteOperation *op)
 {
   return rgw_rados_operate(gc_pool_ctx, oid, op, null_yield);
@@ -8144,6 +8516,12 @@ int RGWRados::process_gc(bool expired_only)
   return gc->process(expired_only);
 }
 
+int RGWRados::gc_throughput(uint64_t max_backlog,
+                            std::vector<RGWGCThroughput>& result)
+{
+  return gc->throughput(max_backlog, result);
+}
+
 int RGWRados::list_lc_progress(string& marker, uint32_t max_entries,
 			       vector<rgw::sal::Lifecycle::LCEntry>& progress_map,
 			       int& index)
@@ -8177,7 +8555,7 @@ int RGWRados::cls_obj_prepare_op(BucketShard& bs, RGWModifyOp op, string& tag,
 
   ObjectWriteOperation o;
   cls_rgw_obj_key key(obj.key.get_index_key_name(), obj.key.instance);
-  cls_rgw_guard_bucket_resharding(o, -ERR_BUSY_RESHARDING);
+  cls_rgw_guard_bucket_resharding(o, -ERR_BUSY_RESHARDING, key.name);
   cls_rgw_bucket_prepare_op(o, op, tag, key, obj.key.get_loc(), svc.zone->get_zone().log_data, bilog_flags, zones_trace);
   return bs.bucket_obj.operate(&o, y);
 }
@@ -8202,12 +8580,15 @@ int RGWRados::cls_obj_complete_op(BucketShard& bs, const rgw_obj& obj, RGWModify
   ver.pool = pool;
   ver.epoch = epoch;
   cls_rgw_obj_key key(ent.key.name, ent.key.instance);
-  cls_rgw_guard_bucket_resharding(o, -ERR_BUSY_RESHARDING);
-  cls_rgw_bucket_complete_op(o, op, tag, ver, key, dir_meta, remove_objs,
-                             svc.zone->get_zone().log_data, bilog_flags, &zones_trace);
   complete_op_data *arg;
   index_completion_manager->create_completion(obj, op, tag, ver, key, dir_meta, remove_objs,
                                               svc.zone->get_zone().log_data, bilog_flags, &zones_trace, &arg);
+  if (index_completion_manager->batch_completion(bs.bucket_obj, arg)) {
+    return 0;
+  }
+  cls_rgw_guard_bucket_resharding(o, -ERR_BUSY_RESHARDING);
+  cls_rgw_bucket_complete_op(o, op, tag, ver, key, dir_meta, remove_objs,
+                             svc.zone->get_zone().log_data, bilog_flags, &zones_trace);
   librados::AioCompletion *completion = arg->rados_completion;
   int ret = bs.bucket_obj.aio_operate(arg->rados_completion, &o);
   completion->release(); /* can't reference arg here, as it might have already been released */
@@ -8371,6 +8752,11 @@ int RGWRados::cls_bucket_list_ordered(RGWBucketInfo& bucket_info,
     RGWRados::ent_map_t::iterator cursor;
     RGWRados::ent_map_t::iterator end;
 
+    // key of the last entry this shard returned; entries are moved
+    // out of the result as they are consumed, so keep our own copy
+    // for the start_after of a refill
+    cls_rgw_obj_key last_key;
+
     // manages an iterator through a shard and provides other
     // accessors
     ShardTracker(size_t _shard_idx,
@@ -8378,10 +8764,21 @@ int RGWRados::cls_bucket_list_ordered(RGWBucketInfo& bucket_info,
 		 const std::string& _oid_name):
       shard_idx(_shard_idx),
       result(_result),
-      oid_name(_oid_name),
-      cursor(_result.dir.m.begin()),
-      end(_result.dir.m.end())
-    {}
+      oid_name(_oid_name)
+    {
+      reset();
+    }
+
+    // re-seat the cursor after the result has been replaced by a
+    // refill of this shard
+    void reset() {
+      cursor = result.dir.m.begin();
+      end = result.dir.m.end();
+      if (!result.dir.m.empty()) {
+	const auto& key = result.dir.m.rbegin()->second.key;
+	last_key = cls_rgw_obj_key(key.name, key.instance);
+      }
+    }
 
     inline const std::string& entry_name() const {
       return cursor->first;
@@ -8415,11 +8812,41 @@ int RGWRados::cls_bucket_list_ordered(RGWBucketInfo& bucket_info,
     }
   };
 
+  // re-read a single shard whose entries have all been consumed but
+  // which has more beyond them; only that shard can hold the next
+  // entry in lexical order, so the others are left alone
+  uint64_t shard_entries_read = 0;
+  auto refill = [&](ShardTracker& t, uint32_t want) -> int {
+    std::map<int, string> oids = {{int(t.shard_idx), t.oid_name}};
+    std::map<int, rgw_cls_list_ret> results;
+    int ret = CLSRGWIssueBucketList(ioctx, t.last_key, prefix, delimiter,
+				    want, list_versions, oids, results,
+				    cct->_conf->rgw_bucket_index_max_aio)();
+    if (ret < 0) {
+      return ret;
+    }
+    auto& result = results[t.shard_idx];
+    shard_entries_read += result.dir.m.size();
+    t.result.dir.m = std::move(result.dir.m);
+    t.result.is_truncated = result.is_truncated;
+    t.result.cls_filtered = result.cls_filtered;
+    t.reset();
+    if (perfcounter) {
+      perfcounter->inc(l_rgw_bucket_list_shard_refill);
+    }
+    ldout(cct, 20) << "RGWRados::cls_bucket_list_ordered: refilled shard " <<
+      t.shard_idx << " after " << t.last_key << " with " <<
+      t.result.dir.m.size() << " entries, is_truncated=" <<
+      t.result.is_truncated << dendl;
+    return 0;
+  };
+
   // one tracker per shard requested (may not be all shards)
   std::vector<ShardTracker> results_trackers;
   results_trackers.reserve(shard_list_results.size());
   for (auto& r : shard_list_results) {
     results_trackers.emplace_back(r.first, r.second, shard_oids[r.first]);
+    shard_entries_read += r.second.dir.m.size();
 
     // if any *one* shard's result is trucated, the entire result is
     // truncated
@@ -8444,8 +8871,8 @@ int RGWRados::cls_bucket_list_ordered(RGWBucketInfo& bucket_info,
     ++tracker_idx;
   }
 
-  rgw_bucket_dir_entry*
-    last_entry_visited = nullptr; // to set last_entry (marker)
+  std::optional<rgw_obj_index_key>
+    last_entry_visited; // to set last_entry (marker)
   map<string, bufferlist> updates;
   uint32_t count = 0;
   while (count < num_entries && !candidates.empty()) {
@@ -8487,13 +8914,13 @@ int RGWRados::cls_bucket_list_ordered(RGWBucketInfo& bucket_info,
     if (r >= 0) {
       ldout(cct, 10) << "RGWRados::" << __func__ << ": got " <<
 	dirent.key.name << "[" << dirent.key.instance << "]" << dendl;
+      last_entry_visited = dirent.key;
       m[name] = std::move(dirent);
-      last_entry_visited = &(m[name]);
       ++count;
     } else {
       ldout(cct, 10) << "RGWRados::" << __func__ << ": skipping " <<
 	dirent.key.name << "[" << dirent.key.instance << "]" << dendl;
-      last_entry_visited = &tracker.dir_entry();
+      last_entry_visited = dirent.key;
     }
 
     // refresh the candidates map
@@ -8502,15 +8929,32 @@ int RGWRados::cls_bucket_list_ordered(RGWBucketInfo& bucket_info,
 
     next_candidate(cct, tracker, candidates, tracker_idx);
 
-    if (tracker.at_end() && tracker.is_truncated()) {
-      // once we exhaust one shard that is truncated, we need to stop,
-      // as we cannot be certain that one of the next entries needs to
-      // come from that shard; S3 and swift protocols allow returning
-      // fewer than what was requested
-      break;
+    if (tracker.at_end() && tracker.is_truncated() && count < num_entries) {
+      // we cannot be certain that the next entry does not come from
+      // this shard, so pull another batch from it alone, sized for
+      // what is still missing from the page
+      r = refill(tracker,
+		 calc_ordered_bucket_list_per_shard(num_entries - count,
+						    shard_count));
+      if (r < 0) {
+	return r;
+      }
+      next_candidate(cct, tracker, candidates, tracker_idx);
+
+      if (tracker.at_end() && tracker.is_truncated()) {
+	// the shard made no progress (e.g., everything was filtered
+	// out by the osd), so stop here; S3 and swift protocols allow
+	// returning fewer than what was requested
+	break;
+      }
     }
   } // while we haven't provided requested # of result entries
 
+  if (perfcounter) {
+    perfcounter->inc(l_rgw_bucket_list_shard_entries, shard_entries_read);
+    perfcounter->inc(l_rgw_bucket_list_entries, count);
+  }
+
   // suggest updates if there are any
   for (auto& miter : updates) {
     if (miter.second.length()) {
@@ -8544,8 +8988,8 @@ int RGWRados::cls_bucket_list_ordered(RGWBucketInfo& bucket_info,
       count << ", which is truncated" << dendl;
   }
 
-  if (last_entry_visited != nullptr && last_entry) {
-    *last_entry = last_entry_visited->key;
+  if (last_entry_visited && last_entry) {
+    *last_entry = *last_entry_visited;
     ldout(cct, 20) << "RGWRados::" << __func__ <<
       ": returning, last_entry=" << *last_entry << dendl;
   } else {
@@ -35,6 +35,7 @@ class RGWWatcher;
 class SafeTimer;
 class ACLOwner;
 class RGWGC;
+struct RGWGCThroughput;
 class RGWMetaNotifier;
 class RGWDataNotifier;
 class RGWLC;
@@ -393,6 +394,9 @@ template <class K, class V>
 class lru_map;
 using tombstone_cache_t = lru_map<rgw_obj, tombstone_entry>;
 
+class RGWObjHeadCache;
+class RGWDataCache;
+
 class RGWIndexCompletionManager;
 
 class RGWRados
@@ -487,6 +491,8 @@ protected:
   RGWChainedCacheImpl_bucket_info_entry *binfo_cache;
 
   tombstone_cache_t *obj_tombstone_cache;
+  RGWObjHeadCache *obj_head_cache{nullptr};
+  RGWDataCache *datacache{nullptr};
 
   librados::IoCtx gc_pool_ctx;        // .rgw.gc
   librados::IoCtx lc_pool_ctx;        // .rgw.lc
@@ -594,6 +600,15 @@ public:
   tombstone_cache_t *get_tombstone_cache() {
     return obj_tombstone_cache;
   }
+
+  RGWDataCache *get_datacache() {
+    return datacache;
+  }
+
+  /* drop a modified user object head from the object head cache of
+   * every gateway; no-op unless rgw_obj_head_cache_size is set */
+  void invalidate_obj_head(const RGWBucketInfo& bucket_info,
+			   const rgw_obj& obj, optional_yield y);
   const RGWSyncModuleInstanceRef& get_sync_module() {
     return sync_module;
   }
@@ -1421,6 +1436,9 @@ public:
   int bi_list(rgw_bucket& bucket, const string& obj_name, const string& marker, uint32_t max,
               list<rgw_cls_bi_entry> *entries, bool *is_truncated);
   int bi_remove(BucketShard& bs);
+  int reshard_log_list(const RGWBucketInfo& bucket_info, int shard_id,
+                       const string& marker, uint32_t max,
+                       vector<string> *names, bool *is_truncated);
 
   int cls_obj_usage_log_add(const string& oid, rgw_usage_log_info& info);
   int cls_obj_usage_log_read(const string& oid, const string& user, const string& bucket, uint64_t start_epoch,
@@ -1445,6 +1463,7 @@ public:
 
   int list_gc_objs(int *index, string& marker, uint32_t max, bool expired_only, std::list<cls_rgw_gc_obj_info>& result, bool *truncated, bool& processing_queue);
   int process_gc(bool expired_only);
+  int gc_throughput(uint64_t max_backlog, std::vector<RGWGCThroughput>& result);
   bool process_expire_objects();
   int defer_gc(void *ctx, const RGWBucketInfo& bucket_info, const rgw_obj& obj, optional_yield y);
 
@@ -88,6 +88,7 @@ void RGWRealmReloader::reload()
 
   // TODO: make RGWRados responsible for rgw_log_usage lifetime
   rgw_log_usage_finalize();
+  rgw_log_ops_finalize();
 
   // destroy the existing store
   RGWStoreManager::close_storage(store);
@@ -164,6 +165,7 @@ void RGWRealmReloader::reload()
   rgw_rest_init(cct, store->svc()->zone->get_zonegroup());
   ldout(cct, 1) << " - usage subsystem init" << dendl;
   rgw_log_usage_init(cct, store->getRados());
+  rgw_log_ops_init(cct, store->getRados());
 
   ldout(cct, 1) << "Resuming frontends with new realm configuration." << dendl;
 
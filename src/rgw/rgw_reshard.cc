@@ -3,6 +3,7 @@
 
 #include <limits>
 #include <sstream>
+#include <thread>
 
 #include "rgw_zone.h"
 #include "rgw_bucket.h"
@@ -65,6 +66,9 @@ class BucketReshardShard {
   const rgw::bucket_index_layout_generation& idx_layout;
   RGWRados::BucketShard bs;
   vector<rgw_cls_bi_entry> entries;
+  // keys of target entries that no longer exist in the source
+  set<string> stale_keys;
+  // totals of everything added, written out by write_stats()
   map<RGWObjCategory, rgw_bucket_category_stats> stats;
   deque<librados::AioCompletion *>& aio_completions;
   uint64_t max_aio_completions;
@@ -132,7 +136,7 @@ public:
       target.total_size_rounded += entry_stats.total_size_rounded;
       target.actual_size += entry_stats.actual_size;
     }
-    if (entries.size() >= reshard_shard_batch_size) {
+    if (entries.size() + stale_keys.size() >= reshard_shard_batch_size) {
       int ret = flush();
       if (ret < 0) {
         return ret;
@@ -142,16 +146,71 @@ public:
     return 0;
   }
 
+  /* make the entries of name in this shard match those of the source
+   * shard, which were copied once already but may have changed since */
+  int replace_entries(const string& name, list<rgw_cls_bi_entry>& source) {
+    set<string> source_keys;
+    for (auto& entry : source) {
+      source_keys.insert(entry.idx);
+    }
+
+    string marker;
+    bool is_truncated = true;
+    while (is_truncated) {
+      list<rgw_cls_bi_entry> existing;
+      int ret = store->getRados()->bi_list(bs, name, marker,
+					   reshard_shard_batch_size,
+					   &existing, &is_truncated);
+      if (ret == -ENOENT) {
+	break;
+      } else if (ret < 0) {
+	derr << "ERROR: bi_list(): " << cpp_strerror(-ret) << dendl;
+	return ret;
+      }
+      for (auto& entry : existing) {
+	marker = entry.idx;
+	cls_rgw_obj_key cls_key;
+	RGWObjCategory category;
+	rgw_bucket_category_stats entry_stats;
+	if (entry.get_info(&cls_key, &category, &entry_stats)) {
+	  rgw_bucket_category_stats& target = stats[category];
+	  target.num_entries -= entry_stats.num_entries;
+	  target.total_size -= entry_stats.total_size;
+	  target.total_size_rounded -= entry_stats.total_size_rounded;
+	  target.actual_size -= entry_stats.actual_size;
+	}
+	if (!source_keys.count(entry.idx)) {
+	  stale_keys.insert(entry.idx);
+	}
+      }
+    }
+
+    for (auto& entry : source) {
+      cls_rgw_obj_key cls_key;
+      RGWObjCategory category;
+      rgw_bucket_category_stats entry_stats;
+      bool account = entry.get_info(&cls_key, &category, &entry_stats);
+      int ret = add_entry(entry, account, category, entry_stats);
+      if (ret < 0) {
+	return ret;
+      }
+    }
+
+    return 0;
+  }
+
   int flush() {
-    if (entries.size() == 0) {
+    if (entries.empty() && stale_keys.empty()) {
       return 0;
     }
 
     librados::ObjectWriteOperation op;
+    if (!stale_keys.empty()) {
+      op.omap_rm_keys(stale_keys);
+    }
     for (auto& entry : entries) {
       store->getRados()->bi_put(op, bs, entry);
     }
-    cls_rgw_bucket_update_stats(op, false, stats);
 
     librados::AioCompletion *c;
     int ret = get_completion(&c);
@@ -164,7 +223,24 @@ public:
       return ret;
     }
     entries.clear();
-    stats.clear();
+    stale_keys.clear();
+    return 0;
+  }
+
+  int write_stats() {
+    librados::ObjectWriteOperation op;
+    cls_rgw_bucket_update_stats(op, true, stats);
+
+    librados::AioCompletion *c;
+    int ret = get_completion(&c);
+    if (ret < 0) {
+      return ret;
+    }
+    ret = bs.bucket_obj.aio_operate(c, &op);
+    if (ret < 0) {
+      derr << "ERROR: failed to store stats in target bucket shard (bs=" << bs.bucket << "/" << bs.shard_id << ") error=" << cpp_strerror(-ret) << dendl;
+      return ret;
+    }
     return 0;
   }
 
@@ -226,6 +302,38 @@ public:
     return 0;
   }
 
+  int replace_entries(int shard_index, const string& name,
+                      list<rgw_cls_bi_entry>& source) {
+    int ret = target_shards[shard_index]->replace_entries(name, source);
+    if (ret < 0) {
+      derr << "ERROR: target_shards.replace_entries(" << name <<
+	") returned error: " << cpp_strerror(-ret) << dendl;
+      return ret;
+    }
+
+    return 0;
+  }
+
+  // make everything added so far visible in the target shards
+  int drain() {
+    int ret = 0;
+    for (auto& shard : target_shards) {
+      int r = shard->flush();
+      if (r < 0) {
+        derr << "ERROR: target_shards[" << shard->get_num_shard() << "].flush() returned error: " << cpp_strerror(-r) << dendl;
+        ret = r;
+      }
+    }
+    for (auto& shard : target_shards) {
+      int r = shard->wait_all_aio();
+      if (r < 0) {
+        derr << "ERROR: target_shards[" << shard->get_num_shard() << "].wait_all_aio() returned error: " << cpp_strerror(-r) << dendl;
+        ret = r;
+      }
+    }
+    return ret;
+  }
+
   int finish() {
     int ret = 0;
     for (auto& shard : target_shards) {
@@ -233,6 +341,12 @@ public:
       if (r < 0) {
         derr << "ERROR: target_shards[" << shard->get_num_shard() << "].flush() returned error: " << cpp_strerror(-r) << dendl;
         ret = r;
+        continue;
+      }
+      r = shard->write_stats();
+      if (r < 0) {
+        derr << "ERROR: target_shards[" << shard->get_num_shard() << "].write_stats() returned error: " << cpp_strerror(-r) << dendl;
+        ret = r;
       }
     }
     for (auto& shard : target_shards) {
@@ -520,9 +634,158 @@ int RGWBucketReshardLock::renew(const Clock::time_point& now) {
 }
 
 
+static int get_target_shard(rgw::sal::RGWRadosStore *store,
+			    const RGWBucketInfo& new_bucket_info,
+			    const cls_rgw_obj_key& cls_key,
+			    int *shard_index)
+{
+  rgw_obj_key key(cls_key);
+  rgw_obj obj(new_bucket_info.bucket, key);
+  RGWMPObj mp;
+  if (key.ns == RGW_OBJ_NS_MULTIPART && mp.from_meta(key.name)) {
+    // place the multipart .meta object on the same shard as its head object
+    obj.index_hash_source = mp.get_key();
+  }
+  int target_shard_id;
+  int ret = store->getRados()->get_target_shard_id(new_bucket_info.layout.current_index.layout.normal, obj.get_hash_object(), &target_shard_id);
+  if (ret < 0) {
+    lderr(store->ctx()) << "ERROR: get_target_shard_id() returned ret=" << ret << dendl;
+    return ret;
+  }
+
+  *shard_index = (target_shard_id > 0 ? target_shard_id : 0);
+  return 0;
+}
+
+int RGWBucketReshard::renew_locks()
+{
+  Clock::time_point now = Clock::now();
+  if (reshard_lock.should_renew(now)) {
+    // assume outer locks have timespans at least the size of ours, so
+    // can call inside conditional
+    if (outer_reshard_lock) {
+      int ret = outer_reshard_lock->renew(now);
+      if (ret < 0) {
+	return ret;
+      }
+    }
+    int ret = reshard_lock.renew(now);
+    if (ret < 0) {
+      lderr(store->ctx()) << "Error renewing bucket lock: " << ret << dendl;
+      return ret;
+    }
+  }
+  return 0;
+}
+
+bool RGWBucketReshard::can_reshard_online()
+{
+  if (!store->ctx()->_conf.get_val<bool>("rgw_reshard_online")) {
+    return false;
+  }
+
+  // every source shard must be able to record the names written to it
+  const int num_source_shards =
+    (bucket_info.layout.current_index.layout.normal.num_shards > 0 ? bucket_info.layout.current_index.layout.normal.num_shards : 1);
+  for (int i = 0; i < num_source_shards; ++i) {
+    vector<string> names;
+    bool is_truncated;
+    int ret = store->getRados()->reshard_log_list(bucket_info, i, string(), 0,
+						  &names, &is_truncated);
+    if (ret == -EOPNOTSUPP) {
+      ldout(store->ctx(), 0) << "WARNING: " << __func__ << ": bucket index "
+	"does not support online resharding, blocking writes instead" << dendl;
+      return false;
+    } else if (ret < 0 && ret != -ENOENT) {
+      ldout(store->ctx(), 0) << "WARNING: " << __func__ << ": failed to list "
+	"reshard log of shard " << i << ": " << cpp_strerror(-ret) <<
+	", blocking writes instead" << dendl;
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+ * copy again the entries of every name that was written while the
+ * index was copied online. writes are blocked at this point, so the
+ * source shards no longer change
+ */
+int RGWBucketReshard::apply_reshard_log(BucketReshardManager& target_shards_mgr,
+					const RGWBucketInfo& new_bucket_info,
+					int max_entries)
+{
+  const int num_source_shards =
+    (bucket_info.layout.current_index.layout.normal.num_shards > 0 ? bucket_info.layout.current_index.layout.normal.num_shards : 1);
+  uint64_t total_names = 0;
+  vector<string> names;
+  list<rgw_cls_bi_entry> entries;
+  for (int i = 0; i < num_source_shards; ++i) {
+    string marker;
+    bool is_truncated = true;
+    while (is_truncated) {
+      names.clear();
+      int ret = store->getRados()->reshard_log_list(bucket_info, i, marker,
+						    max_entries, &names,
+						    &is_truncated);
+      if (ret == -ENOENT) {
+	break;
+      } else if (ret < 0) {
+	derr << "ERROR: reshard_log_list(): " << cpp_strerror(-ret) << dendl;
+	return ret;
+      }
+
+      for (auto& name : names) {
+	marker = name;
+
+	list<rgw_cls_bi_entry> source;
+	string entry_marker;
+	bool more = true;
+	while (more) {
+	  entries.clear();
+	  ret = store->getRados()->bi_list(bucket_info, i, name, entry_marker,
+					   max_entries, &entries, &more);
+	  if (ret == -ENOENT) {
+	    break;
+	  } else if (ret < 0) {
+	    derr << "ERROR: bi_list(): " << cpp_strerror(-ret) << dendl;
+	    return ret;
+	  }
+	  if (!entries.empty()) {
+	    entry_marker = entries.back().idx;
+	  }
+	  source.splice(source.end(), entries);
+	}
+
+	int shard_index;
+	ret = get_target_shard(store, new_bucket_info, cls_rgw_obj_key(name),
+			       &shard_index);
+	if (ret < 0) {
+	  return ret;
+	}
+	ret = target_shards_mgr.replace_entries(shard_index, name, source);
+	if (ret < 0) {
+	  return ret;
+	}
+	++total_names;
+
+	ret = renew_locks();
+	if (ret < 0) {
+	  return ret;
+	}
+      }
+    }
+  }
+
+  ldout(store->ctx(), 10) << __func__ << ": copied entries of " <<
+    total_names << " names written during the reshard" << dendl;
+  return 0;
+}
+
 int RGWBucketReshard::do_reshard(int num_shards,
 				 RGWBucketInfo& new_bucket_info,
 				 int max_entries,
+				 bool online,
 				 bool verbose,
 				 ostream *out,
 				 Formatter *formatter)
@@ -574,6 +837,10 @@ int RGWBucketReshard::do_reshard(int num_shards,
 
   const int num_source_shards =
     (bucket_info.layout.current_index.layout.normal.num_shards > 0 ? bucket_info.layout.current_index.layout.normal.num_shards : 1);
+  // writes go on during an online reshard, pace the copy to leave the
+  // index pool room for them
+  const auto online_delay = std::chrono::milliseconds(online ?
+    store->ctx()->_conf.get_val<uint64_t>("rgw_reshard_online_delay_ms") : 0);
   string marker;
   for (int i = 0; i < num_source_shards; ++i) {
     bool is_truncated = true;
@@ -599,47 +866,25 @@ int RGWBucketReshard::do_reshard(int num_shards,
 
 	marker = entry.idx;
 
-	int target_shard_id;
 	cls_rgw_obj_key cls_key;
 	RGWObjCategory category;
 	rgw_bucket_category_stats stats;
 	bool account = entry.get_info(&cls_key, &category, &stats);
-	rgw_obj_key key(cls_key);
-	rgw_obj obj(new_bucket_info.bucket, key);
-	RGWMPObj mp;
-	if (key.ns == RGW_OBJ_NS_MULTIPART && mp.from_meta(key.name)) {
-	  // place the multipart .meta object on the same shard as its head object
-	  obj.index_hash_source = mp.get_key();
-	}
-	int ret = store->getRados()->get_target_shard_id(new_bucket_info.layout.current_index.layout.normal, obj.get_hash_object(), &target_shard_id);
+	int shard_index;
+	int ret = get_target_shard(store, new_bucket_info, cls_key, &shard_index);
 	if (ret < 0) {
-	  lderr(store->ctx()) << "ERROR: get_target_shard_id() returned ret=" << ret << dendl;
 	  return ret;
 	}
 
-	int shard_index = (target_shard_id > 0 ? target_shard_id : 0);
-
 	ret = target_shards_mgr.add_entry(shard_index, entry, account,
 					  category, stats);
 	if (ret < 0) {
 	  return ret;
 	}
 
-	Clock::time_point now = Clock::now();
-	if (reshard_lock.should_renew(now)) {
-	  // assume outer locks have timespans at least the size of ours, so
-	  // can call inside conditional
-	  if (outer_reshard_lock) {
-	    ret = outer_reshard_lock->renew(now);
-	    if (ret < 0) {
-	      return ret;
-	    }
-	  }
-	  ret = reshard_lock.renew(now);
-	  if (ret < 0) {
-	    lderr(store->ctx()) << "Error renewing bucket lock: " << ret << dendl;
-	    return ret;
-	  }
+	ret = renew_locks();
+	if (ret < 0) {
+	  return ret;
 	}
 	if (verbose_json_out) {
 	  formatter->close_section();
@@ -648,6 +893,10 @@ int RGWBucketReshard::do_reshard(int num_shards,
 	  (*out) << " " << total_entries;
 	}
       } // entries loop
+
+      if (online_delay.count() && is_truncated) {
+	std::this_thread::sleep_for(online_delay);
+      }
     }
   }
 
@@ -658,6 +907,27 @@ int RGWBucketReshard::do_reshard(int num_shards,
     (*out) << " " << total_entries << std::endl;
   }
 
+  if (online) {
+    // what was copied must be in place before it is patched up
+    ret = target_shards_mgr.drain();
+    if (ret < 0) {
+      lderr(store->ctx()) << "ERROR: failed to reshard" << dendl;
+      return -EIO;
+    }
+
+    // block writes for the final pass over the names written meanwhile
+    ret = set_resharding_status(new_bucket_info.bucket.bucket_id, num_shards,
+				cls_rgw_reshard_status::IN_PROGRESS);
+    if (ret < 0) {
+      return ret;
+    }
+
+    ret = apply_reshard_log(target_shards_mgr, new_bucket_info, max_entries);
+    if (ret < 0) {
+      return ret;
+    }
+  }
+
   ret = target_shards_mgr.finish();
   if (ret < 0) {
     lderr(store->ctx()) << "ERROR: failed to reshard" << dendl;
@@ -695,6 +965,7 @@ int RGWBucketReshard::execute(int num_shards, int max_op_entries,
     return ret;
   }
 
+  bool online = false;
   RGWBucketInfo new_bucket_info;
   ret = create_new_bucket_instance(num_shards, new_bucket_info);
   if (ret < 0) {
@@ -710,9 +981,12 @@ int RGWBucketReshard::execute(int num_shards, int max_op_entries,
   }
 
   // set resharding status of current bucket_info & shards with
-  // information about planned resharding
-  ret = set_resharding_status(new_bucket_info.bucket.bucket_id,
-			      num_shards, cls_rgw_reshard_status::IN_PROGRESS);
+  // information about planned resharding; online, the shards keep
+  // taking writes and record what they touch until the final pass
+  online = can_reshard_online();
+  ret = set_resharding_status(new_bucket_info.bucket.bucket_id, num_shards,
+			      (online ? cls_rgw_reshard_status::IN_LOGRECORD :
+			       cls_rgw_reshard_status::IN_PROGRESS));
   if (ret < 0) {
     goto error_out;
   }
@@ -720,6 +994,7 @@ int RGWBucketReshard::execute(int num_shards, int max_op_entries,
   ret = do_reshard(num_shards,
 		   new_bucket_info,
 		   max_op_entries,
+		   online,
                    verbose, out, formatter);
   if (ret < 0) {
     goto error_out;
@@ -24,6 +24,7 @@
 
 
 class RGWReshard;
+class BucketReshardManager;
 namespace rgw { namespace sal {
   class RGWRadosStore;
 } }
@@ -86,9 +87,15 @@ private:
 
   int create_new_bucket_instance(int new_num_shards,
 				 RGWBucketInfo& new_bucket_info);
+  int renew_locks();
+  bool can_reshard_online();
+  int apply_reshard_log(BucketReshardManager& target_shards_mgr,
+			const RGWBucketInfo& new_bucket_info,
+			int max_entries);
   int do_reshard(int num_shards,
 		 RGWBucketInfo& new_bucket_info,
 		 int max_entries,
+		 bool online,
                  bool verbose,
                  ostream *os,
 		 Formatter *formatter);
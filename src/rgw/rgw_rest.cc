@@ -766,7 +766,11 @@ int dump_body(struct req_state* const s,
 
 int dump_body(struct req_state* const s, /* const */ ceph::buffer::list& bl)
 {
-  return dump_body(s, bl.c_str(), bl.length());
+  try {
+    return RESTFUL_IO(s)->send_body_buffers(bl);
+  } catch (rgw::io::Exception& e) {
+    return -e.code().value();
+  }
 }
 
 int dump_body(struct req_state* const s, const std::string& str)
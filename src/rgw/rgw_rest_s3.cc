@@ -63,6 +63,7 @@
 #include "rgw_rest_iam.h"
 #include "rgw_sts.h"
 #include "rgw_sal_rados.h"
+#include "rgw_perf_counters.h"
 
 #define dout_context g_ceph_context
 #define dout_subsys ceph_subsys_rgw
@@ -428,7 +429,10 @@ done:
 
 send_data:
   if (get_data && !op_ret) {
-    int r = dump_body(s, bl.c_str() + bl_ofs, bl_len);
+    // send the range without flattening bl into a contiguous buffer
+    bufferlist data;
+    data.substr_of(bl, bl_ofs, bl_len);
+    int r = dump_body(s, data);
     if (r < 0)
       return r;
   }
@@ -2608,7 +2612,7 @@ int RGWPutObj_ObjStore_S3::get_encrypt_filter(
        * We use crypto mode that configured as if we were decrypting. */
       res = rgw_s3_prepare_decrypt(s, xattrs, &block_crypt, crypt_http_responses);
       if (res == 0 && block_crypt != nullptr)
-        filter->reset(new RGWPutObj_BlockEncrypt(s->cct, cb, std::move(block_crypt)));
+        filter->reset(new RGWPutObj_BlockEncrypt(s->cct, cb, std::move(block_crypt), s->yield));
     }
     /* it is ok, to not have encryption at all */
   }
@@ -2617,7 +2621,7 @@ int RGWPutObj_ObjStore_S3::get_encrypt_filter(
     std::unique_ptr<BlockCrypt> block_crypt;
     res = rgw_s3_prepare_encrypt(s, attrs, nullptr, &block_crypt, crypt_http_responses);
     if (res == 0 && block_crypt != nullptr) {
-      filter->reset(new RGWPutObj_BlockEncrypt(s->cct, cb, std::move(block_crypt)));
+      filter->reset(new RGWPutObj_BlockEncrypt(s->cct, cb, std::move(block_crypt), s->yield));
     }
   }
   return res;
@@ -3151,7 +3155,7 @@ int RGWPostObj_ObjStore_S3::get_encrypt_filter(
   int res = rgw_s3_prepare_encrypt(s, attrs, &parts, &block_crypt,
                                    crypt_http_responses);
   if (res == 0 && block_crypt != nullptr) {
-    filter->reset(new RGWPutObj_BlockEncrypt(s->cct, cb, std::move(block_crypt)));
+    filter->reset(new RGWPutObj_BlockEncrypt(s->cct, cb, std::move(block_crypt), s->yield));
   }
   return res;
 }
@@ -3924,7 +3928,8 @@ void RGWDeleteMultiObj_ObjStore_S3::begin_response()
 
 void RGWDeleteMultiObj_ObjStore_S3::send_partial_response(rgw_obj_key& key,
 							  bool delete_marker,
-							  const string& marker_version_id, int ret)
+							  const string& marker_version_id, int ret,
+							  boost::asio::deadline_timer *formatter_flush_cond)
 {
   if (!key.empty()) {
     if (ret == 0 && !quiet) {
@@ -3954,7 +3959,11 @@ void RGWDeleteMultiObj_ObjStore_S3::send_partial_response(rgw_obj_key& key,
       s->formatter->close_section();
     }
 
-    rgw_flush_formatter(s, s->formatter);
+    if (formatter_flush_cond) {
+      formatter_flush_cond->cancel();
+    } else {
+      rgw_flush_formatter(s, s->formatter);
+    }
   }
 }
 
@@ -6002,7 +6011,88 @@ int RGWSelectObj_ObjStore_S3::get_params(optional_yield y)
     return status;
   }
 
-  return RGWGetObj_ObjStore_S3::get_params(y);
+  ret = RGWGetObj_ObjStore_S3::get_params(y);
+  if (ret < 0) {
+    return ret;
+  }
+
+  if (!m_scan_range.empty()) {
+    // the scan range replaces any Range header
+    range_str = m_scan_range.get_range_str().c_str();
+    range_parsed = false;
+  }
+
+  if (m_header_info == "USE" && m_scan_range.may_skip_first_record()) {
+    // the column names come from the first line of the object, which
+    // the scan range may not read
+    ret = read_header_line(y);
+    if (ret < 0) {
+      return ret;
+    }
+  }
+
+  return 0;
+}
+
+int RGWSelectObj_ObjStore_S3::read_header_line(optional_yield y)
+{
+  std::unique_ptr<rgw::sal::RGWObject::ReadOp> read_op(s->object->get_read_op(s->obj_ctx));
+  int ret = read_op->prepare(y);
+  if (ret < 0) {
+    return ret;
+  }
+
+  const auto& attrs = s->object->get_attrs();
+  if (attrs.count(RGW_ATTR_COMPRESSION) || attrs.count(RGW_ATTR_CRYPT_MODE)) {
+    ldout(s->cct, 10) << "s3-select query: FileHeaderInfo USE with a scan "
+                         "range is not supported for compressed or encrypted "
+                         "objects" << dendl;
+    return -ERR_NOT_IMPLEMENTED;
+  }
+
+  const uint64_t obj_size = s->object->get_obj_size();
+  const uint64_t len = std::min<uint64_t>(obj_size,
+                                          s->cct->_conf->rgw_max_chunk_size);
+  if (len == 0) {
+    return 0;
+  }
+  bufferlist bl;
+  ret = read_op->read(0, len - 1, bl, y);
+  if (ret < 0) {
+    return ret;
+  }
+
+  const std::string head = bl.to_str();
+  const auto pos = head.find(m_row_delimiter[0]);
+  if (pos != std::string::npos) {
+    m_header_line = head.substr(0, pos + 1);
+  } else if (len < obj_size) {
+    ldout(s->cct, 10) << "s3-select query: the first line of the object "
+                         "exceeds " << len << " bytes" << dendl;
+    return -EINVAL;
+  } else {
+    m_header_line = head + m_row_delimiter[0];
+  }
+  return 0;
+}
+
+int RGWSelectObj_ObjStore_S3::parse_scan_range()
+{
+  std::string scan_range;
+  extract_by_tag("ScanRange", scan_range);
+  if (scan_range.empty()) {
+    return 0;
+  }
+
+  int ret = m_scan_range.parse(scan_range);
+  if (ret < 0) {
+    ldout(s->cct, 10) << "s3-select query: invalid ScanRange" << dendl;
+    return ret;
+  }
+
+  ldout(s->cct, 10) << "s3-select query: scan range "
+                    << m_scan_range.get_range_str() << dendl;
+  return 0;
 }
 
 void RGWSelectObj_ObjStore_S3::encode_short(char* buff, uint16_t s, int& i)
@@ -6088,7 +6178,8 @@ int RGWSelectObj_ObjStore_S3::create_message(char* buff, u_int32_t result_len, u
 #define PAYLOAD_LINE "\n<Payload>\n<Records>\n<Payload>\n"
 #define END_PAYLOAD_LINE "\n</Payload></Records></Payload>"
 
-int RGWSelectObj_ObjStore_S3::run_s3select(const char* query, const char* input, size_t input_length)
+int RGWSelectObj_ObjStore_S3::run_s3select(const char* query, const char* input, size_t input_length,
+                                           size_t stream_length)
 {
   int status = 0;
   csv_object::csv_defintions csv;
@@ -6116,8 +6207,10 @@ int RGWSelectObj_ObjStore_S3::run_s3select(const char* query, const char* input,
       csv.escape_char = *m_escape_char.c_str();
     }
 
+    // a scan range that leaves out the first line of the object has no
+    // header to ignore, and the one to use is fed in by scan_input()
     if(m_header_info.compare("IGNORE")==0) {
-      csv.ignore_header_info=true;
+      csv.ignore_header_info = !m_scan_range.skips_first_record();
     }
     else if(m_header_info.compare("USE")==0) {
       csv.use_header_info=true;
@@ -6138,9 +6231,12 @@ int RGWSelectObj_ObjStore_S3::run_s3select(const char* query, const char* input,
     header_size = create_header_records(m_buff_header.get());
     m_result.append(m_buff_header.get(), header_size);
     m_result.append(PAYLOAD_LINE);
-    status = m_s3_csv_object->run_s3select_on_stream(m_result, input, input_length, s->obj_size);
+    const auto result_start = m_result.size();
+    status = m_s3_csv_object->run_s3select_on_stream(m_result, input, input_length, stream_length);
     if(status<0) {
       m_result.append(m_s3_csv_object->get_error_description());
+    } else {
+      m_bytes_returned += m_result.size() - result_start;
     }
   }
 
@@ -6191,7 +6287,7 @@ int RGWSelectObj_ObjStore_S3::handle_aws_cli_parameters(std::string& sql_query)
 
   extract_by_tag("FileHeaderInfo", m_header_info);
 
-  return 0;
+  return parse_scan_range();
 }
 
 int RGWSelectObj_ObjStore_S3::extract_by_tag(std::string tag_name, std::string& result)
@@ -6211,9 +6307,90 @@ int RGWSelectObj_ObjStore_S3::extract_by_tag(std::string tag_name, std::string&
   return 0;
 }
 
+int RGWSelectObj_ObjStore_S3::scan_input(const char* input, size_t input_length)
+{
+  m_bytes_scanned += input_length;
+
+  const char* begin = input;
+  const char* stop = input + input_length;
+  if (!m_scan_range.scan(&begin, &stop, m_row_delimiter[0])) {
+    return 0;
+  }
+
+  // the engine flushes its last record once it has been fed the whole
+  // stream, so tell it how much of the read is going to be queried
+  const uint64_t length = stop - begin;
+  uint64_t stream_length = m_header_line.size() + m_bytes_processed + length;
+  if (!m_scan_range.is_done()) {
+    stream_length += end + 1 - m_scan_range.get_pos();
+  }
+  const bool first_input = (m_bytes_processed == 0);
+  m_bytes_processed += length;
+
+  if (first_input && !m_header_line.empty()) {
+    // the engine takes the column names from the first line it is fed
+    std::string input_with_header = m_header_line;
+    input_with_header.append(begin, length);
+    return run_s3select(m_sql_query.c_str(), input_with_header.data(),
+                        input_with_header.size(), stream_length);
+  }
+  return run_s3select(m_sql_query.c_str(), begin, length, stream_length);
+}
+
+void RGWSelectObj_ObjStore_S3::send_event(const char* event_type,
+                                          const char* content_type,
+                                          const std::string& payload)
+{
+  std::string buff(12, '\0'); // prelude, filled in by create_message
+
+  auto add_header = [&buff] (const char* name, const char* value) {
+    buff.push_back(char(strlen(name)));
+    buff.append(name);
+    buff.push_back(char(7)); // string value
+    const uint16_t len = htons(strlen(value));
+    buff.append(reinterpret_cast<const char*>(&len), sizeof(len));
+    buff.append(value);
+  };
+  add_header(header_name_str[EVENT_TYPE], event_type);
+  if (content_type) {
+    add_header(header_name_str[CONTENT_TYPE], content_type);
+  }
+  add_header(header_name_str[MESSAGE_TYPE], header_value_str[EVENT]);
+  const auto header_len = buff.size() - 12;
+
+  buff.append(payload);
+  buff.append(4, '\0'); // message crc
+  int buff_len = create_message(buff.data(), buff.size() - 16, header_len);
+  s->formatter->write_bin_data(buff.data(), buff_len);
+  rgw_flush_formatter_and_reset(s, s->formatter);
+}
+
+void RGWSelectObj_ObjStore_S3::send_stats()
+{
+  ldout(s->cct, 10) << "s3-select query: scanned=" << m_bytes_scanned
+                    << " processed=" << m_bytes_processed
+                    << " returned=" << m_bytes_returned << dendl;
+  if (perfcounter) {
+    perfcounter->inc(l_rgw_select_scan_b, m_bytes_scanned);
+    perfcounter->inc(l_rgw_select_process_b, m_bytes_processed);
+    perfcounter->inc(l_rgw_select_return_b, m_bytes_returned);
+  }
+
+  std::string stats = "<Stats><BytesScanned>" + std::to_string(m_bytes_scanned) +
+    "</BytesScanned><BytesProcessed>" + std::to_string(m_bytes_processed) +
+    "</BytesProcessed><BytesReturned>" + std::to_string(m_bytes_returned) +
+    "</BytesReturned></Stats>";
+  send_event("Stats", "text/xml", stats);
+  send_event("End", nullptr, "");
+}
+
 int RGWSelectObj_ObjStore_S3::send_response_data(bufferlist& bl, off_t ofs, off_t len)
 {
   if (len == 0) {
+    // end of the object
+    if (chunk_number > 0 && op_ret >= 0) {
+      send_stats();
+    }
     return 0;
   }
 
@@ -6228,11 +6405,16 @@ int RGWSelectObj_ObjStore_S3::send_response_data(bufferlist& bl, off_t ofs, off_
   // to the user without having to wait for the full length of it.
   if (chunk_number == 0) {
     end_header(s, this, "application/xml", CHUNKED_TRANSFER_ENCODING);
+    m_scan_range.start_read(this->ofs, s->obj_size);
+    if (!m_scan_range.skips_first_record()) {
+      // the read starts with the header line itself
+      m_header_line.clear();
+    }
   }
 
   int status=0;
   for(auto& it : bl.buffers()) {
-    status = run_s3select(m_sql_query.c_str(), &(it)[0], it.length());
+    status = scan_input(&(it)[0], it.length());
     if(status<0) {
       break;
     }
@@ -28,6 +28,7 @@
 #include "rgw_auth.h"
 #include "rgw_auth_filters.h"
 #include "rgw_sts.h"
+#include "rgw_select_scan_range.h"
 
 struct rgw_http_error {
   int http_ret;
@@ -493,7 +494,8 @@ public:
   void send_status() override;
   void begin_response() override;
   void send_partial_response(rgw_obj_key& key, bool delete_marker,
-                             const string& marker_version_id, int ret) override;
+                             const string& marker_version_id, int ret,
+                             boost::asio::deadline_timer *formatter_flush_cond) override;
   void end_response() override;
 };
 
@@ -904,6 +906,17 @@ private:
   std::string m_header_info;
   std::string m_sql_query;
 
+  /* ScanRange: only records whose first byte lies in the range are
+   * queried, and only the bytes they span are read */
+  RGWSelectScanRange m_scan_range;
+  /* the first line of the object, for FileHeaderInfo USE with a scan
+   * range that leaves it out */
+  std::string m_header_line;
+
+  uint64_t m_bytes_scanned = 0;
+  uint64_t m_bytes_processed = 0;
+  uint64_t m_bytes_returned = 0;
+
 public:
   unsigned int chunk_number;
 
@@ -941,7 +954,19 @@ private:
 
   int create_message(char* buff, u_int32_t result_len, u_int32_t header_len);
 
-  int run_s3select(const char* query, const char* input, size_t input_length);
+  int run_s3select(const char* query, const char* input, size_t input_length,
+                   size_t stream_length);
+
+  int parse_scan_range();
+
+  int read_header_line(optional_yield y);
+
+  int scan_input(const char* input, size_t input_length);
+
+  void send_event(const char* event_type, const char* content_type,
+                  const std::string& payload);
+
+  void send_stats();
 
   int extract_by_tag(std::string tag_name, std::string& result);
 
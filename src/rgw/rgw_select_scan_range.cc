@@ -0,0 +1,122 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+#include "rgw_select_scan_range.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "common/strtol.h"
+
+int RGWSelectScanRange::parse(const std::string& scan_range)
+{
+  auto parse_val = [&scan_range] (const char* tag, std::optional<uint64_t>& val) {
+    const std::string open = std::string("<") + tag + ">";
+    const std::string close = std::string("</") + tag + ">";
+    auto b = scan_range.find(open);
+    if (b == std::string::npos) {
+      return 0;
+    }
+    b += open.size();
+    auto e = scan_range.find(close, b);
+    if (e == std::string::npos) {
+      return -EINVAL;
+    }
+    std::string err;
+    long long v = strict_strtoll(scan_range.substr(b, e - b).c_str(), 10, &err);
+    if (!err.empty() || v < 0) {
+      return -EINVAL;
+    }
+    val = v;
+    return 0;
+  };
+
+  int ret = parse_val("Start", start);
+  if (ret < 0) {
+    return ret;
+  }
+  ret = parse_val("End", end);
+  if (ret < 0) {
+    return ret;
+  }
+
+  if (start && end) {
+    if (*start > *end) {
+      return -EINVAL;
+    }
+    range_str = "bytes=" + std::to_string(*start > 0 ? *start - 1 : 0) + "-" +
+      std::to_string(*end + READ_AHEAD);
+  } else if (start) {
+    range_str = "bytes=" + std::to_string(*start > 0 ? *start - 1 : 0) + "-";
+  } else if (end) {
+    // only End: the records in the last End bytes, which run up to the
+    // end of the object. the offset of End isn't known before the read
+    if (*end == 0) {
+      return -EINVAL;
+    }
+    suffix = *end;
+    end.reset();
+    range_str = "bytes=-" + std::to_string(suffix + 1);
+  }
+  return 0;
+}
+
+void RGWSelectScanRange::start_read(uint64_t ofs, uint64_t obj_size)
+{
+  pos = ofs;
+  // the read starts a byte before the range, unless the range starts at
+  // the beginning of the object
+  if (start) {
+    skip_partial_record = *start > 0;
+  } else if (suffix) {
+    skip_partial_record = suffix < obj_size;
+  } else {
+    skip_partial_record = false;
+  }
+  skips_first = skip_partial_record;
+}
+
+bool RGWSelectScanRange::scan(const char** begin, const char** stop,
+			      char row_delimiter)
+{
+  if (done) {
+    // the rest of the read-ahead
+    return false;
+  }
+
+  const char* input = *begin;
+  const uint64_t input_pos = pos;
+  pos += *stop - *begin;
+
+  if (skip_partial_record) {
+    // the tail of a record that began before the scan range
+    auto d = static_cast<const char*>(memchr(*begin, row_delimiter,
+					     *stop - *begin));
+    if (!d) {
+      return false;
+    }
+    *begin = d + 1;
+    skip_partial_record = false;
+    if (end && input_pos + (*begin - input) > *end) {
+      // no record begins within the range
+      done = true;
+      return false;
+    }
+  }
+
+  if (end && pos > *end) {
+    // the record holding the last byte of the range ends at the first
+    // delimiter from there on
+    const char* from = input + (*end > input_pos ? *end - input_pos : 0);
+    from = std::max(from, *begin);
+    auto d = static_cast<const char*>(memchr(from, row_delimiter,
+					     *stop - from));
+    if (d) {
+      *stop = d + 1;
+      done = true;
+    }
+  }
+
+  return *begin != *stop;
+}
@@ -0,0 +1,58 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+/* the ScanRange of an s3 select request. a record belongs to the range
+ * when its first byte does. Records overhanging the end are read to
+ * completion, within a bounded read-ahead; the byte before the start is
+ * read too, so that we can tell whether a record begins exactly at the
+ * start. With only an End, the range is the last End bytes of the object */
+class RGWSelectScanRange {
+  std::optional<uint64_t> start;
+  std::optional<uint64_t> end; // absolute offset of the last byte
+  uint64_t suffix = 0; // with only an End
+  std::string range_str;
+
+  uint64_t pos = 0;
+  bool skip_partial_record = false;
+  bool skips_first = false;
+  bool done = false;
+
+public:
+  static constexpr uint64_t READ_AHEAD = 1024 * 1024;
+
+  /* parse the contents of the ScanRange element */
+  int parse(const std::string& scan_range);
+
+  bool empty() const { return range_str.empty(); }
+
+  /* the Range header to read the object with */
+  const std::string& get_range_str() const { return range_str; }
+
+  /* whether the range may leave out the first record of the object,
+   * which FileHeaderInfo refers to */
+  bool may_skip_first_record() const {
+    return (start && *start > 0) || suffix > 0;
+  }
+
+  /* the read of an object of obj_size bytes starts at ofs */
+  void start_read(uint64_t ofs, uint64_t obj_size);
+
+  /* the range leaves out the first record of the object */
+  bool skips_first_record() const { return skips_first; }
+
+  /* narrow [*begin, *stop) of the next input buffer down to the bytes of
+   * the records in the range. returns false if none of it is */
+  bool scan(const char** begin, const char** stop, char row_delimiter);
+
+  /* the offset of the next input buffer */
+  uint64_t get_pos() const { return pos; }
+
+  /* the last record in the range was scanned */
+  bool is_done() const { return done; }
+};
@@ -60,6 +60,13 @@ public:
   virtual bool should_full_sync() const {
       return true;
   }
+
+  // whether the data log shards of a source zone may sync on different
+  // threads at once (rgw_data_sync_threads). modules whose coroutines share
+  // unlocked state across shards must keep the default
+  virtual bool supports_parallel_sync() const {
+    return false;
+  }
 };
 
 typedef std::shared_ptr<RGWSyncModuleInstance> RGWSyncModuleInstanceRef;
@@ -505,7 +505,7 @@ int RGWDataAccess::Object::put(bufferlist& data,
       ldout(store->ctx(), 1) << "Cannot load plugin for compression type "
         << compression_type << dendl;
     } else {
-      compressor.emplace(store->ctx(), plugin, filter);
+      compressor.emplace(store->ctx(), plugin, filter, y);
       filter = &*compressor;
     }
   }
@@ -337,10 +337,14 @@ int RGWSI_Notify::watch_cb(uint64_t notify_id,
                            bufferlist& bl)
 {
   std::shared_lock l{watchers_lock};
-  if (cb) {
-    return cb->watch_cb(notify_id, cookie, notifier_id, bl);
+  int ret = 0;
+  for (auto cb : cbs) {
+    int r = cb->watch_cb(notify_id, cookie, notifier_id, bl);
+    if (r < 0 && ret == 0) {
+      ret = r;
+    }
   }
-  return 0;
+  return ret;
 }
 
 void RGWSI_Notify::set_enabled(bool status)
@@ -352,7 +356,7 @@ void RGWSI_Notify::set_enabled(bool status)
 void RGWSI_Notify::_set_enabled(bool status)
 {
   enabled = status;
-  if (cb) {
+  for (auto cb : cbs) {
     cb->set_enabled(status);
   }
 }
@@ -367,6 +371,48 @@ int RGWSI_Notify::distribute(const string& key, bufferlist& bl,
   return robust_notify(notify_obj, bl, y);
 }
 
+namespace {
+
+struct C_NotifyAsync {
+  CephContext *cct;
+  std::string oid;
+  bufferlist reply;
+  librados::AioCompletion *c{nullptr};
+
+  static void complete(librados::completion_t, void *arg) {
+    std::unique_ptr<C_NotifyAsync> n{static_cast<C_NotifyAsync*>(arg)};
+    const int r = n->c->get_return_value();
+    if (r < 0) {
+      ldout(n->cct, 1) << "WARNING: async notify on oid=" << n->oid
+          << " failed: " << cpp_strerror(-r) << dendl;
+    }
+    n->c->release();
+  }
+};
+
+} // anonymous namespace
+
+void RGWSI_Notify::distribute_async(const string& key, bufferlist& bl)
+{
+  RGWSI_RADOS::Obj notify_obj = pick_control_obj(key);
+  auto& ref = notify_obj.get_ref();
+
+  ldout(cct, 10) << "distributing async notification oid=" << ref.obj
+      << " bl.length()=" << bl.length() << dendl;
+
+  auto n = new C_NotifyAsync;
+  n->cct = cct;
+  n->oid = ref.obj.oid;
+  n->c = librados::Rados::aio_create_completion(n, &C_NotifyAsync::complete);
+  int r = ref.pool.ioctx().aio_notify(ref.obj.oid, n->c, bl, 0, &n->reply);
+  if (r < 0) {
+    ldout(cct, 1) << "WARNING: async notify on oid=" << ref.obj.oid
+        << " failed: " << cpp_strerror(-r) << dendl;
+    n->c->release();
+    delete n;
+  }
+}
+
 int RGWSI_Notify::robust_notify(RGWSI_RADOS::Obj& notify_obj, bufferlist& bl,
                                 optional_yield y)
 {
@@ -470,8 +516,14 @@ int RGWSI_Notify::robust_notify(RGWSI_RADOS::Obj& notify_obj, bufferlist& bl,
 void RGWSI_Notify::register_watch_cb(CB *_cb)
 {
   std::unique_lock l{watchers_lock};
-  cb = _cb;
-  _set_enabled(enabled);
+  cbs.push_back(_cb);
+  _cb->set_enabled(enabled);
+}
+
+void RGWSI_Notify::unregister_watch_cb(CB *_cb)
+{
+  std::unique_lock l{watchers_lock};
+  cbs.erase(std::remove(cbs.begin(), cbs.end(), _cb), cbs.end());
 }
 
 void RGWSI_Notify::schedule_context(Context *c)
@@ -46,7 +46,7 @@ private:
   string get_control_oid(int i);
   RGWSI_RADOS::Obj pick_control_obj(const string& key);
 
-  CB *cb{nullptr};
+  std::vector<CB *> cbs;
 
   std::optional<int> finisher_handle;
   RGWSI_Notify_ShutdownCB *shutdown_cb{nullptr};
@@ -96,6 +96,10 @@ public:
   };
 
   int distribute(const string& key, bufferlist& bl, optional_yield y);
+  /* send the notification without waiting for the acks; failures are
+   * only logged */
+  void distribute_async(const string& key, bufferlist& bl);
 
   void register_watch_cb(CB *cb);
+  void unregister_watch_cb(CB *cb);
 };
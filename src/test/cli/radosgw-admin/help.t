@@ -121,6 +121,8 @@
                                --include-all to list all entries, including unexpired)
     gc process                 manually process garbage (specify
                                --include-all to process all entries, including unexpired)
+    gc throughput              show the backlog of each gc shard and the rate its
+                               last pass drained it at
     lc list                    list all bucket lifecycle progress
     lc get                     get a lifecycle bucket configuration
     lc process                 manually process lifecycle
@@ -1141,3 +1141,133 @@ TEST_F(cls_rgw, bi_log_trim)
     EXPECT_FALSE(truncated);
   }
 }
+
+TEST_F(cls_rgw, index_complete_batch)
+{
+  string bucket_oid = str_int("bucket", 8);
+
+  ObjectWriteOperation op;
+  cls_rgw_bucket_init_index(op);
+  ASSERT_EQ(0, ioctx.operate(bucket_oid, &op));
+
+  uint64_t obj_size = 1024;
+
+  vector<rgw_cls_obj_complete_op> ops;
+  for (int i = 0; i < NUM_OBJS; i++) {
+    cls_rgw_obj_key obj = str_int("obj", i);
+    string tag = str_int("tag", i);
+    string loc = str_int("loc", i);
+
+    index_prepare(ioctx, bucket_oid, CLS_RGW_OP_ADD, tag, obj, loc);
+
+    rgw_cls_obj_complete_op c;
+    c.op = CLS_RGW_OP_ADD;
+    c.key = obj;
+    c.tag = tag;
+    c.ver.pool = ioctx.get_id();
+    c.ver.epoch = 1;
+    c.meta.category = RGWObjCategory::None;
+    c.meta.size = c.meta.accounted_size = obj_size;
+    c.log_op = true;
+    ops.push_back(c);
+  }
+
+  // the same name twice fails the whole batch
+  {
+    auto dup = ops;
+    dup.push_back(ops.front());
+    ObjectWriteOperation op;
+    cls_rgw_bucket_complete_ops(op, std::move(dup));
+    ASSERT_EQ(-EINVAL, ioctx.operate(bucket_oid, &op));
+    test_stats(ioctx, bucket_oid, RGWObjCategory::None, 0, 0);
+  }
+
+  {
+    ObjectWriteOperation op;
+    cls_rgw_bucket_complete_ops(op, std::move(ops));
+    ASSERT_EQ(0, ioctx.operate(bucket_oid, &op));
+  }
+  test_stats(ioctx, bucket_oid, RGWObjCategory::None, NUM_OBJS,
+             obj_size * NUM_OBJS);
+
+  // each completion got its own bilog entry
+  cls_rgw_bi_log_list_ret bilog;
+  ASSERT_EQ(0, bilog_list(ioctx, bucket_oid, &bilog));
+  set<string> ids;
+  for (auto& e : bilog.entries) {
+    if (e.state == CLS_RGW_STATE_COMPLETE) {
+      ids.insert(e.id);
+    }
+  }
+  EXPECT_EQ((size_t)NUM_OBJS, ids.size());
+}
+
+TEST_F(cls_rgw, index_reshard_log)
+{
+  string bucket_oid = str_int("bucket", 9);
+
+  ObjectWriteOperation op;
+  cls_rgw_bucket_init_index(op);
+  ASSERT_EQ(0, ioctx.operate(bucket_oid, &op));
+
+  cls_rgw_bucket_instance_entry entry;
+  entry.set_status("new_instance", 3, cls_rgw_reshard_status::IN_LOGRECORD);
+  ASSERT_EQ(0, cls_rgw_set_bucket_resharding(ioctx, bucket_oid, entry));
+
+  // writes aren't blocked while the log is recorded
+  cls_rgw_obj_key obj("obj");
+  string tag = "tag";
+  string loc = "loc";
+  {
+    ObjectWriteOperation op;
+    cls_rgw_guard_bucket_resharding(op, -EBUSY, obj.name);
+    rgw_zone_set zones_trace;
+    cls_rgw_bucket_prepare_op(op, CLS_RGW_OP_ADD, tag, obj, loc, true, 0,
+                              zones_trace);
+    ASSERT_EQ(0, ioctx.operate(bucket_oid, &op));
+  }
+
+  // the guard records the name before the op completes
+  vector<string> names;
+  bool truncated;
+  ASSERT_EQ(0, cls_rgw_reshard_log_list(ioctx, bucket_oid, "", 100, &names,
+                                        &truncated));
+  ASSERT_EQ(1u, names.size());
+  EXPECT_EQ("obj", names[0]);
+
+  rgw_bucket_dir_entry_meta meta;
+  meta.category = RGWObjCategory::None;
+  meta.size = 1024;
+  index_complete(ioctx, bucket_oid, CLS_RGW_OP_ADD, tag, 1, obj, meta);
+
+  ASSERT_EQ(0, cls_rgw_reshard_log_list(ioctx, bucket_oid, "", 100, &names,
+                                        &truncated));
+  ASSERT_EQ(1u, names.size());
+  EXPECT_EQ("obj", names[0]);
+  EXPECT_FALSE(truncated);
+
+  // the log isn't part of the index entries
+  list<rgw_cls_bi_entry> entries;
+  ASSERT_EQ(0, cls_rgw_bi_list(ioctx, bucket_oid, "", "", 100, &entries,
+                               &truncated));
+  EXPECT_EQ(1u, entries.size());
+  test_stats(ioctx, bucket_oid, RGWObjCategory::None, 1, 1024);
+
+  // the final pass blocks writes
+  entry.set_status("new_instance", 3, cls_rgw_reshard_status::IN_PROGRESS);
+  ASSERT_EQ(0, cls_rgw_set_bucket_resharding(ioctx, bucket_oid, entry));
+  {
+    ObjectWriteOperation op;
+    cls_rgw_guard_bucket_resharding(op, -EBUSY, obj.name);
+    rgw_zone_set zones_trace;
+    cls_rgw_bucket_prepare_op(op, CLS_RGW_OP_ADD, tag, obj, loc, true, 0,
+                              zones_trace);
+    ASSERT_EQ(-EBUSY, ioctx.operate(bucket_oid, &op));
+  }
+
+  // and clearing the status drops the log
+  ASSERT_EQ(0, cls_rgw_clear_bucket_resharding(ioctx, bucket_oid));
+  ASSERT_EQ(0, cls_rgw_reshard_log_list(ioctx, bucket_oid, "", 100, &names,
+                                        &truncated));
+  EXPECT_TRUE(names.empty());
+}
@@ -723,6 +723,46 @@ TEST(LibRadosAio, RoundTripWriteFullPP) {
   ASSERT_EQ(0, memcmp(bl3.c_str(), buf2, sizeof(buf2)));
 }
 
+TEST(LibRadosAio, OperateBatchPP) {
+  AioTestDataPP test_data;
+  ASSERT_EQ("", test_data.init());
+  const int num = 16;
+  std::vector<ObjectWriteOperation> write_ops(num);
+  std::vector<std::pair<std::string, ObjectWriteOperation*>> ops;
+  for (int i = 0; i < num; ++i) {
+    bufferlist bl;
+    bl.append(std::string(128, 'a' + i));
+    write_ops[i].write_full(bl);
+    ops.emplace_back("batch" + std::to_string(i), &write_ops[i]);
+  }
+  // an exclusive create of an object written earlier in the batch fails
+  // without failing the rest of the batch
+  ObjectWriteOperation excl;
+  excl.create(true);
+  ops.emplace_back("batch0", &excl);
+
+  std::vector<int> rvals;
+  auto my_completion = std::unique_ptr<AioCompletion>{Rados::aio_create_completion()};
+  ASSERT_TRUE(my_completion);
+  ASSERT_EQ(0, test_data.m_ioctx.aio_operate_batch(ops, my_completion.get(),
+						   &rvals, 0));
+  {
+    TestAlarm alarm;
+    ASSERT_EQ(0, my_completion->wait_for_complete());
+  }
+  ASSERT_EQ(num + 1, (int)rvals.size());
+  // ops on the same object keep their submission order
+  ASSERT_EQ(-EEXIST, my_completion->get_return_value());
+  ASSERT_EQ(-EEXIST, rvals[num]);
+  for (int i = 0; i < num; ++i) {
+    ASSERT_EQ(0, rvals[i]);
+    bufferlist bl;
+    ASSERT_EQ(128, test_data.m_ioctx.read("batch" + std::to_string(i), bl,
+					  128, 0));
+    ASSERT_EQ(std::string(128, 'a' + i), bl.to_str());
+  }
+}
+
 //using ObjectWriteOperation/ObjectReadOperation with iohint
 TEST(LibRadosAio, RoundTripWriteFullPP2)
 {
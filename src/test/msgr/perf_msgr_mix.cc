@@ -0,0 +1,630 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+/*
+ * Loopback messenger benchmark replaying a weighted mix of OSD message
+ * types over many connections, in either crc or secure mode.  Server and
+ * clients live in the same process, so no cluster is needed.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "common/ceph_argparse.h"
+#include "common/ceph_time.h"
+#include "common/debug.h"
+#include "common/Thread.h"
+#include "global/global_init.h"
+#include "include/str_list.h"
+#include "msg/Messenger.h"
+#include "messages/MOSDOp.h"
+#include "messages/MOSDOpReply.h"
+#include "messages/MOSDPing.h"
+#include "messages/MOSDRepOp.h"
+#include "messages/MOSDRepOpReply.h"
+#include "auth/DummyAuth.h"
+
+using namespace std;
+
+namespace {
+
+enum class MsgKind {
+  OP_WRITE,  // MOSDOp carrying data, small MOSDOpReply
+  OP_READ,   // small MOSDOp, MOSDOpReply carrying data
+  REPOP,     // MOSDRepOp carrying data, MOSDRepOpReply
+  PING,      // MOSDPing padded to size, MOSDPing reply
+};
+
+const char *kind_name(MsgKind k) {
+  switch (k) {
+  case MsgKind::OP_WRITE: return "osd_op";
+  case MsgKind::OP_READ: return "osd_op_reply";
+  case MsgKind::REPOP: return "osd_repop";
+  case MsgKind::PING: return "osd_ping";
+  }
+  return "???";
+}
+
+struct MixEntry {
+  MsgKind kind;
+  uint32_t size;
+  uint32_t weight;
+};
+
+// parse "kind:size:weight[,kind:size:weight...]"
+bool parse_mix(const string& spec, vector<MixEntry> *mix, ostream& err)
+{
+  static const map<string, MsgKind> kinds = {
+    {"osd_op", MsgKind::OP_WRITE},
+    {"write", MsgKind::OP_WRITE},
+    {"osd_op_reply", MsgKind::OP_READ},
+    {"read", MsgKind::OP_READ},
+    {"osd_repop", MsgKind::REPOP},
+    {"repop", MsgKind::REPOP},
+    {"osd_ping", MsgKind::PING},
+    {"ping", MsgKind::PING},
+  };
+  list<string> entries;
+  get_str_list(spec, ",", entries);
+  for (auto& e : entries) {
+    list<string> fields;
+    get_str_list(e, ":", fields);
+    if (fields.size() != 3) {
+      err << "bad mix entry '" << e << "', expected kind:size:weight";
+      return false;
+    }
+    auto f = fields.begin();
+    auto k = kinds.find(*f++);
+    if (k == kinds.end()) {
+      err << "unknown message kind in '" << e << "'";
+      return false;
+    }
+    MixEntry m;
+    m.kind = k->second;
+    m.size = atoi((f++)->c_str());
+    m.weight = atoi(f->c_str());
+    if (m.weight == 0) {
+      continue;
+    }
+    mix->push_back(m);
+  }
+  if (mix->empty()) {
+    err << "empty message mix";
+    return false;
+  }
+  return true;
+}
+
+// AUTH_NONE with a fixed connection secret so that the secure (AES-GCM)
+// frame path can be exercised without a monitor.
+class BenchAuthClientServer : public DummyAuthClientServer {
+  uint32_t con_mode;
+
+  static string make_secret() {
+    // 16 byte key + rx nonce + tx nonce
+    string s(16 + 2 * 12, '\0');
+    for (size_t i = 0; i < s.size(); ++i) {
+      s[i] = static_cast<char>(i * 7 + 1);
+    }
+    return s;
+  }
+
+public:
+  BenchAuthClientServer(CephContext *cct, uint32_t mode)
+    : DummyAuthClientServer(cct), con_mode(mode) {}
+
+  int get_auth_request(
+    Connection *con,
+    AuthConnectionMeta *auth_meta,
+    uint32_t *method,
+    std::vector<uint32_t> *preferred_modes,
+    bufferlist *out) override {
+    *method = CEPH_AUTH_NONE;
+    *preferred_modes = { con_mode };
+    return 0;
+  }
+
+  int handle_auth_done(
+    Connection *con,
+    AuthConnectionMeta *auth_meta,
+    uint64_t global_id,
+    uint32_t mode,
+    const bufferlist& bl,
+    CryptoKey *session_key,
+    std::string *connection_secret) override {
+    *connection_secret = make_secret();
+    return 0;
+  }
+
+  uint32_t pick_con_mode(
+    int peer_type,
+    uint32_t auth_method,
+    const std::vector<uint32_t>& preferred_modes) override {
+    return con_mode;
+  }
+
+  int handle_auth_request(
+    Connection *con,
+    AuthConnectionMeta *auth_meta,
+    bool more,
+    uint32_t auth_method,
+    const bufferlist& bl,
+    bufferlist *reply) override {
+    auth_meta->connection_secret = make_secret();
+    return 1;
+  }
+};
+
+class ServerDispatcher : public Dispatcher {
+  bufferlist read_data;
+  uuid_d fsid;
+
+public:
+  ServerDispatcher(uint32_t max_read) : Dispatcher(g_ceph_context) {
+    bufferptr ptr(max_read);
+    memset(ptr.c_str(), 0, max_read);
+    read_data.append(ptr);
+  }
+  bool ms_can_fast_dispatch_any() const override { return true; }
+  bool ms_can_fast_dispatch(const Message *m) const override {
+    switch (m->get_type()) {
+    case CEPH_MSG_OSD_OP:
+    case MSG_OSD_REPOP:
+    case MSG_OSD_PING:
+      return true;
+    default:
+      return false;
+    }
+  }
+  void ms_handle_fast_connect(Connection *con) override {}
+  void ms_handle_fast_accept(Connection *con) override {}
+  bool ms_dispatch(Message *m) override { return true; }
+  bool ms_handle_reset(Connection *con) override { return true; }
+  void ms_handle_remote_reset(Connection *con) override {}
+  bool ms_handle_refused(Connection *con) override { return false; }
+  int ms_handle_authentication(Connection *con) override { return 1; }
+
+  void ms_fast_dispatch(Message *m) override {
+    Message *reply = nullptr;
+    switch (m->get_type()) {
+    case CEPH_MSG_OSD_OP:
+      {
+	auto op = static_cast<MOSDOp*>(m);
+	op->finish_decode();
+	auto r = new MOSDOpReply(op, 0, 0, CEPH_OSD_FLAG_ACK, false);
+	if (!op->ops.empty() && op->ops[0].op.op == CEPH_OSD_OP_READ) {
+	  vector<OSDOp> out(op->ops.size());
+	  read_data.begin().copy(
+	    std::min<uint64_t>(op->ops[0].op.extent.length, read_data.length()),
+	    out[0].outdata);
+	  r->claim_op_out_data(out);
+	}
+	reply = r;
+      }
+      break;
+    case MSG_OSD_REPOP:
+      {
+	auto op = static_cast<MOSDRepOp*>(m);
+	op->finish_decode();
+	reply = new MOSDRepOpReply(op, pg_shard_t(0), 0, 0, 0,
+				   CEPH_OSD_FLAG_ONDISK);
+      }
+      break;
+    case MSG_OSD_PING:
+      {
+	auto ping = static_cast<MOSDPing*>(m);
+	auto now = ceph::signedspan(ceph::mono_clock::now().time_since_epoch());
+	reply = new MOSDPing(fsid, 0, MOSDPing::PING_REPLY,
+			     ping->ping_stamp, ping->mono_ping_stamp,
+			     now, 0, ping->min_message_size);
+	reply->set_tid(m->get_tid());
+      }
+      break;
+    }
+    if (reply) {
+      m->get_connection()->send_message(reply);
+    }
+    m->put();
+  }
+};
+
+struct LatStats {
+  vector<uint64_t> lat_ns;
+  uint64_t bytes = 0;
+
+  void merge(const LatStats& o) {
+    lat_ns.insert(lat_ns.end(), o.lat_ns.begin(), o.lat_ns.end());
+    bytes += o.bytes;
+  }
+};
+
+class ClientConnection : public Thread {
+  class ClientDispatcher : public Dispatcher {
+    ClientConnection *client;
+  public:
+    explicit ClientDispatcher(ClientConnection *c)
+      : Dispatcher(g_ceph_context), client(c) {}
+    bool ms_can_fast_dispatch_any() const override { return true; }
+    bool ms_can_fast_dispatch(const Message *m) const override {
+      switch (m->get_type()) {
+      case CEPH_MSG_OSD_OPREPLY:
+      case MSG_OSD_REPOPREPLY:
+      case MSG_OSD_PING:
+	return true;
+      default:
+	return false;
+      }
+    }
+    void ms_handle_fast_connect(Connection *con) override {}
+    void ms_handle_fast_accept(Connection *con) override {}
+    bool ms_dispatch(Message *m) override { return true; }
+    bool ms_handle_reset(Connection *con) override { return true; }
+    void ms_handle_remote_reset(Connection *con) override {}
+    bool ms_handle_refused(Connection *con) override { return false; }
+    int ms_handle_authentication(Connection *con) override { return 1; }
+    void ms_fast_dispatch(Message *m) override {
+      client->handle_reply(m);
+    }
+  };
+
+  struct Inflight {
+    MsgKind kind;
+    uint32_t size;
+    ceph::mono_time sent;
+  };
+
+  Messenger *msgr;
+  ConnectionRef conn;
+  const vector<MixEntry>& mix;
+  uint32_t depth;
+  uint64_t ops;
+  bufferlist data;
+  ClientDispatcher dispatcher;
+  std::mt19937 rng;
+  std::discrete_distribution<size_t> pick;
+  uuid_d fsid;
+
+  ceph::mutex lock = ceph::make_mutex("MessengerMix::ClientConnection::lock");
+  ceph::condition_variable cond;
+  ceph_tid_t last_tid = 0;
+  map<ceph_tid_t, Inflight> inflight;
+  uint64_t completed = 0;
+
+public:
+  map<MsgKind, LatStats> stats;
+
+  ClientConnection(Messenger *m, const entity_addrvec_t& addrs,
+		   const vector<MixEntry>& mix, uint32_t depth, uint64_t ops,
+		   uint32_t max_size, unsigned seed)
+    : msgr(m), mix(mix), depth(depth), ops(ops), dispatcher(this),
+      rng(seed) {
+    vector<double> weights;
+    for (auto& e : mix) {
+      weights.push_back(e.weight);
+    }
+    pick = std::discrete_distribution<size_t>(weights.begin(), weights.end());
+    bufferptr ptr(max_size);
+    memset(ptr.c_str(), 0, max_size);
+    data.append(ptr);
+    msgr->add_dispatcher_head(&dispatcher);
+    msgr->start();
+    conn = msgr->connect_to_osd(addrs);
+  }
+
+  Message *build(const MixEntry& e) {
+    static const object_t oid("object-name");
+    static const object_locator_t oloc(1, 1);
+    static const pg_t pgid;
+    hobject_t hobj(oid, oloc.key, CEPH_NOSNAP, pgid.ps(), pgid.pool(),
+		   oloc.nspace);
+    spg_t spgid(pgid);
+    bufferlist payload;
+    data.begin().copy(e.size, payload);
+    switch (e.kind) {
+    case MsgKind::OP_WRITE:
+      {
+	auto m = new MOSDOp(0, 0, hobj, spgid, 0, 0, 0);
+	m->write(0, e.size, payload);
+	return m;
+      }
+    case MsgKind::OP_READ:
+      {
+	auto m = new MOSDOp(0, 0, hobj, spgid, 0, CEPH_OSD_FLAG_READ, 0);
+	m->read(0, e.size);
+	return m;
+      }
+    case MsgKind::REPOP:
+      {
+	auto m = new MOSDRepOp(osd_reqid_t(), pg_shard_t(1), spgid, hobj,
+			       CEPH_OSD_FLAG_ONDISK, 0, 0, 0, eversion_t());
+	m->set_data(payload);
+	return m;
+      }
+    case MsgKind::PING:
+      {
+	auto now = ceph::signedspan(ceph::mono_clock::now().time_since_epoch());
+	return new MOSDPing(fsid, 0, MOSDPing::PING, ceph_clock_now(),
+			    now, now, 0, e.size);
+      }
+    }
+    return nullptr;
+  }
+
+  void handle_reply(Message *m) {
+    auto now = ceph::mono_clock::now();
+    std::lock_guard l{lock};
+    auto p = inflight.find(m->get_tid());
+    if (p != inflight.end()) {
+      auto& s = stats[p->second.kind];
+      s.lat_ns.push_back(
+	std::chrono::nanoseconds(now - p->second.sent).count());
+      s.bytes += p->second.size;
+      inflight.erase(p);
+      ++completed;
+      cond.notify_all();
+    }
+    m->put();
+  }
+
+  void *entry() override {
+    std::unique_lock locker{lock};
+    for (uint64_t i = 0; i < ops; ++i) {
+      cond.wait(locker, [this] { return inflight.size() < depth; });
+      const auto& e = mix[pick(rng)];
+      Message *m = build(e);
+      m->set_tid(++last_tid);
+      inflight[last_tid] = Inflight{e.kind, e.size, ceph::mono_clock::now()};
+      locker.unlock();
+      conn->send_message(m);
+      locker.lock();
+    }
+    cond.wait(locker, [this] { return inflight.empty(); });
+    return 0;
+  }
+
+  void shutdown() {
+    msgr->shutdown();
+    msgr->wait();
+  }
+};
+
+uint64_t cpu_time_ns()
+{
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000000ull +
+    (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1000ull;
+}
+
+uint64_t percentile(const vector<uint64_t>& sorted, double p)
+{
+  if (sorted.empty()) {
+    return 0;
+  }
+  size_t idx = std::min(sorted.size() - 1,
+			static_cast<size_t>(p * sorted.size()));
+  return sorted[idx];
+}
+
+void dump_stats(const char *name, LatStats& s, double secs)
+{
+  std::sort(s.lat_ns.begin(), s.lat_ns.end());
+  uint64_t n = s.lat_ns.size();
+  cout << "  " << std::left << std::setw(14) << name << std::right
+       << " msgs " << std::setw(9) << n
+       << " msgs/s " << std::setw(10) << std::fixed << std::setprecision(0)
+       << (n / secs)
+       << " MB/s " << std::setw(8) << std::setprecision(1)
+       << (s.bytes / secs / 1048576.0)
+       << " lat(us) p50 " << percentile(s.lat_ns, 0.50) / 1000
+       << " p90 " << percentile(s.lat_ns, 0.90) / 1000
+       << " p99 " << percentile(s.lat_ns, 0.99) / 1000
+       << " p99.9 " << percentile(s.lat_ns, 0.999) / 1000
+       << " max " << (n ? s.lat_ns.back() / 1000 : 0)
+       << std::endl;
+}
+
+void usage(const string &name)
+{
+  cout << "Usage: " << name << " [options]\n"
+       << "  --mix <kind:size:weight,...>  message mix (default "
+       << "osd_op:4096:60,osd_op_reply:4096:20,osd_repop:4096:15,osd_ping:0:5)\n"
+       << "       kind is one of osd_op, osd_op_reply, osd_repop, osd_ping\n"
+       << "  --connections <n>             client connections (default 4)\n"
+       << "  --depth <n>                   max inflight per connection (default 16)\n"
+       << "  --ops <n>                     messages per connection (default 100000)\n"
+       << "  --mode <crc|secure>           on-wire mode (default crc)\n"
+       << "  --bind <ip:port>              server address (default 127.0.0.1:10001)\n"
+       << std::endl;
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv)
+{
+  vector<const char*> args;
+  argv_to_vec(argc, (const char **)argv, args);
+
+  auto cct = global_init(NULL, args, CEPH_ENTITY_TYPE_CLIENT,
+			 CODE_ENVIRONMENT_UTILITY,
+			 CINIT_FLAG_NO_DEFAULT_CONFIG_FILE);
+  common_init_finish(g_ceph_context);
+  g_ceph_context->_conf.apply_changes(nullptr);
+
+  string mix_spec =
+    "osd_op:4096:60,osd_op_reply:4096:20,osd_repop:4096:15,osd_ping:0:5";
+  string mode_str = "crc";
+  string bind = "127.0.0.1:10001";
+  int connections = 4;
+  int depth = 16;
+  int ops = 100000;
+
+  std::ostringstream err;
+  string val;
+  for (auto i = args.begin(); i != args.end(); ) {
+    if (ceph_argparse_double_dash(args, i)) {
+      break;
+    } else if (ceph_argparse_flag(args, i, "-h", "--help", (char*)NULL)) {
+      usage(argv[0]);
+      return 0;
+    } else if (ceph_argparse_witharg(args, i, &val, "--mix", (char*)NULL)) {
+      mix_spec = val;
+    } else if (ceph_argparse_witharg(args, i, &val, "--mode", (char*)NULL)) {
+      mode_str = val;
+    } else if (ceph_argparse_witharg(args, i, &val, "--bind", (char*)NULL)) {
+      bind = val;
+    } else if (ceph_argparse_witharg(args, i, &connections, err,
+				     "--connections", (char*)NULL)) {
+    } else if (ceph_argparse_witharg(args, i, &depth, err,
+				     "--depth", (char*)NULL)) {
+    } else if (ceph_argparse_witharg(args, i, &ops, err,
+				     "--ops", (char*)NULL)) {
+    } else {
+      cerr << "unrecognized argument " << *i << std::endl;
+      usage(argv[0]);
+      return 1;
+    }
+    if (!err.str().empty()) {
+      cerr << err.str() << std::endl;
+      return 1;
+    }
+  }
+
+  vector<MixEntry> mix;
+  if (!parse_mix(mix_spec, &mix, err)) {
+    cerr << err.str() << std::endl;
+    return 1;
+  }
+  uint32_t con_mode;
+  if (mode_str == "crc") {
+    con_mode = CEPH_CON_MODE_CRC;
+  } else if (mode_str == "secure") {
+    con_mode = CEPH_CON_MODE_SECURE;
+  } else {
+    cerr << "unknown mode " << mode_str << std::endl;
+    return 1;
+  }
+  if (connections <= 0 || depth <= 0 || ops <= 0) {
+    usage(argv[0]);
+    return 1;
+  }
+  uint32_t max_size = 0;
+  for (auto& e : mix) {
+    max_size = std::max(max_size, e.size);
+  }
+
+  std::string msgr_type = g_ceph_context->_conf->ms_public_type.empty() ?
+    g_ceph_context->_conf.get_val<std::string>("ms_type") :
+    g_ceph_context->_conf->ms_public_type;
+
+  cout << " using ms-public-type " << msgr_type << std::endl;
+  cout << "       mode " << mode_str << std::endl;
+  cout << "       mix " << mix_spec << std::endl;
+  cout << "       connections " << connections << std::endl;
+  cout << "       depth " << depth << std::endl;
+  cout << "       ops per connection " << ops << std::endl;
+
+  BenchAuthClientServer auth(g_ceph_context, con_mode);
+  auth.auth_registry.refresh_config();
+
+  entity_addr_t addr;
+  if (!addr.parse(bind.c_str())) {
+    cerr << "unable to parse bind address " << bind << std::endl;
+    return 1;
+  }
+  addr.set_type(entity_addr_t::TYPE_MSGR2);
+  addr.set_nonce(0);
+
+  ServerDispatcher server_dispatcher(max_size);
+  Messenger *server = Messenger::create(g_ceph_context, msgr_type,
+					entity_name_t::OSD(0), "server", 0);
+  server->set_default_policy(Messenger::Policy::stateless_server(0));
+  server->set_auth_server(&auth);
+  server->set_auth_client(&auth);
+  if (server->bind(addr) < 0) {
+    cerr << "unable to bind to " << addr << std::endl;
+    return 1;
+  }
+  server->add_dispatcher_head(&server_dispatcher);
+  server->start();
+
+  vector<Messenger*> msgrs;
+  vector<std::unique_ptr<ClientConnection>> clients;
+  for (int i = 0; i < connections; ++i) {
+    Messenger *msgr = Messenger::create(g_ceph_context, msgr_type,
+					entity_name_t::CLIENT(i), "client",
+					getpid() + i);
+    msgr->set_default_policy(Messenger::Policy::lossless_client(0));
+    msgr->set_auth_client(&auth);
+    msgrs.push_back(msgr);
+    clients.emplace_back(new ClientConnection(
+      msgr, entity_addrvec_t(server->get_myaddrs().front()),
+      mix, depth, ops, max_size, i + 1));
+  }
+  // let the handshakes settle so setup cost is not measured
+  usleep(1000*1000);
+
+  uint64_t cpu_start = cpu_time_ns();
+  auto start = ceph::mono_clock::now();
+  for (auto& c : clients) {
+    c->create("mix_client");
+  }
+  for (auto& c : clients) {
+    c->join();
+  }
+  auto stop = ceph::mono_clock::now();
+  uint64_t cpu_used = cpu_time_ns() - cpu_start;
+  double secs = std::chrono::duration<double>(stop - start).count();
+
+  map<MsgKind, LatStats> merged;
+  LatStats total;
+  for (auto& c : clients) {
+    for (auto& [kind, s] : c->stats) {
+      merged[kind].merge(s);
+      total.merge(s);
+    }
+  }
+
+  uint64_t n = total.lat_ns.size();
+  cout << " Total msgs " << n << " run time " << std::fixed
+       << std::setprecision(3) << secs << "s" << std::endl;
+  cout << " CPU " << cpu_used / 1000 << "us, "
+       << std::setprecision(2) << (n ? cpu_used / 1000.0 / n : 0)
+       << "us per round trip (client + server)" << std::endl;
+  for (auto& [kind, s] : merged) {
+    dump_stats(kind_name(kind), s, secs);
+  }
+  dump_stats("total", total, secs);
+
+  for (auto& c : clients) {
+    c->shutdown();
+  }
+  clients.clear();
+  for (auto m : msgrs) {
+    delete m;
+  }
+  server->shutdown();
+  server->wait();
+  delete server;
+  return 0;
+}
@@ -130,6 +130,17 @@ static bufferlist make_bufferlist(size_t len, char c) {
   return bl;
 }
 
+// split bl into separate bufferptrs of at most frag_len bytes each
+static bufferlist make_fragmented(const bufferlist& bl, size_t frag_len) {
+  bufferlist out;
+  for (unsigned off = 0; off < bl.length(); off += frag_len) {
+    bufferlist frag;
+    frag.substr_of(bl, off, std::min<size_t>(frag_len, bl.length() - off));
+    out.push_back(buffer::copy(frag.c_str(), frag.length()));
+  }
+  return out;
+}
+
 bool disassemble_frame(FrameAssembler& frame_asm, bufferlist& frame_bl,
                        Tag& tag, segment_bls_t& segment_bls) {
   bufferlist preamble_bl;
@@ -200,8 +211,13 @@ protected:
               frame_asm.get_frame_onwire_len());
   }
 
-  void test_round_trip() {
-    auto tx_frame = TestFrame::Encode(m_header, m_front, m_middle, m_data);
+  void test_round_trip(size_t frag_len = 0) {
+    auto tx_frame = frag_len == 0 ?
+      TestFrame::Encode(m_header, m_front, m_middle, m_data) :
+      TestFrame::Encode(make_fragmented(m_header, frag_len),
+                        make_fragmented(m_front, frag_len),
+                        make_fragmented(m_middle, frag_len),
+                        make_fragmented(m_data, frag_len));
     auto onwire_bl = tx_frame.get_buffer(m_tx_frame_asm);
     check_frame_assembler(m_tx_frame_asm);
     EXPECT_EQ(m_tx_frame_asm.get_frame_onwire_len(), onwire_bl.length());
@@ -245,6 +261,13 @@ TEST_P(RoundTripTest, Reuse) {
   }
 }
 
+TEST_P(RoundTripTest, Fragmented) {
+  // mix of fragments below and above the secure mode staging threshold
+  for (size_t frag_len : {1, 7, 100, 1000, 5000}) {
+    test_round_trip(frag_len);
+  }
+}
+
 static const round_trip_instance_t round_trip_instances[] = {
   // first segment is empty
   { 0,   0,   0,   0, 1, {{32,  0,  17,   0,   0,  0},
@@ -7,6 +7,7 @@
 #include "test/librados/test_cxx.h"
 #include "gtest/gtest.h"
 #include <iostream>
+#include <optional>
 
 namespace neorados {
 
@@ -34,6 +35,117 @@ TEST_F(TestNeoRADOS, MakeWithLibRADOS) {
     boost::system::system_error);
 }
 
+class TestNeoRADOSBatch : public ::testing::Test {
+protected:
+  librados::Rados paleo_rados;
+  std::string pool_name = get_temp_pool_name();
+  std::optional<RADOS> rados;
+  IOContext ioc;
+
+  void SetUp() override {
+    ASSERT_EQ("", create_one_pool_pp(pool_name, paleo_rados));
+    rados.emplace(RADOS::make_with_librados(paleo_rados));
+    ioc = IOContext(paleo_rados.pool_lookup(pool_name.c_str()));
+  }
+  void TearDown() override {
+    rados.reset();
+    destroy_one_pool_pp(pool_name, paleo_rados);
+  }
+
+  std::string read(const Object& o) {
+    ReadOp op;
+    bufferlist bl;
+    op.read(0, 0, &bl);
+    rados->execute(o, ioc, std::move(op), nullptr, ceph::async::use_blocked);
+    return bl.to_str();
+  }
+};
+
+static std::pair<Object, WriteOp> append(const Object& o, std::string_view s)
+{
+  WriteOp op;
+  bufferlist bl;
+  bl.append(s);
+  op.append(std::move(bl));
+  return {o, std::move(op)};
+}
+
+TEST_F(TestNeoRADOSBatch, Empty) {
+  boost::system::error_code ec;
+  auto results = rados->execute_batch({}, ioc, ceph::async::use_blocked[ec]);
+  EXPECT_FALSE(ec);
+  EXPECT_TRUE(results.empty());
+}
+
+TEST_F(TestNeoRADOSBatch, Ordering) {
+  // ops on the same object are applied in the order given
+  std::vector<std::pair<Object, WriteOp>> ops;
+  const std::string payload = "abcdefghijklmnopqrstuvwxyz";
+  for (auto c : payload) {
+    ops.push_back(append("foo", std::string(1, c)));
+    ops.push_back(append("bar", std::string(1, c)));
+  }
+  boost::system::error_code ec;
+  auto results = rados->execute_batch(std::move(ops), ioc,
+				      ceph::async::use_blocked[ec]);
+  EXPECT_FALSE(ec);
+  ASSERT_EQ(payload.size() * 2, results.size());
+  for (const auto& r : results) {
+    EXPECT_FALSE(r);
+  }
+  EXPECT_EQ(payload, read("foo"));
+  EXPECT_EQ(payload, read("bar"));
+}
+
+TEST_F(TestNeoRADOSBatch, Results) {
+  {
+    WriteOp op;
+    op.create(true);
+    rados->execute("exists", ioc, std::move(op), ceph::async::use_blocked);
+  }
+
+  // the failure of one op doesn't stop the others, and is reported both
+  // at its own position and as the batch's error
+  std::vector<std::pair<Object, WriteOp>> ops;
+  ops.push_back(append("first", "a"));
+  {
+    WriteOp op;
+    op.create(true);
+    ops.emplace_back("exists", std::move(op));
+  }
+  ops.push_back(append("last", "b"));
+  {
+    WriteOp op;
+    op.assert_exists();
+    op.remove();
+    ops.emplace_back("missing", std::move(op));
+  }
+
+  boost::system::error_code ec;
+  auto results = rados->execute_batch(std::move(ops), ioc,
+				      ceph::async::use_blocked[ec]);
+  ASSERT_EQ(4u, results.size());
+  EXPECT_FALSE(results[0]);
+  EXPECT_EQ(boost::system::errc::file_exists, results[1]);
+  EXPECT_FALSE(results[2]);
+  EXPECT_EQ(boost::system::errc::no_such_file_or_directory, results[3]);
+  EXPECT_EQ(results[1], ec);
+
+  EXPECT_EQ("a", read("first"));
+  EXPECT_EQ("b", read("last"));
+
+  // without an error code to fill in, the first error is thrown
+  std::vector<std::pair<Object, WriteOp>> failing;
+  {
+    WriteOp op;
+    op.create(true);
+    failing.emplace_back("exists", std::move(op));
+  }
+  EXPECT_THROW(rados->execute_batch(std::move(failing), ioc,
+				    ceph::async::use_blocked),
+	       boost::system::system_error);
+}
+
 } // namespace neorados
 
 int main(int argc, char **argv) {
@@ -93,7 +93,7 @@ TEST(Decompress, FixupRangePartial)
   blocks.emplace_back(compression_block{24, 18, 6});
 
   const bool partial = true;
-  RGWGetObj_Decompress decompress(g_ceph_context, &cs_info, partial, &cb);
+  RGWGetObj_Decompress decompress(g_ceph_context, &cs_info, partial, &cb, null_yield);
 
   // test translation from logical ranges to compressed ranges
   ASSERT_EQ(range_t(0, 5), fixup_range(&decompress, 0, 1));
@@ -122,7 +122,7 @@ TEST(Compress, LimitedChunkSize)
     bl.append(bp);
 
     ut_put_sink c_sink;
-    RGWPutObj_Compress compressor(g_ceph_context, plugin, &c_sink);
+    RGWPutObj_Compress compressor(g_ceph_context, plugin, &c_sink, null_yield);
     compressor.process(std::move(bl), 0);
     compressor.process({}, s); // flush
 
@@ -133,7 +133,7 @@ TEST(Compress, LimitedChunkSize)
     cs_info.blocks = move(compressor.get_compression_blocks());
 
     ut_get_sink_size d_sink;
-    RGWGetObj_Decompress decompress(g_ceph_context, &cs_info, false, &d_sink);
+    RGWGetObj_Decompress decompress(g_ceph_context, &cs_info, false, &d_sink, null_yield);
 
     off_t f_begin = 0;
     off_t f_end = s - 1;
@@ -154,7 +154,7 @@ TEST(Compress, BillionZeros)
   ut_put_sink c_sink;
   plugin = Compressor::create(g_ceph_context, Compressor::COMP_ALG_ZLIB);
   ASSERT_NE(plugin.get(), nullptr);
-  RGWPutObj_Compress compressor(g_ceph_context, plugin, &c_sink);
+  RGWPutObj_Compress compressor(g_ceph_context, plugin, &c_sink, null_yield);
 
   constexpr size_t size = 1000000;
   bufferptr bp(size);
@@ -172,7 +172,7 @@ TEST(Compress, BillionZeros)
   cs_info.blocks = move(compressor.get_compression_blocks());
 
   ut_get_sink d_sink;
-  RGWGetObj_Decompress decompress(g_ceph_context, &cs_info, false, &d_sink);
+  RGWGetObj_Decompress decompress(g_ceph_context, &cs_info, false, &d_sink, null_yield);
 
   off_t f_begin = 0;
   off_t f_end = size*1000 - 1;
@@ -184,3 +184,99 @@ TEST(Compress, BillionZeros)
 
   ASSERT_EQ(d_sink.get_sink().length() , size*1000);
 }
+
+TEST(Compress, Offload)
+{
+  // parts compressed on the worker pool come back in order
+  g_ceph_context->_conf.set_val_or_die("rgw_put_obj_offload_threads", "4");
+
+  CompressorRef plugin;
+  ut_put_sink c_sink;
+  plugin = Compressor::create(g_ceph_context, Compressor::COMP_ALG_ZLIB);
+  ASSERT_NE(plugin.get(), nullptr);
+  RGWPutObj_Compress compressor(g_ceph_context, plugin, &c_sink, null_yield);
+
+  constexpr size_t size = 65536;
+  constexpr int parts = 64;
+  bufferlist orig;
+  for (int i = 0; i < parts; i++) {
+    bufferlist bl;
+    bl.append(std::string(size, 'a' + i % 26));
+    orig.append(bl);
+    ASSERT_EQ(0, compressor.process(std::move(bl), size*i));
+  }
+  ASSERT_EQ(0, compressor.process({}, size*parts)); // flush
+
+  RGWCompressionInfo cs_info;
+  cs_info.compression_type = plugin->get_type_name();
+  cs_info.orig_size = size*parts;
+  cs_info.compressor_message = compressor.get_compressor_message();
+  cs_info.blocks = move(compressor.get_compression_blocks());
+  ASSERT_EQ(cs_info.blocks.size(), (size_t)parts);
+
+  ut_get_sink d_sink;
+  RGWGetObj_Decompress decompress(g_ceph_context, &cs_info, false, &d_sink, null_yield);
+
+  off_t f_begin = 0;
+  off_t f_end = size*parts - 1;
+  decompress.fixup_range(f_begin, f_end);
+
+  decompress.handle_data(c_sink.get_sink(), 0, c_sink.get_sink().length());
+  bufferlist empty;
+  decompress.handle_data(empty, 0, 0);
+
+  ASSERT_TRUE(d_sink.get_sink().contents_equal(orig));
+
+  g_ceph_context->_conf.set_val_or_die("rgw_put_obj_offload_threads", "0");
+}
+
+TEST(Compress, BlockSize)
+{
+  // smaller blocks, decompressed on the worker pool for a ranged read
+  g_ceph_context->_conf.set_val_or_die("rgw_compression_block_size", "4096");
+  g_ceph_context->_conf.set_val_or_die("rgw_put_obj_offload_threads", "4");
+
+  CompressorRef plugin;
+  ut_put_sink c_sink;
+  plugin = Compressor::create(g_ceph_context, Compressor::COMP_ALG_ZLIB);
+  ASSERT_NE(plugin.get(), nullptr);
+  RGWPutObj_Compress compressor(g_ceph_context, plugin, &c_sink, null_yield);
+
+  constexpr size_t size = 65536;
+  constexpr int parts = 3;
+  bufferlist orig;
+  for (int i = 0; i < parts; i++) {
+    bufferlist bl;
+    bl.append(std::string(size, 'a' + i));
+    orig.append(bl);
+    ASSERT_EQ(0, compressor.process(std::move(bl), size*i));
+  }
+  ASSERT_EQ(0, compressor.process({}, size*parts)); // flush
+
+  RGWCompressionInfo cs_info;
+  cs_info.compression_type = plugin->get_type_name();
+  cs_info.orig_size = size*parts;
+  cs_info.compressor_message = compressor.get_compressor_message();
+  cs_info.blocks = move(compressor.get_compression_blocks());
+  ASSERT_EQ(cs_info.blocks.size(), (size_t)(size*parts/4096));
+
+  ut_get_sink d_sink;
+  RGWGetObj_Decompress decompress(g_ceph_context, &cs_info, true, &d_sink, null_yield);
+
+  constexpr off_t ofs = 5000;
+  constexpr off_t end = 70000;
+  off_t f_begin = ofs;
+  off_t f_end = end;
+  decompress.fixup_range(f_begin, f_end);
+
+  decompress.handle_data(c_sink.get_sink(), f_begin, f_end - f_begin + 1);
+  bufferlist empty;
+  decompress.handle_data(empty, 0, 0);
+
+  bufferlist expected;
+  expected.substr_of(orig, ofs, end - ofs + 1);
+  ASSERT_TRUE(d_sink.get_sink().contents_equal(expected));
+
+  g_ceph_context->_conf.set_val_or_die("rgw_put_obj_offload_threads", "0");
+  g_ceph_context->_conf.set_val_or_die("rgw_compression_block_size", "0");
+}
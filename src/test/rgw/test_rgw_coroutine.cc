@@ -0,0 +1,192 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+#include "rgw/rgw_coroutine.h"
+
+#include <set>
+#include <thread>
+
+#include "global/global_context.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+struct Result {
+  std::thread::id tid;
+  bool done = false;
+};
+
+/* sleeps a few times, so that its stack goes through the io completions
+ * of the manager, then records the thread it finished on */
+class WaitCR : public RGWCoroutine {
+  Result *result;
+  int ret;
+  int i = 0;
+public:
+  WaitCR(CephContext *cct, Result *result, int ret = 0)
+    : RGWCoroutine(cct), result(result), ret(ret) {}
+
+  int operate() override {
+    reenter(this) {
+      for (i = 0; i < 3; ++i) {
+        yield wait(utime_t(0, 1000000));
+      }
+      result->tid = std::this_thread::get_id();
+      result->done = true;
+      if (ret < 0) {
+        return set_cr_error(ret);
+      }
+      return set_cr_done();
+    }
+    return 0;
+  }
+};
+
+/* spawns its children, either on its own thread or independently, and
+ * fails if any of them fails */
+class SpawnCR : public RGWCoroutine {
+  Result *result;
+  std::vector<RGWCoroutine*> children;
+  bool independent;
+  int errors = 0;
+public:
+  SpawnCR(CephContext *cct, Result *result,
+          std::vector<RGWCoroutine*> children, bool independent)
+    : RGWCoroutine(cct), result(result), children(std::move(children)),
+      independent(independent) {}
+
+  int operate() override {
+    reenter(this) {
+      result->tid = std::this_thread::get_id();
+      yield {
+        for (auto cr : children) {
+          if (independent) {
+            spawn_independent(cr, false);
+          } else {
+            spawn(cr, false);
+          }
+        }
+      }
+      drain_all_cb([this](uint64_t stack_id, int r) {
+                     if (r < 0) {
+                       ++errors;
+                     }
+                     return 0;
+                   });
+      if (errors > 0) {
+        return set_cr_error(-EIO);
+      }
+      result->done = true;
+      return set_cr_done();
+    }
+    return 0;
+  }
+};
+
+std::vector<RGWCoroutine*> make_waits(std::vector<Result>& results)
+{
+  std::vector<RGWCoroutine*> crs;
+  for (auto& r : results) {
+    crs.push_back(new WaitCR(g_ceph_context, &r));
+  }
+  return crs;
+}
+
+} // anonymous namespace
+
+TEST(RGWCoroutinesManager, run_parallel)
+{
+  RGWCoroutinesManager mgr(g_ceph_context, nullptr);
+  Result parent;
+  std::vector<Result> results(8);
+  auto cr = new SpawnCR(g_ceph_context, &parent, make_waits(results), true);
+
+  ASSERT_EQ(0, mgr.run(cr, 4));
+  EXPECT_TRUE(parent.done);
+
+  std::set<std::thread::id> tids;
+  for (auto& r : results) {
+    EXPECT_TRUE(r.done);
+    EXPECT_NE(std::this_thread::get_id(), r.tid);
+    tids.insert(r.tid);
+  }
+  // independent stacks are spread over the worker threads
+  EXPECT_EQ(4u, tids.size());
+}
+
+TEST(RGWCoroutinesManager, run_parallel_spawn)
+{
+  RGWCoroutinesManager mgr(g_ceph_context, nullptr);
+  Result parent;
+  std::vector<Result> results(8);
+  auto cr = new SpawnCR(g_ceph_context, &parent, make_waits(results), false);
+
+  ASSERT_EQ(0, mgr.run(cr, 4));
+  EXPECT_TRUE(parent.done);
+  // plain spawn() keeps the children on the parent's thread
+  for (auto& r : results) {
+    EXPECT_TRUE(r.done);
+    EXPECT_EQ(parent.tid, r.tid);
+  }
+}
+
+TEST(RGWCoroutinesManager, run_parallel_nested)
+{
+  RGWCoroutinesManager mgr(g_ceph_context, nullptr);
+  Result parent;
+  std::vector<Result> shards(4);
+  std::vector<std::vector<Result>> results(4, std::vector<Result>(4));
+  std::vector<RGWCoroutine*> crs;
+  for (size_t i = 0; i < shards.size(); ++i) {
+    crs.push_back(new SpawnCR(g_ceph_context, &shards[i],
+                              make_waits(results[i]), false));
+  }
+  auto cr = new SpawnCR(g_ceph_context, &parent, std::move(crs), true);
+
+  ASSERT_EQ(0, mgr.run(cr, 2));
+  EXPECT_TRUE(parent.done);
+  // descendants inherit the thread of their independent ancestor
+  for (size_t i = 0; i < shards.size(); ++i) {
+    EXPECT_TRUE(shards[i].done);
+    for (auto& r : results[i]) {
+      EXPECT_TRUE(r.done);
+      EXPECT_EQ(shards[i].tid, r.tid);
+    }
+  }
+}
+
+TEST(RGWCoroutinesManager, run_parallel_error)
+{
+  RGWCoroutinesManager mgr(g_ceph_context, nullptr);
+  Result parent;
+  std::vector<Result> results(4);
+  auto crs = make_waits(results);
+  Result failed;
+  crs.push_back(new WaitCR(g_ceph_context, &failed, -ENOENT));
+  auto cr = new SpawnCR(g_ceph_context, &parent, std::move(crs), true);
+
+  // the error of a child on another thread reaches the parent
+  EXPECT_EQ(-EIO, mgr.run(cr, 4));
+  EXPECT_FALSE(parent.done);
+  EXPECT_TRUE(failed.done);
+  for (auto& r : results) {
+    EXPECT_TRUE(r.done);
+  }
+}
+
+TEST(RGWCoroutinesManager, run_single_thread)
+{
+  RGWCoroutinesManager mgr(g_ceph_context, nullptr);
+  Result parent;
+  std::vector<Result> results(4);
+  auto cr = new SpawnCR(g_ceph_context, &parent, make_waits(results), true);
+
+  // with one thread, independent stacks run on the caller's thread
+  ASSERT_EQ(0, mgr.run(cr));
+  EXPECT_TRUE(parent.done);
+  EXPECT_EQ(std::this_thread::get_id(), parent.tid);
+  for (auto& r : results) {
+    EXPECT_TRUE(r.done);
+    EXPECT_EQ(std::this_thread::get_id(), r.tid);
+  }
+}
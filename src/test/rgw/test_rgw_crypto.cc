@@ -710,7 +710,7 @@ TEST(TestRGWCrypto, verify_RGWPutObj_BlockEncrypt_chunks)
     auto cbc = AES_256_CBC_create(g_ceph_context, &key[0], 32);
     ASSERT_NE(cbc.get(), nullptr);
     RGWPutObj_BlockEncrypt encrypt(g_ceph_context, &put_sink,
-                                   std::move(cbc) );
+                                   std::move(cbc), null_yield);
 
     off_t test_size = (r/5)*(r+7)*(r+13)*(r+101)*(r*103) % (test_range - 1) + 1;
     off_t pos = 0;
@@ -770,7 +770,8 @@ TEST(TestRGWCrypto, verify_Encrypt_Decrypt)
 
     ut_put_sink put_sink;
     RGWPutObj_BlockEncrypt encrypt(g_ceph_context, &put_sink,
-				   AES_256_CBC_create(g_ceph_context, &key[0], 32) );
+				   AES_256_CBC_create(g_ceph_context, &key[0], 32),
+				   null_yield);
     bufferlist bl;
     bl.append((char*)test_in, test_size);
     encrypt.process(std::move(bl), 0);
@@ -0,0 +1,162 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+#include <unistd.h>
+
+#include "rgw/rgw_datacache.h"
+#include "global/global_context.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+// records the completion of a single op
+struct TestAio : rgw::Aio {
+  ceph::mutex lock = ceph::make_mutex("TestAio");
+  ceph::condition_variable cond;
+  bool done = false;
+
+  rgw::AioResultList get(const RGWSI_RADOS::Obj& obj, OpFunc&& f,
+			 uint64_t cost, uint64_t id) override {
+    return {};
+  }
+  void put(rgw::AioResult& r) override {
+    std::lock_guard l{lock};
+    done = true;
+    cond.notify_all();
+  }
+  rgw::AioResultList poll() override { return {}; }
+  rgw::AioResultList wait() override { return {}; }
+  rgw::AioResultList drain() override { return {}; }
+
+  void run(rgw::Aio::OpFunc&& op, rgw::AioResult& r) {
+    std::move(op)(this, r);
+    std::unique_lock l{lock};
+    cond.wait(l, [this] { return done; });
+  }
+};
+
+// stands in for the rados read
+rgw::Aio::OpFunc rados_read(bool* called)
+{
+  return [called] (rgw::Aio* aio, rgw::AioResult& r) {
+    *called = true;
+    r.result = 0;
+    r.data.append("rados");
+    aio->put(r);
+  };
+}
+
+struct DataCache : ::testing::Test {
+  std::string dir;
+  std::unique_ptr<RGWDataCache> cache;
+
+  void SetUp() override {
+    char tmpl[] = "/tmp/test_rgw_datacache.XXXXXX";
+    ASSERT_NE(nullptr, ::mkdtemp(tmpl));
+    dir = tmpl;
+    auto& conf = g_ceph_context->_conf;
+    conf.set_val_or_die("rgw_datacache_path", dir);
+    conf.set_val_or_die("rgw_datacache_size", "8");
+    conf.set_val_or_die("rgw_datacache_threads", "1");
+    cache = std::make_unique<RGWDataCache>(g_ceph_context);
+    ASSERT_EQ(0, cache->start());
+  }
+  void TearDown() override {
+    cache.reset();
+    EXPECT_EQ(0, ::system(("rm -rf " + dir).c_str()));
+  }
+
+  // wait for queued writes to land
+  bool wait_for(const std::string& key) {
+    for (int i = 0; i < 1000; ++i) {
+      bool called = false;
+      auto op = rados_read(&called);
+      if (cache->get(key, op, null_yield)) {
+	TestAio aio;
+	rgw::AioResultEntry r;
+	aio.run(std::move(op), r);
+	return true;
+      }
+      ::usleep(1000);
+    }
+    return false;
+  }
+};
+
+const rgw_raw_obj obj{rgw_pool("data"), "tail_1"};
+
+} // anonymous namespace
+
+TEST_F(DataCache, Miss)
+{
+  bool called = false;
+  auto op = rados_read(&called);
+  EXPECT_FALSE(cache->get(RGWDataCache::get_key(obj, 0, 4), op, null_yield));
+}
+
+TEST_F(DataCache, Hit)
+{
+  const auto key = RGWDataCache::get_key(obj, 0, 4);
+  bufferlist bl;
+  bl.append("data");
+  cache->put(key, bl);
+  ASSERT_TRUE(wait_for(key));
+
+  bool called = false;
+  auto op = rados_read(&called);
+  ASSERT_TRUE(cache->get(key, op, null_yield));
+  TestAio aio;
+  rgw::AioResultEntry r;
+  aio.run(std::move(op), r);
+  EXPECT_FALSE(called);
+  EXPECT_EQ(0, r.result);
+  EXPECT_EQ("data", r.data.to_str());
+
+  // a different range of the same object is a different chunk
+  op = rados_read(&called);
+  EXPECT_FALSE(cache->get(RGWDataCache::get_key(obj, 4, 4), op, null_yield));
+}
+
+TEST_F(DataCache, Evict)
+{
+  const auto key1 = RGWDataCache::get_key(obj, 0, 4);
+  const auto key2 = RGWDataCache::get_key(obj, 4, 4);
+  const auto key3 = RGWDataCache::get_key(obj, 8, 4);
+  bufferlist bl;
+  bl.append("data");
+  cache->put(key1, bl);
+  ASSERT_TRUE(wait_for(key1));
+  cache->put(key2, bl);
+  ASSERT_TRUE(wait_for(key2));
+  cache->put(key3, bl); // over capacity, the oldest goes
+  ASSERT_TRUE(wait_for(key3));
+
+  bool called = false;
+  auto op = rados_read(&called);
+  EXPECT_FALSE(cache->get(key1, op, null_yield));
+}
+
+TEST_F(DataCache, Fallback)
+{
+  const auto key = RGWDataCache::get_key(obj, 0, 4);
+  bufferlist bl;
+  bl.append("data");
+  cache->put(key, bl);
+  ASSERT_TRUE(wait_for(key));
+
+  // lose the file behind the cache's back
+  ASSERT_EQ(0, ::system(("rm -f " + dir + "/*").c_str()));
+
+  bool called = false;
+  auto op = rados_read(&called);
+  ASSERT_TRUE(cache->get(key, op, null_yield));
+  TestAio aio;
+  rgw::AioResultEntry r;
+  aio.run(std::move(op), r);
+  EXPECT_TRUE(called);
+  EXPECT_EQ("rados", r.data.to_str());
+
+  // and the entry is gone
+  op = rados_read(&called);
+  EXPECT_FALSE(cache->get(key, op, null_yield));
+}
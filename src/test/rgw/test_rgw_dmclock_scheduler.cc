@@ -16,6 +16,7 @@
 
 #include "rgw/rgw_dmclock_sync_scheduler.h"
 #include "rgw/rgw_dmclock_async_scheduler.h"
+#include "rgw/rgw_dmclock_tenant.h"
 
 #include <optional>
 #include <boost/asio/spawn.hpp>
@@ -425,4 +426,118 @@ TEST(Queue, SpawnAsyncRequest)
   EXPECT_TRUE(context.stopped());
 }
 
+TEST(TenantQueue, Tags)
+{
+  auto& conf = g_ceph_context->_conf;
+  conf.set_val_or_die("rgw_dmclock_user_lim", "100");
+  conf.set_val_or_die("rgw_dmclock_tenant_tags",
+                      "user:alice=1,2,10 bucket:t/b=0,1,5,1000 bogus=1,1,1");
+  TenantConfig config(g_ceph_context);
+
+  auto tags = config.get_tags("user:alice");
+  EXPECT_EQ(1, tags.res);
+  EXPECT_EQ(2, tags.wgt);
+  EXPECT_EQ(10, tags.lim);
+  EXPECT_EQ(0, tags.bytes_lim);
+  EXPECT_EQ(100, config.get_tags("user:bob").lim);
+  EXPECT_EQ(1000, config.get_tags("bucket:t/b").bytes_lim);
+  EXPECT_EQ(0, config.get_tags("bucket:t/c").lim);
+
+  // other gateways use part of the limits, but never more than their share
+  std::map<std::string, RemoteUsage> remote;
+  remote["user:alice"] = RemoteUsage{4, 0, 1};
+  remote["user:bob"] = RemoteUsage{90, 0, 3};
+  config.set_remote(std::move(remote));
+  EXPECT_EQ(6, config.get_tags("user:alice").lim);
+  EXPECT_EQ(25, config.get_tags("user:bob").lim);
+  EXPECT_EQ(6, config(std::string("user:alice"))->limit);
+
+  config.set_remote({});
+  EXPECT_EQ(10, config.get_tags("user:alice").lim);
+  EXPECT_EQ(100, config.get_tags("user:bob").lim);
+
+  conf.set_val_or_die("rgw_dmclock_user_lim", "0");
+  conf.set_val_or_die("rgw_dmclock_tenant_tags", "");
+}
+
+TEST(TenantQueue, RateLimit)
+{
+  auto& conf = g_ceph_context->_conf;
+  conf.set_val_or_die("rgw_dmclock_tenant_tags", "user:alice=0,1,1");
+  boost::asio::io_context context;
+
+  spawn::spawn(context, [&] (spawn::yield_context yield) {
+    AsyncTenantScheduler queue(g_ceph_context, context);
+    optional_yield y{context, yield};
+
+    EXPECT_EQ(0, queue.schedule_request("alice", "", y));
+    // over the limit of 1 op/s
+    EXPECT_EQ(-EAGAIN, queue.schedule_request("alice", "", y));
+    // doesn't hold up anyone else
+    EXPECT_EQ(0, queue.schedule_request("bob", "t/b", y));
+
+    queue.request_complete("alice", "", 0);
+    queue.request_complete("bob", "t/b", 0);
+  });
+
+  context.poll();
+  EXPECT_TRUE(context.stopped());
+  conf.set_val_or_die("rgw_dmclock_tenant_tags", "");
+}
+
+TEST(TenantQueue, BytesLimit)
+{
+  auto& conf = g_ceph_context->_conf;
+  conf.set_val_or_die("rgw_dmclock_bucket_bytes_lim", "1000");
+  boost::asio::io_context context;
+
+  spawn::spawn(context, [&] (spawn::yield_context yield) {
+    AsyncTenantScheduler queue(g_ceph_context, context);
+    optional_yield y{context, yield};
+
+    EXPECT_EQ(0, queue.schedule_request("alice", "t/b", y));
+    queue.request_complete("alice", "t/b", 5000);
+    // the bucket is in debt, its user isn't
+    EXPECT_EQ(-EAGAIN, queue.schedule_request("alice", "t/b", y));
+    EXPECT_EQ(0, queue.schedule_request("alice", "t/c", y));
+    queue.request_complete("alice", "t/c", 0);
+  });
+
+  context.poll();
+  EXPECT_TRUE(context.stopped());
+  conf.set_val_or_die("rgw_dmclock_bucket_bytes_lim", "0");
+}
+
+TEST(TenantQueue, MaxRequests)
+{
+  auto& conf = g_ceph_context->_conf;
+  conf.set_val_or_die("rgw_dmclock_tenant_max_requests", "2");
+  boost::asio::io_context context;
+  AsyncTenantScheduler queue(g_ceph_context, context);
+
+  // more requests than max_requests, each through both stages
+  constexpr int num_requests = 8;
+  int completed = 0;
+  for (int i = 0; i < num_requests; ++i) {
+    spawn::spawn(context, [&, i] (spawn::yield_context yield) {
+      optional_yield y{context, yield};
+      const auto user = "user" + std::to_string(i);
+      EXPECT_EQ(0, queue.schedule_request(user, "t/b", y));
+      // hold on to the request while the others are scheduled
+      boost::asio::post(context, yield);
+      queue.request_complete(user, "t/b", 0);
+      ++completed;
+    });
+  }
+
+  context.run_for(std::chrono::seconds(10));
+  EXPECT_EQ(num_requests, completed);
+  EXPECT_TRUE(context.stopped());
+  if (!context.stopped()) {
+    queue.cancel();
+    context.run();
+  }
+  conf.set_val_or_die("rgw_dmclock_tenant_max_requests", "0");
+}
+
 } // namespace rgw::dmclock
@@ -0,0 +1,197 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+#include "rgw/rgw_lc_checkpoint.h"
+
+#include "global/global_context.h"
+#include "test/librados/test_cxx.h"
+#include "gtest/gtest.h"
+
+// creates a rados client and temporary pool
+struct RadosEnv : public ::testing::Environment {
+  static std::optional<std::string> pool_name;
+ public:
+  static std::optional<librados::Rados> rados;
+
+  void SetUp() override {
+    rados.emplace();
+    // create pool
+    std::string name = get_temp_pool_name();
+    ASSERT_EQ("", create_one_pool_pp(name, *rados));
+    pool_name = name;
+  }
+  void TearDown() override {
+    if (pool_name) {
+      ASSERT_EQ(0, destroy_one_pool_pp(*pool_name, *rados));
+    }
+    rados.reset();
+  }
+
+  static int ioctx_create(librados::IoCtx& ioctx) {
+    return rados->ioctx_create(pool_name->c_str(), ioctx);
+  }
+};
+std::optional<std::string> RadosEnv::pool_name;
+std::optional<librados::Rados> RadosEnv::rados;
+
+auto *const rados_env = ::testing::AddGlobalTestEnvironment(new RadosEnv);
+
+TEST(LCShardProgress, in_order)
+{
+  LCShardProgress progress;
+  rgw_obj_key marker;
+  bool complete = false;
+  EXPECT_FALSE(progress.get_marker(&marker, &complete));
+
+  auto p1 = progress.add_listed();
+  auto p2 = progress.add_listed();
+  EXPECT_EQ(p1, p2);
+  progress.page_done(rgw_obj_key("b"), false);
+  EXPECT_FALSE(progress.get_marker(&marker, &complete));
+
+  progress.add_processed(p1);
+  EXPECT_FALSE(progress.get_marker(&marker, &complete));
+  progress.add_processed(p2);
+  ASSERT_TRUE(progress.get_marker(&marker, &complete));
+  EXPECT_EQ("b", marker.name);
+  EXPECT_FALSE(complete);
+  EXPECT_FALSE(progress.get_marker(&marker, &complete));
+
+  auto p3 = progress.add_listed();
+  EXPECT_NE(p1, p3);
+  progress.page_done(rgw_obj_key("c"), true);
+  progress.add_processed(p3);
+  ASSERT_TRUE(progress.get_marker(&marker, &complete));
+  EXPECT_EQ("c", marker.name);
+  EXPECT_TRUE(complete);
+}
+
+TEST(LCShardProgress, out_of_order)
+{
+  LCShardProgress progress;
+  rgw_obj_key marker;
+  bool complete = false;
+
+  // two pages of two entries
+  auto a = progress.add_listed();
+  auto b = progress.add_listed();
+  progress.page_done(rgw_obj_key("b"), false);
+  auto c = progress.add_listed();
+  auto d = progress.add_listed();
+  progress.page_done(rgw_obj_key("d"), true);
+
+  // as many entries as the first page processed, but from the second page
+  progress.add_processed(c);
+  progress.add_processed(d);
+  EXPECT_FALSE(progress.get_marker(&marker, &complete));
+
+  progress.add_processed(a);
+  EXPECT_FALSE(progress.get_marker(&marker, &complete));
+
+  // the last entry of the first page drains both pages
+  progress.add_processed(b);
+  ASSERT_TRUE(progress.get_marker(&marker, &complete));
+  EXPECT_EQ("d", marker.name);
+  EXPECT_TRUE(complete);
+}
+
+TEST(LCShardProgress, listed_page)
+{
+  LCShardProgress progress;
+  rgw_obj_key marker;
+  bool complete = false;
+
+  // a processed page doesn't advance the marker before it's fully listed
+  auto a = progress.add_listed();
+  progress.add_processed(a);
+  EXPECT_FALSE(progress.get_marker(&marker, &complete));
+  progress.page_done(rgw_obj_key("a"), false);
+  ASSERT_TRUE(progress.get_marker(&marker, &complete));
+  EXPECT_EQ("a", marker.name);
+  EXPECT_FALSE(complete);
+
+  // an empty last page completes the shard at the same marker
+  progress.page_done(rgw_obj_key(), true);
+  ASSERT_TRUE(progress.get_marker(&marker, &complete));
+  EXPECT_EQ("a", marker.name);
+  EXPECT_TRUE(complete);
+}
+
+class LCCheckpointTest : public ::testing::Test {
+ protected:
+  static librados::IoCtx ioctx;
+
+  static void SetUpTestSuite() {
+    ASSERT_EQ(0, RadosEnv::ioctx_create(ioctx));
+  }
+  static void TearDownTestSuite() {
+    ioctx.close();
+  }
+
+  // use the test's name as the bucket marker so different tests don't
+  // conflict
+  rgw_bucket get_test_bucket() const {
+    rgw_bucket bucket;
+    bucket.name = "bucket";
+    bucket.marker =
+      ::testing::UnitTest::GetInstance()->current_test_info()->name();
+    return bucket;
+  }
+};
+librados::IoCtx LCCheckpointTest::ioctx;
+
+TEST_F(LCCheckpointTest, save_load)
+{
+  const auto bucket = get_test_bucket();
+  {
+    LCCheckpoint checkpoint(g_ceph_context, ioctx, bucket, 2);
+    ASSERT_EQ(0, checkpoint.load());
+    EXPECT_EQ(nullptr, checkpoint.get("rule", 0));
+    ASSERT_EQ(0, checkpoint.save("rule", 0, rgw_obj_key("a"), false));
+    ASSERT_EQ(0, checkpoint.save("rule", 1, rgw_obj_key("b"), true));
+    ASSERT_EQ(0, checkpoint.save("other", 1, rgw_obj_key("c"), false));
+  }
+  {
+    LCCheckpoint checkpoint(g_ceph_context, ioctx, bucket, 2);
+    ASSERT_EQ(0, checkpoint.load());
+    auto cp = checkpoint.get("rule", 0);
+    ASSERT_NE(nullptr, cp);
+    EXPECT_EQ("a", cp->marker.name);
+    EXPECT_FALSE(cp->complete);
+    cp = checkpoint.get("rule", 1);
+    ASSERT_NE(nullptr, cp);
+    EXPECT_EQ("b", cp->marker.name);
+    EXPECT_TRUE(cp->complete);
+    cp = checkpoint.get("other", 1);
+    ASSERT_NE(nullptr, cp);
+    EXPECT_EQ("c", cp->marker.name);
+    EXPECT_EQ(nullptr, checkpoint.get("other", 0));
+  }
+}
+
+TEST_F(LCCheckpointTest, resharded)
+{
+  const auto bucket = get_test_bucket();
+  {
+    LCCheckpoint checkpoint(g_ceph_context, ioctx, bucket, 2);
+    ASSERT_EQ(0, checkpoint.save("rule", 0, rgw_obj_key("a"), false));
+  }
+  // markers of a different shard count are ignored
+  LCCheckpoint checkpoint(g_ceph_context, ioctx, bucket, 4);
+  ASSERT_EQ(0, checkpoint.load());
+  EXPECT_EQ(nullptr, checkpoint.get("rule", 0));
+}
+
+TEST_F(LCCheckpointTest, remove)
+{
+  const auto bucket = get_test_bucket();
+  LCCheckpoint checkpoint(g_ceph_context, ioctx, bucket, 1);
+  // removing a missing checkpoint succeeds
+  ASSERT_EQ(0, checkpoint.remove());
+  ASSERT_EQ(0, checkpoint.save("rule", 0, rgw_obj_key("a"), false));
+  ASSERT_EQ(0, checkpoint.remove());
+
+  LCCheckpoint reloaded(g_ceph_context, ioctx, bucket, 1);
+  ASSERT_EQ(0, reloaded.load());
+  EXPECT_EQ(nullptr, reloaded.get("rule", 0));
+}
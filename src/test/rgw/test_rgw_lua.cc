@@ -149,6 +149,71 @@ TEST(TestRGWLua, URI)
   ASSERT_EQ(rc, 0);
 }
 
+TEST(TestRGWLua, ReusedState)
+{
+  const std::string script = R"(
+    assert(Counter == nil)
+    Counter = 1
+    RGWDebugLog(Request.DecodedURI)
+  )";
+
+  DEFINE_REQ_STATE;
+  s.decoded_uri = "http://hello.world/";
+
+  obj_version version;
+  version.ver = 1;
+  version.tag = "tag";
+
+  // globals of one run are not seen by the next
+  for (auto i = 0; i < 3; ++i) {
+    const auto rc = lua::request::execute(nullptr, nullptr, nullptr, &s, "", script, "key", &version);
+    ASSERT_EQ(rc, 0);
+  }
+
+  // a new version is compiled again
+  ++version.ver;
+  auto rc = lua::request::execute(nullptr, nullptr, nullptr, &s, "", "kaboom(", "key", &version);
+  ASSERT_NE(rc, 0);
+  ++version.ver;
+  rc = lua::request::execute(nullptr, nullptr, nullptr, &s, "", script, "key", &version);
+  ASSERT_EQ(rc, 0);
+}
+
+TEST(TestRGWLua, ReusedStateKeptRequest)
+{
+  const std::string script = R"(
+    if Request.DecodedURI == "keep" then
+      string.response = Request.Response
+      string.iter = pairs(Request.Tags)
+      string.log = Request.Log
+    elseif Request.DecodedURI == "response" then
+      RGWDebugLog(string.response.Message)
+    elseif Request.DecodedURI == "iter" then
+      string.iter()
+    else
+      string.log()
+    end
+  )";
+
+  obj_version version;
+  version.ver = 1;
+  version.tag = "tag";
+
+  // what a run kept of its request fails in later runs of the same state
+  for (const auto uri : {"response", "iter", "log"}) {
+    {
+      DEFINE_REQ_STATE;
+      s.decoded_uri = "keep";
+      const auto rc = lua::request::execute(nullptr, nullptr, nullptr, &s, "", script, "key", &version);
+      ASSERT_EQ(rc, 0);
+    }
+    DEFINE_REQ_STATE;
+    s.decoded_uri = uri;
+    const auto rc = lua::request::execute(nullptr, nullptr, nullptr, &s, "", script, "key", &version);
+    ASSERT_NE(rc, 0);
+  }
+}
+
 TEST(TestRGWLua, Response)
 {
   const std::string script = R"(
@@ -0,0 +1,151 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+#include "gtest/gtest.h"
+
+#include "global/global_context.h"
+#include "rgw/rgw_multi.h"
+
+namespace {
+
+map<int, string> requested(int first, int last)
+{
+  map<int, string> parts;
+  for (int num = first; num <= last; ++num) {
+    parts[num] = "etag" + std::to_string(num);
+  }
+  return parts;
+}
+
+string part_key(uint32_t num)
+{
+  char buf[32];
+  snprintf(buf, sizeof(buf), "part.%08d", num);
+  return buf;
+}
+
+/* the omap of an upload with the given parts, split into the pages that
+ * read_multipart_parts() reads */
+vector<map<string, bufferlist>> read_pages(const vector<uint32_t>& nums,
+					   const vector<RGWMultipartPartsPage>& pages)
+{
+  map<string, bufferlist> omap;
+  for (auto num : nums) {
+    RGWUploadPartInfo info;
+    info.num = num;
+    info.size = 4096;
+    info.etag = "etag" + std::to_string(num);
+    encode(info, omap[part_key(num)]);
+  }
+
+  vector<map<string, bufferlist>> vals;
+  for (auto& page : pages) {
+    auto& v = vals.emplace_back();
+    for (auto i = omap.upper_bound(page.start_after);
+	 i != omap.end() && (int)v.size() < page.max_entries; ++i) {
+      v.insert(*i);
+    }
+  }
+  return vals;
+}
+
+} // anonymous namespace
+
+TEST(MultipartParts, pages)
+{
+  vector<RGWMultipartPartsPage> pages;
+  get_multipart_parts_pages(map<int, string>{}, 1000, pages);
+  EXPECT_TRUE(pages.empty());
+
+  get_multipart_parts_pages(requested(1, 3), 1000, pages);
+  ASSERT_EQ(1u, pages.size());
+  EXPECT_EQ(part_key(0), pages[0].start_after);
+  EXPECT_EQ(4, pages[0].max_entries);
+
+  // each page starts after the last part of the one before it, so that
+  // they can be read at once
+  get_multipart_parts_pages(requested(1, 25), 10, pages);
+  ASSERT_EQ(3u, pages.size());
+  EXPECT_EQ(part_key(0), pages[0].start_after);
+  EXPECT_EQ(10, pages[0].max_entries);
+  EXPECT_EQ(part_key(10), pages[1].start_after);
+  EXPECT_EQ(10, pages[1].max_entries);
+  EXPECT_EQ(part_key(20), pages[2].start_after);
+  EXPECT_EQ(6, pages[2].max_entries);
+
+  // part numbers needn't be contiguous
+  auto parts = requested(1, 2);
+  parts[7] = "etag7";
+  parts[9] = "etag9";
+  get_multipart_parts_pages(parts, 2, pages);
+  ASSERT_EQ(2u, pages.size());
+  EXPECT_EQ(part_key(2), pages[1].start_after);
+  EXPECT_EQ(3, pages[1].max_entries);
+}
+
+TEST(MultipartParts, decode)
+{
+  const auto expected = requested(1, 25);
+  vector<RGWMultipartPartsPage> pages;
+  get_multipart_parts_pages(expected, 10, pages);
+
+  vector<uint32_t> nums;
+  for (uint32_t num = 1; num <= 25; ++num) {
+    nums.push_back(num);
+  }
+  map<uint32_t, RGWUploadPartInfo> parts;
+  bool matched = false;
+  ASSERT_EQ(0, decode_multipart_parts(g_ceph_context, read_pages(nums, pages),
+				      expected, parts, &matched));
+  EXPECT_TRUE(matched);
+  ASSERT_EQ(25u, parts.size());
+  for (auto& [num, info] : parts) {
+    EXPECT_EQ(num, info.num);
+    EXPECT_EQ("etag" + std::to_string(num), info.etag);
+  }
+}
+
+TEST(MultipartParts, mismatch)
+{
+  const auto expected = requested(1, 25);
+  vector<RGWMultipartPartsPage> pages;
+  get_multipart_parts_pages(expected, 10, pages);
+  map<uint32_t, RGWUploadPartInfo> parts;
+  bool matched = true;
+
+  // a part the client asked for is missing
+  vector<uint32_t> missing;
+  for (uint32_t num = 1; num <= 25; ++num) {
+    if (num != 15) {
+      missing.push_back(num);
+    }
+  }
+  ASSERT_EQ(0, decode_multipart_parts(g_ceph_context, read_pages(missing, pages),
+				      expected, parts, &matched));
+  EXPECT_FALSE(matched);
+  EXPECT_TRUE(parts.empty());
+
+  // a part the client didn't ask for, caught by the last page
+  vector<uint32_t> extra;
+  for (uint32_t num = 1; num <= 26; ++num) {
+    extra.push_back(num);
+  }
+  matched = true;
+  ASSERT_EQ(0, decode_multipart_parts(g_ceph_context, read_pages(extra, pages),
+				      expected, parts, &matched));
+  EXPECT_FALSE(matched);
+
+  // a part that can't be decoded
+  vector<map<string, bufferlist>> vals(1);
+  vals[0][part_key(1)].append("garbage");
+  EXPECT_EQ(-EIO, decode_multipart_parts(g_ceph_context, vals, requested(1, 1),
+					 parts, &matched));
+}
+
+TEST(MultipartParts, legacy_upload_id)
+{
+  // uploads whose ids predate the v2 ones don't sort their parts in the
+  // omap, so read_multipart_parts() reads it whole instead of in pages
+  EXPECT_TRUE(is_v2_upload_id(MULTIPART_UPLOAD_ID_PREFIX "abc"));
+  EXPECT_TRUE(is_v2_upload_id(MULTIPART_UPLOAD_ID_PREFIX_LEGACY "abc"));
+  EXPECT_FALSE(is_v2_upload_id("abc"));
+}
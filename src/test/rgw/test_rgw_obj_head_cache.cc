@@ -0,0 +1,125 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+#include "rgw/rgw_obj_head_cache.h"
+#include "rgw/rgw_cache.h"
+#include "global/global_context.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+struct ObjHeadCache : ::testing::Test {
+  RGWSI_Notify notify{g_ceph_context};
+  std::unique_ptr<RGWObjHeadCache> cache;
+
+  void SetUp() override {
+    g_ceph_context->_conf.set_val_or_die("rgw_obj_head_cache_size", "4");
+    g_ceph_context->_conf.set_val_or_die("rgw_obj_head_cache_shards", "1");
+    cache = std::make_unique<RGWObjHeadCache>(g_ceph_context, &notify);
+    cache->set_enabled(true);
+  }
+};
+
+rgw_raw_obj make_obj(const std::string& oid)
+{
+  return rgw_raw_obj(rgw_pool("default.rgw.buckets.data"), oid);
+}
+
+RGWObjHeadCacheEntry make_head(uint64_t size)
+{
+  RGWObjHeadCacheEntry head;
+  head.size = size;
+  head.attrs[RGW_ATTR_ETAG].append("etag");
+  return head;
+}
+
+} // anonymous namespace
+
+TEST_F(ObjHeadCache, PutFind)
+{
+  const auto key = RGWObjHeadCache::get_key(make_obj("obj"));
+  RGWObjHeadCacheEntry head;
+  EXPECT_FALSE(cache->find(key, head));
+
+  cache->put(key, cache->get_gen(key), make_head(42));
+  ASSERT_TRUE(cache->find(key, head));
+  EXPECT_EQ(42u, head.size);
+  EXPECT_EQ(1u, head.attrs.count(RGW_ATTR_ETAG));
+  // the entry has no data, which readers fetch from rados
+  EXPECT_FALSE(head.has_data);
+}
+
+TEST_F(ObjHeadCache, Data)
+{
+  const auto key = RGWObjHeadCache::get_key(make_obj("obj"));
+  auto head = make_head(4);
+  head.has_data = true;
+  head.data.append("data");
+  cache->put(key, cache->get_gen(key), head);
+
+  RGWObjHeadCacheEntry out;
+  ASSERT_TRUE(cache->find(key, out));
+  EXPECT_TRUE(out.has_data);
+  EXPECT_EQ("data", out.data.to_str());
+}
+
+TEST_F(ObjHeadCache, RacedInvalidation)
+{
+  const auto obj = make_obj("obj");
+  const auto key = RGWObjHeadCache::get_key(obj);
+  const auto gen = cache->get_gen(key);
+
+  // a write completes while the head is being read
+  bufferlist bl;
+  RGWCacheNotifyInfo info;
+  info.op = REMOVE_OBJ;
+  info.obj = obj;
+  encode(info, bl);
+  cache->watch_cb(0, 0, 0, bl);
+
+  cache->put(key, gen, make_head(1));
+  RGWObjHeadCacheEntry head;
+  EXPECT_FALSE(cache->find(key, head));
+}
+
+TEST_F(ObjHeadCache, Notify)
+{
+  const auto obj = make_obj("obj");
+  const auto key = RGWObjHeadCache::get_key(obj);
+  cache->put(key, cache->get_gen(key), make_head(1));
+
+  bufferlist bl;
+  RGWCacheNotifyInfo info;
+  info.op = REMOVE_OBJ;
+  info.obj = obj;
+  encode(info, bl);
+  EXPECT_EQ(0, cache->watch_cb(0, 0, 0, bl));
+
+  RGWObjHeadCacheEntry head;
+  EXPECT_FALSE(cache->find(key, head));
+}
+
+TEST_F(ObjHeadCache, Evict)
+{
+  for (int i = 0; i < 5; ++i) {
+    const auto key = RGWObjHeadCache::get_key(make_obj(std::to_string(i)));
+    cache->put(key, cache->get_gen(key), make_head(i));
+  }
+
+  RGWObjHeadCacheEntry head;
+  EXPECT_FALSE(cache->find(RGWObjHeadCache::get_key(make_obj("0")), head));
+  EXPECT_TRUE(cache->find(RGWObjHeadCache::get_key(make_obj("4")), head));
+}
+
+TEST_F(ObjHeadCache, Disabled)
+{
+  const auto key = RGWObjHeadCache::get_key(make_obj("obj"));
+  cache->put(key, cache->get_gen(key), make_head(1));
+
+  // a broken watch disables and flushes the cache
+  cache->set_enabled(false);
+  RGWObjHeadCacheEntry head;
+  EXPECT_FALSE(cache->find(key, head));
+  cache->set_enabled(true);
+  EXPECT_FALSE(cache->find(key, head));
+}
@@ -13,6 +13,9 @@
  */
 
 #include "rgw/rgw_putobj.h"
+#include <future>
+#include <boost/asio/post.hpp>
+#include "global/global_context.h"
 #include <gtest/gtest.h>
 
 inline bufferlist string_buf(const char* buf) {
@@ -194,3 +197,49 @@ TEST(PutObj_Stripe, SkipFirstChunk)
   ASSERT_EQ(4u, mock.ops.size());
   EXPECT_EQ(Op({"", 4}), mock.ops[3]); // flush
 }
+
+TEST(PutObj_OrderedOffload, Yield)
+{
+  g_ceph_context->_conf.set_val_or_die("rgw_put_obj_offload_threads", "2");
+
+  boost::asio::io_context context;
+  std::promise<void> released;
+  std::shared_future<void> release = released.get_future().share();
+  std::vector<uint64_t> emitted;
+  int result = -1;
+
+  spawn::spawn(context, [&] (spawn::yield_context yield) {
+      rgw::putobj::OrderedOffload offload(g_ceph_context,
+          [release] (bufferlist& in, uint64_t, bufferlist& out) {
+            // finishes once the io thread has run the handler below
+            if (release.wait_for(std::chrono::seconds(10)) !=
+                std::future_status::ready) {
+              return -ETIMEDOUT;
+            }
+            out = in;
+            return 0;
+          },
+          [&emitted] (int r, bufferlist&& out, uint64_t offset) {
+            if (r < 0) {
+              return r;
+            }
+            emitted.push_back(offset);
+            return 0;
+          },
+          optional_yield{context, yield});
+      for (uint64_t offset = 0; offset < 8; ++offset) {
+        result = offload.submit(string_buf("x"), offset);
+        if (result < 0) {
+          return;
+        }
+      }
+      result = offload.drain();
+    });
+  // runs only if waiting for the full window doesn't block the thread
+  boost::asio::post(context, [&released] { released.set_value(); });
+  context.run();
+
+  EXPECT_EQ(0, result);
+  EXPECT_EQ((std::vector<uint64_t>{0, 1, 2, 3, 4, 5, 6, 7}), emitted);
+  g_ceph_context->_conf.set_val_or_die("rgw_put_obj_offload_threads", "0");
+}
@@ -0,0 +1,151 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include "rgw/rgw_select_scan_range.h"
+#include <algorithm>
+#include <string>
+#include <gtest/gtest.h>
+
+namespace {
+
+// records start at 0, 4, 8 and 12
+const std::string obj = "aaa\nbbb\nccc\nddd\n";
+
+/* the bytes of obj that a select with the given ScanRange queries, with
+ * the object read in chunks of chunk_size */
+std::string scan(const std::string& scan_range, size_t chunk_size)
+{
+  RGWSelectScanRange range;
+  EXPECT_EQ(0, range.parse(scan_range));
+
+  // read the range like a GET of the Range header would
+  const std::string& range_str = range.get_range_str();
+  EXPECT_EQ(0u, range_str.find("bytes="));
+  const auto spec = range_str.substr(6);
+  const auto dash = spec.find('-');
+  uint64_t ofs, end = obj.size() - 1;
+  if (dash == 0) {
+    const uint64_t len = std::stoull(spec.substr(1));
+    ofs = len < obj.size() ? obj.size() - len : 0;
+  } else {
+    ofs = std::stoull(spec.substr(0, dash));
+    if (dash + 1 < spec.size()) {
+      end = std::min<uint64_t>(end, std::stoull(spec.substr(dash + 1)));
+    }
+  }
+
+  std::string out;
+  range.start_read(ofs, obj.size());
+  for (uint64_t p = ofs; p <= end; p += chunk_size) {
+    const char* begin = obj.data() + p;
+    const char* stop = obj.data() + std::min<uint64_t>(p + chunk_size, end + 1);
+    if (range.scan(&begin, &stop, '\n')) {
+      out.append(begin, stop - begin);
+    }
+  }
+  return out;
+}
+
+const size_t chunk_sizes[] = {1, 3, 5, 64};
+
+} // anonymous namespace
+
+TEST(RGWSelectScanRange, start)
+{
+  for (auto chunk : chunk_sizes) {
+    SCOPED_TRACE(chunk);
+    EXPECT_EQ(obj, scan("<Start>0</Start>", chunk));
+    EXPECT_EQ("bbb\nccc\nddd\n", scan("<Start>1</Start>", chunk));
+    EXPECT_EQ("bbb\nccc\nddd\n", scan("<Start>4</Start>", chunk));
+    EXPECT_EQ("ccc\nddd\n", scan("<Start>5</Start>", chunk));
+    EXPECT_EQ("ddd\n", scan("<Start>12</Start>", chunk));
+    EXPECT_EQ("", scan("<Start>13</Start>", chunk));
+  }
+}
+
+TEST(RGWSelectScanRange, end)
+{
+  for (auto chunk : chunk_sizes) {
+    SCOPED_TRACE(chunk);
+    // the records that begin in the last End bytes, up to the end of the
+    // object
+    EXPECT_EQ("ddd\n", scan("<End>4</End>", chunk));
+    EXPECT_EQ("ddd\n", scan("<End>5</End>", chunk));
+    EXPECT_EQ("ccc\nddd\n", scan("<End>8</End>", chunk));
+    EXPECT_EQ("ccc\nddd\n", scan("<End>9</End>", chunk));
+    EXPECT_EQ("bbb\nccc\nddd\n", scan("<End>15</End>", chunk));
+    EXPECT_EQ(obj, scan("<End>16</End>", chunk));
+    EXPECT_EQ(obj, scan("<End>100</End>", chunk));
+  }
+}
+
+TEST(RGWSelectScanRange, start_end)
+{
+  for (auto chunk : chunk_sizes) {
+    SCOPED_TRACE(chunk);
+    EXPECT_EQ("aaa\n", scan("<Start>0</Start><End>0</End>", chunk));
+    EXPECT_EQ("bbb\n", scan("<Start>4</Start><End>7</End>", chunk));
+    EXPECT_EQ("bbb\nccc\n", scan("<Start>4</Start><End>8</End>", chunk));
+    EXPECT_EQ("ccc\nddd\n", scan("<Start>5</Start><End>12</End>", chunk));
+    EXPECT_EQ(obj, scan("<Start>0</Start><End>100</End>", chunk));
+    // no record begins within the range
+    EXPECT_EQ("", scan("<Start>5</Start><End>7</End>", chunk));
+  }
+}
+
+TEST(RGWSelectScanRange, first_record)
+{
+  // FileHeaderInfo only applies to ranges with the first record
+  auto skips_first = [] (const std::string& scan_range, uint64_t ofs) {
+    RGWSelectScanRange range;
+    EXPECT_EQ(0, range.parse(scan_range));
+    range.start_read(ofs, obj.size());
+    return range.skips_first_record();
+  };
+  EXPECT_FALSE(skips_first("", 0));
+  EXPECT_FALSE(skips_first("<Start>0</Start>", 0));
+  EXPECT_FALSE(skips_first("<Start>0</Start><End>5</End>", 0));
+  EXPECT_TRUE(skips_first("<Start>1</Start>", 0));
+  EXPECT_TRUE(skips_first("<Start>8</Start><End>12</End>", 7));
+  EXPECT_FALSE(skips_first("<End>16</End>", 0));
+  EXPECT_FALSE(skips_first("<End>100</End>", 0));
+  EXPECT_TRUE(skips_first("<End>15</End>", 0));
+  EXPECT_TRUE(skips_first("<End>4</End>", 11));
+
+  EXPECT_FALSE(RGWSelectScanRange().may_skip_first_record());
+  RGWSelectScanRange range;
+  ASSERT_EQ(0, range.parse("<Start>0</Start><End>5</End>"));
+  EXPECT_FALSE(range.may_skip_first_record());
+  ASSERT_EQ(0, range.parse("<End>5</End>"));
+  EXPECT_TRUE(range.may_skip_first_record());
+}
+
+TEST(RGWSelectScanRange, parse)
+{
+  {
+    RGWSelectScanRange range;
+    EXPECT_EQ(0, range.parse("<Start>10</Start><End>20</End>"));
+    EXPECT_EQ("bytes=9-" + std::to_string(20 + RGWSelectScanRange::READ_AHEAD),
+              range.get_range_str());
+  }
+  {
+    RGWSelectScanRange range;
+    EXPECT_EQ(0, range.parse("<Start>10</Start>"));
+    EXPECT_EQ("bytes=9-", range.get_range_str());
+  }
+  {
+    RGWSelectScanRange range;
+    EXPECT_EQ(0, range.parse("<End>10</End>"));
+    EXPECT_EQ("bytes=-11", range.get_range_str());
+  }
+  {
+    RGWSelectScanRange range;
+    EXPECT_EQ(0, range.parse(""));
+    EXPECT_TRUE(range.empty());
+  }
+  EXPECT_EQ(-EINVAL, RGWSelectScanRange().parse("<Start>20</Start><End>10</End>"));
+  EXPECT_EQ(-EINVAL, RGWSelectScanRange().parse("<End>0</End>"));
+  EXPECT_EQ(-EINVAL, RGWSelectScanRange().parse("<Start>-1</Start>"));
+  EXPECT_EQ(-EINVAL, RGWSelectScanRange().parse("<Start>x</Start>"));
+  EXPECT_EQ(-EINVAL, RGWSelectScanRange().parse("<Start>1"));
+}
@@ -214,4 +214,72 @@ TEST_F(Aio_Throttle, YieldingThrottleOverMax)
   EXPECT_EQ(window, max_outstanding);
 }
 
+TEST(ReadWindow, GrowForFastClient)
+{
+  using namespace std::chrono_literals;
+  WindowBudget budget;
+  {
+    ReadWindow window(budget, 4, 16, 0);
+    EXPECT_EQ(4u, window.get());
+    EXPECT_EQ(4u, budget.get_used());
+
+    // waiting on reads, the client takes no time
+    window.add_wait(10ms);
+    window.add_sent(4, 1ms);
+    EXPECT_EQ(8u, window.get());
+    window.add_wait(10ms);
+    window.add_sent(8, 1ms);
+    EXPECT_EQ(16u, window.get());
+    window.add_wait(10ms);
+    window.add_sent(16, 1ms);
+    EXPECT_EQ(16u, window.get()); // capped at max
+    EXPECT_EQ(2u, window.grows);
+    EXPECT_EQ(16u, window.peak);
+    EXPECT_EQ(16u, budget.get_used());
+  }
+  EXPECT_EQ(0u, budget.get_used());
+}
+
+TEST(ReadWindow, ShrinkForSlowClient)
+{
+  using namespace std::chrono_literals;
+  WindowBudget budget;
+  ReadWindow window(budget, 4, 16, 0);
+  window.add_wait(10ms);
+  window.add_sent(4, 1ms);
+  ASSERT_EQ(8u, window.get());
+
+  // a window's worth has to be sent before it's reconsidered
+  window.add_sent(4, 100ms);
+  EXPECT_EQ(8u, window.get());
+  window.add_sent(4, 100ms);
+  EXPECT_EQ(4u, window.get());
+  window.add_sent(4, 100ms);
+  EXPECT_EQ(4u, window.get()); // not below min
+  EXPECT_EQ(1u, window.shrinks);
+  EXPECT_EQ(4u, budget.get_used());
+}
+
+TEST(ReadWindow, Budget)
+{
+  using namespace std::chrono_literals;
+  WindowBudget budget;
+  ReadWindow window1(budget, 4, 16, 12);
+  ReadWindow window2(budget, 4, 16, 12);
+  window1.add_wait(10ms);
+  window1.add_sent(4, 1ms);
+  EXPECT_EQ(8u, window1.get());
+
+  // the total would go past 12
+  window2.add_wait(10ms);
+  window2.add_sent(4, 1ms);
+  EXPECT_EQ(4u, window2.get());
+  EXPECT_EQ(1u, window2.capped);
+
+  // the minimum window is always granted
+  ReadWindow window3(budget, 4, 16, 12);
+  EXPECT_EQ(4u, window3.get());
+  EXPECT_EQ(16u, budget.get_used());
+}
+
 } // namespace rgw